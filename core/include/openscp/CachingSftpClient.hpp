@@ -0,0 +1,167 @@
+// SftpClient decorator that caches directory listings and stats.
+// Listings are served from memory while fresh, then revalidated with a single stat of
+// the directory (unchanged mtime => reuse). Every mutating call invalidates the affected
+// paths (write-through), so browsing back/up is instant without going stale.
+#pragma once
+#include "SftpClient.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openscp {
+
+struct ListingCacheOptions {
+    std::chrono::milliseconds freshFor{3000};       // served without asking the server
+    std::chrono::milliseconds revalidateFor{300000}; // reused after an unchanged-mtime check
+    std::size_t maxDirs = 64;                        // cached listings (oldest evicted first)
+    std::size_t maxBytes = 64u << 20;                // memory budget for cached listings
+};
+
+class CachingSftpClient : public SftpClient {
+public:
+    explicit CachingSftpClient(std::unique_ptr<SftpClient> inner,
+                               ListingCacheOptions opt = ListingCacheOptions{});
+    ~CachingSftpClient() override;
+
+    // Wrapped client (e.g., to reach backend-specific API)
+    SftpClient* inner() const { return inner_.get(); }
+    // Drop everything cached (or one path, its parent listing and its subtree)
+    void invalidateAll();
+    void invalidate(const std::string& remote_path);
+    // Cached listing of "remote_path" as is (possibly stale), without asking the server.
+    // Lets a view render immediately while a regular list call revalidates it.
+    bool peekListing(const std::string& remote_path, DirListing& out) const;
+    // True if a listing that can still be reused (fresh or revalidatable) is cached
+    bool hasListing(const std::string& remote_path) const;
+    // Memory held by cached listings (compare with ListingCacheOptions::maxBytes)
+    std::size_t cachedBytes() const;
+    const ListingCacheOptions& options() const;
+
+    bool connect(const SessionOptions& opt, std::string& err) override;
+    void disconnect() override;
+    bool isConnected() const override { return inner_->isConnected(); }
+    bool transportLost() const override { return inner_->transportLost(); }
+
+    bool list(const std::string& remote_path,
+              std::vector<FileInfo>& out,
+              std::string& err) override;
+    bool listStream(const std::string& remote_path,
+                    const ListBatchCB& onBatch,
+                    std::string& err,
+                    std::size_t batchSize = 512) override;
+    bool listCompact(const std::string& remote_path,
+                     DirListing& out,
+                     std::string& err) override;
+
+    bool get(const std::string& remote,
+             const std::string& local,
+             std::string& err,
+             std::function<void(std::size_t, std::size_t)> progress,
+             std::function<bool()> shouldCancel,
+             bool resume) override;
+    bool put(const std::string& local,
+             const std::string& remote,
+             std::string& err,
+             std::function<void(std::size_t, std::size_t)> progress,
+             std::function<bool()> shouldCancel,
+             bool resume) override;
+
+    bool exists(const std::string& remote_path,
+                bool& isDir,
+                std::string& err) override;
+    bool stat(const std::string& remote_path,
+              FileInfo& info,
+              std::string& err) override;
+    bool chmod(const std::string& remote_path,
+               std::uint32_t mode,
+               std::string& err) override;
+    bool chown(const std::string& remote_path,
+               std::uint32_t uid,
+               std::uint32_t gid,
+               std::string& err) override;
+    bool setTimes(const std::string& remote_path,
+                  std::uint64_t atime,
+                  std::uint64_t mtime,
+                  std::string& err) override;
+    bool mkdir(const std::string& remote_dir,
+               std::string& err,
+               unsigned int mode = 0755) override;
+    bool removeFile(const std::string& remote_path,
+                    std::string& err) override;
+    bool removeDir(const std::string& remote_dir,
+                   std::string& err) override;
+    bool rename(const std::string& from,
+                const std::string& to,
+                std::string& err,
+                bool overwrite = false) override;
+
+    bool remoteIdentity(RemoteIdentity& out, std::string& err) override { return inner_->remoteIdentity(out, err); }
+    bool execTreeAvailable() override { return inner_->execTreeAvailable(); }
+    bool getTree(const std::string& remote_dir,
+                 const std::string& local_dir,
+                 std::string& err,
+                 std::function<void(std::size_t, std::size_t)> progress,
+                 TreeFileErrorCB fileError,
+                 std::function<bool()> shouldCancel) override;
+    bool putTree(const std::string& local_dir,
+                 const std::string& remote_dir,
+                 std::string& err,
+                 std::function<void(std::size_t, std::size_t)> progress,
+                 TreeFileErrorCB fileError,
+                 std::function<bool()> shouldCancel) override;
+
+    bool putMany(const std::vector<TransferPair>& items,
+                 std::string& err,
+                 ItemDoneCB onItemDone,
+                 ItemProgressCB progress,
+                 std::function<bool(std::size_t)> shouldCancel) override;
+    bool getMany(const std::vector<TransferPair>& items,
+                 std::string& err,
+                 ItemDoneCB onItemDone,
+                 ItemProgressCB progress,
+                 std::function<bool(std::size_t)> shouldCancel) override;
+
+    bool statMany(const std::vector<std::string>& paths,
+                  std::vector<StatResult>& out,
+                  std::string& err) override;
+    bool mkdirMany(const std::vector<std::string>& dirs,
+                   std::vector<std::string>& errors,
+                   std::string& err,
+                   unsigned int mode = 0755) override;
+    bool chmodMany(const std::vector<std::string>& paths,
+                   std::uint32_t mode,
+                   std::vector<std::string>& errors,
+                   std::string& err) override;
+    bool chownMany(const std::vector<std::string>& paths,
+                   std::uint32_t uid,
+                   std::uint32_t gid,
+                   std::vector<std::string>& errors,
+                   std::string& err) override;
+    bool removeMany(const std::vector<std::string>& files,
+                    std::vector<std::string>& errors,
+                    std::string& err) override;
+    bool rmdirMany(const std::vector<std::string>& dirs,
+                   std::vector<std::string>& errors,
+                   std::string& err) override;
+
+    // The new connection is wrapped too and shares this cache (same server)
+    std::unique_ptr<SftpClient> newConnectionLike(const SessionOptions& opt,
+                                                  std::string& err) override;
+
+private:
+    struct Cache;
+    CachingSftpClient(std::unique_ptr<SftpClient> inner, std::shared_ptr<Cache> cache);
+
+    std::unique_ptr<SftpClient> inner_;
+    std::shared_ptr<Cache> cache_;
+
+    // Fill "out" from the cache or the server
+    bool cachedListing(const std::string& path, DirListing& out, std::string& err);
+    // Remember a complete listing ("st" is the directory stat taken before listing)
+    void storeListing(const std::string& path, const DirListing& listing, const FileInfo& st, bool haveStat);
+    // Drop path, its parent listing and (optionally) everything below it
+    void invalidatePath(const std::string& path, bool subtree);
+};
+
+} // namespace openscp
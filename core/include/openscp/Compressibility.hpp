@@ -0,0 +1,23 @@
+// Cheap compressibility estimation used to decide whether a transfer benefits
+// from SSH transport compression.
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace openscp {
+
+// Shannon entropy of a byte buffer in bits per byte (0..8).
+double byteEntropy(const unsigned char* data, std::size_t len);
+
+// True if the file name has an extension of an already-compressed format
+// (archives, images, audio/video, office containers).
+bool hasCompressedExtension(const std::string& name);
+
+// Sample the first blocks of a local file and decide whether it is worth compressing.
+// Returns false for small files, unreadable files and high-entropy content.
+bool localFileLooksCompressible(const std::string& path);
+
+// Name-only heuristic for files that cannot be sampled locally (downloads).
+bool remoteNameLooksCompressible(const std::string& name);
+
+} // namespace openscp
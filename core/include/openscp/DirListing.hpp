@@ -0,0 +1,61 @@
+// Compact directory listing: attributes in parallel arrays and every name in one
+// contiguous UTF-8 arena. Avoids a heap string per entry for very large directories.
+#pragma once
+#include "SftpTypes.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openscp {
+
+class DirListing {
+public:
+    std::size_t size() const { return nameOff_.size(); }
+    bool empty() const { return nameOff_.empty(); }
+    void clear();
+    // Pre-size for n entries and (optionally) nameBytes bytes of names.
+    void reserve(std::size_t n, std::size_t nameBytes = 0);
+    // Release spare capacity once the listing is complete.
+    void shrinkToFit();
+
+    void push(std::string_view name, bool isDir, bool hasSize, std::uint64_t size,
+              std::uint64_t mtime, std::uint32_t mode, std::uint32_t uid, std::uint32_t gid);
+    void push(const FileInfo& fi) {
+        push(fi.name, fi.is_dir, fi.has_size, fi.size, fi.mtime, fi.mode, fi.uid, fi.gid);
+    }
+
+    // Name bytes (UTF-8) of entry i; valid until the listing is modified.
+    std::string_view name(std::size_t i) const {
+        return std::string_view(names_.data() + nameOff_[i], nameLen_[i]);
+    }
+    bool isDir(std::size_t i) const { return (flags_[i] & kDir) != 0; }
+    bool hasSize(std::size_t i) const { return (flags_[i] & kHasSize) != 0; }
+    std::uint64_t fileSize(std::size_t i) const { return size_[i]; }
+    std::uint64_t mtime(std::size_t i) const { return mtime_[i]; }
+    std::uint32_t mode(std::size_t i) const { return mode_[i]; }
+    std::uint32_t uid(std::size_t i) const { return uid_[i]; }
+    std::uint32_t gid(std::size_t i) const { return gid_[i]; }
+    bool isSymlink(std::size_t i) const { return (mode_[i] & 0170000u) == 0120000u; }
+
+    // Materialize one entry (allocates the name).
+    FileInfo at(std::size_t i) const;
+
+    // Approximate heap footprint in bytes.
+    std::size_t memoryBytes() const;
+
+private:
+    enum : std::uint8_t { kDir = 1, kHasSize = 2 };
+    std::string names_;                 // all names back to back (no separators)
+    std::vector<std::uint64_t> nameOff_;
+    std::vector<std::uint32_t> nameLen_;
+    std::vector<std::uint8_t>  flags_;
+    std::vector<std::uint64_t> size_;
+    std::vector<std::uint64_t> mtime_;
+    std::vector<std::uint32_t> mode_;
+    std::vector<std::uint32_t> uid_;
+    std::vector<std::uint32_t> gid_;
+};
+
+} // namespace openscp
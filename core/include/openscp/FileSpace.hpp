@@ -0,0 +1,11 @@
+// Disk space helpers shared by the memory-mapped files (spill queue, journal).
+#pragma once
+#include <cstdint>
+
+namespace openscp {
+
+// Grow the file behind fd to at least "bytes" and, where the platform allows,
+// allocate its blocks up front. Returns 0 or an errno value. POSIX only.
+int reserveFileSpace(int fd, std::uint64_t bytes);
+
+} // namespace openscp
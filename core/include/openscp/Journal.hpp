@@ -0,0 +1,52 @@
+// Append-only record log in a memory-mapped file, for state that must survive a crash.
+// Each record is a u32 length, a CRC-32 of the payload and the payload; a torn or corrupt
+// tail (the process died while appending) simply ends the log when it is opened again.
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace openscp {
+
+// Not thread-safe: one owner appends, flushes and compacts.
+class Journal {
+public:
+    Journal() = default;
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Open "file" (created if missing) and hand every valid record to replay, oldest
+    // first. Fails if the file exists but is not a journal.
+    bool open(const std::string& file, const std::function<void(std::string_view)>& replay, std::string& err);
+    bool isOpen() const { return fd_ >= 0 || file_; }
+    void close();
+
+    bool append(std::string_view rec, std::string& err);
+    // Start writing back what was appended since the last flush; with wait, return once
+    // it is on disk. Records already survive a crash of the process without it.
+    void flush(bool wait = false);
+    // Replace the log with the records produce() emits (written to a temporary file,
+    // then renamed over the journal). emit returns false once writing failed.
+    using Emit = std::function<bool(std::string_view)>;
+    bool compact(const std::function<void(const Emit&)>& produce, std::string& err);
+
+    std::uint64_t records() const { return records_; }
+    std::uint64_t bytes() const { return used_; }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    char* base_ = nullptr;           // mapping (nullptr where files are used directly)
+    std::size_t cap_ = 0;            // mapped size
+    std::size_t used_ = 0;           // end of the last valid record
+    std::size_t flushed_ = 0;        // written back up to here
+    std::uint64_t records_ = 0;
+    void* file_ = nullptr;           // std::FILE* on platforms without mmap
+
+    bool map(std::size_t cap, std::string& err);
+};
+
+} // namespace openscp
@@ -4,11 +4,13 @@
 #include "SftpClient.hpp"
 #include <string>
 #include <vector>
+#include <chrono>
 
 // Forward declarations of libssh2 internal types (with leading underscore)
 struct _LIBSSH2_SESSION;
 struct _LIBSSH2_SFTP;
 struct _LIBSSH2_SFTP_HANDLE;
+struct _LIBSSH2_SFTP_ATTRIBUTES;
 
 namespace openscp {
 
@@ -20,11 +22,21 @@ public:
     bool connect(const SessionOptions& opt, std::string& err) override;
     void disconnect() override;
     bool isConnected() const override { return connected_; }
+    bool transportLost() const override { return transportLost_; }
 
     bool list(const std::string& remote_path,
               std::vector<FileInfo>& out,
               std::string& err) override;
 
+    bool listStream(const std::string& remote_path,
+                    const ListBatchCB& onBatch,
+                    std::string& err,
+                    std::size_t batchSize = 512) override;
+
+    bool listCompact(const std::string& remote_path,
+                     DirListing& out,
+                     std::string& err) override;
+
     bool get(const std::string& remote,
              const std::string& local,
              std::string& err,
@@ -76,6 +88,64 @@ public:
                 std::string& err,
                 bool overwrite = false) override;
 
+    bool putMany(const std::vector<TransferPair>& items,
+                 std::string& err,
+                 ItemDoneCB onItemDone,
+                 ItemProgressCB progress,
+                 std::function<bool(std::size_t)> shouldCancel) override;
+
+    bool getMany(const std::vector<TransferPair>& items,
+                 std::string& err,
+                 ItemDoneCB onItemDone,
+                 ItemProgressCB progress,
+                 std::function<bool(std::size_t)> shouldCancel) override;
+
+    bool statMany(const std::vector<std::string>& paths,
+                  std::vector<StatResult>& out,
+                  std::string& err) override;
+
+    bool mkdirMany(const std::vector<std::string>& dirs,
+                   std::vector<std::string>& errors,
+                   std::string& err,
+                   unsigned int mode = 0755) override;
+
+    bool chmodMany(const std::vector<std::string>& paths,
+                   std::uint32_t mode,
+                   std::vector<std::string>& errors,
+                   std::string& err) override;
+
+    bool chownMany(const std::vector<std::string>& paths,
+                   std::uint32_t uid,
+                   std::uint32_t gid,
+                   std::vector<std::string>& errors,
+                   std::string& err) override;
+
+    bool removeMany(const std::vector<std::string>& files,
+                    std::vector<std::string>& errors,
+                    std::string& err) override;
+
+    bool rmdirMany(const std::vector<std::string>& dirs,
+                   std::vector<std::string>& errors,
+                   std::string& err) override;
+
+    bool remoteIdentity(RemoteIdentity& out, std::string& err) override;
+
+    bool execTreeAvailable() override;
+
+    bool getTree(const std::string& remote_dir,
+                 const std::string& local_dir,
+                 std::string& err,
+                 std::function<void(std::size_t, std::size_t)> progress,
+                 TreeFileErrorCB fileError,
+                 std::function<bool()> shouldCancel) override;
+
+    bool putTree(const std::string& local_dir,
+                 const std::string& remote_dir,
+                 std::string& err,
+                 std::function<void(std::size_t, std::size_t)> progress,
+                 TreeFileErrorCB fileError,
+                 std::function<bool()> shouldCancel) override;
+
     std::unique_ptr<SftpClient> newConnectionLike(const SessionOptions& opt,
                                                   std::string& err) override;
 
@@ -84,6 +154,49 @@ private:
     int  sock_ = -1;
     _LIBSSH2_SESSION* session_ = nullptr; // <- uses internal libssh2 types
     _LIBSSH2_SFTP*    sftp_    = nullptr; // <- same
+    // After a failed call: note whether the transport died (see transportLost())
+    bool transportLost_ = false;
+    void noteTransportFailure();
+
+    // SCP engine selection and per-server throughput samples (bytes/s, smoothed)
+    TransferEngine engine_ = TransferEngine::Sftp;
+    bool   scpUnavailable_ = false;
+    double sftpBps_ = 0.0;
+    double scpBps_  = 0.0;
+    bool preferScp(std::size_t size) const;
+    void noteThroughput(bool scp, std::size_t bytes, std::chrono::steady_clock::time_point start);
+
+    // exec+tar availability: -1 unknown, 0 no, 1 yes
+    int treeExec_ = -1;
+    // Login identity, resolved once per session
+    bool identityKnown_ = false;
+    RemoteIdentity identity_;
+
+    // Extra SFTP channels on the same session used by the pipelined multi-file engine
+    std::vector<_LIBSSH2_SFTP*> extraSftp_;
+    // Up to "want" channels (sftp_ first), opening extra ones on demand.
+    std::vector<_LIBSSH2_SFTP*> pipelineChannels(std::size_t want);
+    // Pipelined single-request metadata operations (see Libssh2BatchTransfer.cpp)
+    enum class MetaKind { Stat, SetStat, Mkdir, Unlink, Rmdir };
+    bool runMetaPipeline(MetaKind kind,
+                         const std::vector<std::string>& paths,
+                         const void* attrs,
+                         unsigned int mode,
+                         std::vector<StatResult>* stats,
+                         std::vector<std::string>* errors,
+                         std::string& err);
+    bool runPipeline(bool upload,
+                     const std::vector<TransferPair>& items,
+                     std::string& err,
+                     const ItemDoneCB& onItemDone,
+                     const ItemProgressCB& progress,
+                     const std::function<bool(std::size_t)>& shouldCancel);
+
+    // READDIR loop shared by the listing calls: onEntry gets the raw name bytes
+    // ("." and ".." already skipped) and returns false to stop early.
+    bool readDir(const std::string& remote_path,
+                 std::string& err,
+                 const std::function<bool(const char*, std::size_t, const _LIBSSH2_SFTP_ATTRIBUTES&)>& onEntry);
 
     // TCP connection + SSH handshake and authentication.
     bool tcpConnect(const std::string& host, uint16_t port, std::string& err);
@@ -0,0 +1,48 @@
+// Fast recursive scan of a local folder for uploads. On Linux entries come from
+// getdents64 (type from d_type, no stat per entry) and sizes from statx relative to the
+// open directory; other platforms use std::filesystem.
+#pragma once
+#include "PathRules.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace openscp {
+
+struct LocalTreeFile {
+    std::string path;        // full local path (native encoding)
+    std::string rel;         // relative to the scanned root, '/'-separated
+    std::uint64_t size = 0;  // bytes (0 unless LocalScanOptions::wantSize)
+    std::int64_t mtime = 0;  // seconds since epoch (0 unless LocalScanOptions::wantMtime)
+};
+
+struct LocalScanOptions {
+    bool wantSize = true;     // stat regular files for their size
+    bool wantMtime = false;   // and their modification time
+    bool skipHidden = false;  // skip dot entries (and their subtrees)
+    const PathRules* rules = nullptr; // excluded folders are not read
+    const std::atomic_bool* cancel = nullptr;
+};
+
+struct LocalScanStats {
+    std::uint64_t dirs = 0;        // folders read (root included)
+    std::uint64_t files = 0;       // files reported
+    std::uint64_t bytes = 0;       // sum of reported sizes
+    std::uint64_t errors = 0;      // folders or entries that could not be read
+    std::uint64_t excluded = 0;    // entries dropped by the rules
+};
+
+// Called for every regular file (symlinks to files count; symlinked folders are not
+// followed). Return false to stop the scan.
+using LocalFileCB = std::function<bool(const LocalTreeFile&)>;
+
+// Walk "root" depth-first. Unreadable entries are counted in stats and skipped.
+// Returns false if the root cannot be opened or the scan was cancelled/stopped (err set).
+bool scanLocalTree(const std::string& root,
+                   const LocalScanOptions& opt,
+                   const LocalFileCB& onFile,
+                   LocalScanStats& stats,
+                   std::string& err);
+
+} // namespace openscp
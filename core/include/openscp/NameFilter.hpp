@@ -0,0 +1,52 @@
+// Compiled file-name filter for type-ahead and glob filtering of directory listings.
+// Text containing glob metacharacters (* ? [...]) is a list of patterns separated by
+// spaces or ';' (any may match); plain text is a substring search.
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openscp {
+
+// Matching is byte-wise: callers that want case-insensitive filtering pass names and
+// filter text that were case-folded the same way.
+class NameFilter {
+public:
+    NameFilter() = default;
+    explicit NameFilter(std::string_view text);
+
+    bool empty() const { return globs_.empty() && needle_.empty(); }
+    bool isGlob() const { return !globs_.empty(); }
+    bool matches(std::string_view name) const;
+    // True if everything this filter accepts is also accepted by "prev"
+    // (typing more characters only narrows: the previous result can be filtered again).
+    bool narrows(const NameFilter& prev) const;
+
+private:
+    struct Glob {
+        enum class Op : std::uint8_t { Lit, AnyChar, Star, Set };
+        struct Tok {
+            Op op;
+            std::uint32_t a = 0; // Lit: offset in lits; Set: index in sets
+            std::uint32_t b = 0; // Lit: length
+        };
+        // Shapes with a direct test instead of the general matcher
+        enum class Shape : std::uint8_t { General, Exact, Prefix, Suffix, Contains };
+        std::vector<Tok> toks;
+        std::string lits;
+        std::vector<std::bitset<256>> sets;
+        Shape shape = Shape::General;
+        std::string fixed;       // literal for the direct shapes
+        std::size_t minLen = 0;  // bytes any match needs (quick reject)
+        bool matches(std::string_view s) const;
+    };
+    static Glob compile(std::string_view pattern);
+
+    std::vector<Glob> globs_;
+    std::string needle_; // substring mode
+};
+
+} // namespace openscp
@@ -0,0 +1,47 @@
+// Include/exclude rules for folder transfers in .gitignore syntax, compiled once and
+// checked for every entry while a tree is enumerated (excluded folders are never listed).
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace openscp {
+
+// One rule per line:
+//  - '#' starts a comment, blank lines are ignored, '\' escapes a special character
+//  - '!' re-includes what an earlier rule excluded (the last matching rule wins)
+//  - a trailing '/' matches folders only
+//  - a '/' at the start or in the middle anchors the rule to the transfer root;
+//    otherwise it matches the name at any depth
+//  - '*' and '?' do not cross '/', "**" does; [abc], [a-z], [!x] classes
+class PathRules {
+public:
+    PathRules() = default;
+    explicit PathRules(std::string_view text) { add(text); }
+
+    // Append the rules in "text" (they take precedence over the ones already added)
+    void add(std::string_view text);
+    bool empty() const { return rules_.empty(); }
+    std::size_t size() const { return rules_.size(); }
+    // True if "rel" (relative to the transfer root, '/'-separated, no leading '/') is excluded
+    bool excluded(std::string_view rel, bool isDir) const;
+
+private:
+    struct Rule {
+        std::string pattern;   // without '!', the anchoring '/' and the trailing '/'
+        bool negate = false;
+        bool dirOnly = false;
+        bool anchored = false; // matched against the whole relative path
+    };
+    std::vector<Rule> rules_;
+    // Rules without wildcards resolve with one hash lookup: by name (any depth) or by
+    // exact relative path (anchored). Enumeration checks every level on the way down, so
+    // an anchored "a/b" also prunes everything below it.
+    std::unordered_map<std::string, std::vector<std::uint32_t>> byName_;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> byPath_;
+    std::vector<std::uint32_t> globs_; // wildcard rules, in rule order
+};
+
+} // namespace openscp
@@ -0,0 +1,68 @@
+// Interned path storage for large transfer batches: folders are nodes (parent + name)
+// shared by every path below them, files are a folder node plus a leaf name.
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace openscp {
+
+// Handle to a file path in a PathStore (only meaningful to the store that issued it)
+struct PathRef {
+    std::uint32_t dir = UINT32_MAX; // folder node (UINT32_MAX: no path)
+    std::uint32_t leafLen = 0;
+    std::uint64_t leafOff = 0;      // leaf name in the store's name arena
+    bool empty() const { return dir == UINT32_MAX; }
+};
+
+// Paths are split at '/' and stored exactly (a leading '/' is an empty first component,
+// so "/a/b" and "a/b" differ); one trailing '/' on folder paths is ignored. Names are
+// opaque bytes (the UI stores UTF-8). Thread-safe; the store only grows.
+class PathStore {
+public:
+    using Id = std::uint32_t;
+    static constexpr Id kTop = 0; // the empty path, parent of every first component
+
+    PathStore();
+
+    // Folder node for "path" below "under" (every component interned)
+    Id dir(std::string_view path, Id under = kTop);
+    // File path below "under": folder part interned, leaf name appended to the arena
+    PathRef file(std::string_view path, Id under = kTop);
+    // The same file below another folder: "r" must lie below "from"; the folders between
+    // are interned below "to" and the leaf name is shared. Empty if "r" is not below "from".
+    PathRef rebase(const PathRef& r, Id from, Id to);
+
+    std::string str(const PathRef& r) const;
+    std::string dirStr(Id d) const;
+
+    std::size_t dirCount() const;
+    std::size_t bytes() const; // approximate memory held
+
+private:
+    struct Node {
+        Id parent = kTop;
+        std::uint32_t len = 0;
+        std::uint64_t off = 0; // name in names_
+    };
+    mutable std::mutex mtx_;
+    std::vector<Node> nodes_;   // nodes_[kTop] is the empty path
+    std::string names_;         // folder and leaf names, back to back
+    // (parent, name) hash -> node; collisions resolved by comparing the stored names
+    std::unordered_multimap<std::uint64_t, Id> index_;
+    // Last folder resolved by file(): consecutive files usually share it
+    Id lastUnder_ = kTop;
+    std::string lastDirPath_;
+    Id lastDir_ = kTop;
+    bool lastValid_ = false;
+
+    Id childLocked(Id parent, std::string_view name);
+    Id dirLocked(std::string_view path, Id under);
+    std::string_view nameOf(const Node& n) const { return std::string_view(names_).substr(n.off, n.len); }
+    void appendDir(Id d, std::string& out) const;
+};
+
+} // namespace openscp
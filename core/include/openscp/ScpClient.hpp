@@ -0,0 +1,47 @@
+// SCP transfer engine over an existing libssh2 session.
+// Streams whole files through a single channel (no SFTP request/response overhead);
+// used by Libssh2SftpClient to serve get()/put() for large single files.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct _LIBSSH2_SESSION;
+
+namespace openscp {
+
+class ScpClient {
+public:
+    // The session is borrowed (not owned) and must stay connected while in use.
+    explicit ScpClient(_LIBSSH2_SESSION* session) : session_(session) {}
+
+    // Download remote -> local (truncates local). No resume support.
+    bool get(const std::string& remote,
+             const std::string& local,
+             std::string& err,
+             const std::function<void(std::size_t, std::size_t)>& progress = {},
+             const std::function<bool()>& shouldCancel = {});
+
+    // Upload local -> remote (creates/truncates remote with the given mode).
+    bool put(const std::string& local,
+             const std::string& remote,
+             std::string& err,
+             const std::function<void(std::size_t, std::size_t)>& progress = {},
+             const std::function<bool()>& shouldCancel = {},
+             unsigned int mode = 0644);
+
+    // True if the last call failed because the server refused the SCP channel or
+    // exec request; callers can then fall back to SFTP. Per-file errors do not count.
+    bool channelFailed() const { return channelFailed_; }
+    // True if the last call failed before any file data moved (scp missing on the
+    // server, an sftp-only account, ...): the same transfer can still go over SFTP.
+    bool failedBeforeData() const { return noData_; }
+
+private:
+    _LIBSSH2_SESSION* session_ = nullptr;
+    bool channelFailed_ = false;
+    bool noData_ = false;
+};
+
+} // namespace openscp
@@ -2,8 +2,12 @@
 // must follow this API to keep the UI decoupled from the backend.
 #pragma once
 #include "SftpTypes.hpp"
+#include "DirListing.hpp"
 #include <functional>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace openscp {
 
@@ -17,12 +21,32 @@ public:
     virtual bool connect(const SessionOptions& opt, std::string& err) = 0;
     virtual void disconnect() = 0;
     virtual bool isConnected() const = 0;
+    // True once a call failed because the transport died (socket error): the
+    // session stays unusable until it is reconnected. The backend never reconnects or
+    // disconnects by itself; whoever owns the session decides. Optional: false if the
+    // backend cannot tell.
+    virtual bool transportLost() const { return false; }
 
     // Remote directory listing
     virtual bool list(const std::string& remote_path,
                       std::vector<FileInfo>& out,
                       std::string& err) = 0;
 
+    // Streaming listing for huge directories: entries ("." and ".." excluded) are delivered
+    // in batches of at most batchSize; the callback may move them out. Returning false from
+    // the callback stops the listing early (the call still returns true).
+    // Memory stays bounded by one batch regardless of the directory size.
+    using ListBatchCB = std::function<bool(std::vector<FileInfo>& batch)>;
+    virtual bool listStream(const std::string& remote_path,
+                            const ListBatchCB& onBatch,
+                            std::string& err,
+                            std::size_t batchSize = 512);
+
+    // Whole listing in compact form (names in one arena, "." and ".." excluded).
+    virtual bool listCompact(const std::string& remote_path,
+                             DirListing& out,
+                             std::string& err);
+
     // Download a remote file to local; if resume=true, try to continue a partial download
     virtual bool get(const std::string& remote,
                      const std::string& local,
@@ -82,6 +106,138 @@ public:
                         std::string& err,
                         bool overwrite = false) = 0;
 
+    // Login identity on the server, used to infer access from listed mode/uid/gid
+    // instead of probing with writes. Optional: false if the backend cannot tell.
+    struct RemoteIdentity {
+        std::uint32_t uid = 0;
+        std::vector<std::uint32_t> gids; // primary and supplementary groups
+        bool exact = true; // false: guessed (e.g. from the login directory), groups incomplete
+    };
+    virtual bool remoteIdentity(RemoteIdentity& out, std::string& err);
+    // True if "dir" (a directory stat) lets "id" create and delete entries (w+x).
+    // Only POSIX bits are considered: ACLs and server-side policies are not visible here.
+    static bool canModifyDir(const FileInfo& dir, const RemoteIdentity& id);
+
+    // Bulk folder transfer as a single tar stream over an SSH exec channel.
+    // Optional: backends without exec support keep these defaults.
+    // fileError receives per-entry problems (relative path, message) without aborting the stream.
+    using TreeFileErrorCB = std::function<void(const std::string& /*path*/, const std::string& /*message*/)>;
+
+    // True if the server accepts exec and provides tar (result may be cached).
+    virtual bool execTreeAvailable() { return false; }
+
+    // Download remote_dir's contents into local_dir (created if missing).
+    virtual bool getTree(const std::string& remote_dir,
+                         const std::string& local_dir,
+                         std::string& err,
+                         std::function<void(std::size_t /*done*/, std::size_t /*total*/)> progress = {},
+                         TreeFileErrorCB fileError = {},
+                         std::function<bool()> shouldCancel = {}) {
+        (void)remote_dir; (void)local_dir; (void)progress; (void)fileError; (void)shouldCancel;
+        err = "No soportado";
+        return false;
+    }
+
+    // Upload local_dir's contents into remote_dir (created if missing).
+    virtual bool putTree(const std::string& local_dir,
+                         const std::string& remote_dir,
+                         std::string& err,
+                         std::function<void(std::size_t /*done*/, std::size_t /*total*/)> progress = {},
+                         TreeFileErrorCB fileError = {},
+                         std::function<bool()> shouldCancel = {}) {
+        (void)local_dir; (void)remote_dir; (void)progress; (void)fileError; (void)shouldCancel;
+        err = "No soportado";
+        return false;
+    }
+
+    // Multi-file transfers (many small files). Backends may overlap the per-file
+    // open/io/setstat/close round trips; the default runs get()/put() serially.
+    // onItemDone is called exactly once per item (index into "items").
+    struct TransferPair {
+        std::string src;
+        std::string dst;
+    };
+    using ItemDoneCB = std::function<void(std::size_t /*index*/, bool /*ok*/, const std::string& /*err*/)>;
+    using ItemProgressCB = std::function<void(std::size_t /*index*/, std::size_t /*done*/, std::size_t /*total*/)>;
+
+    // Upload local->remote for each pair (remote parents must exist). Returns false only if the batch could not start.
+    virtual bool putMany(const std::vector<TransferPair>& items,
+                         std::string& err,
+                         ItemDoneCB onItemDone,
+                         ItemProgressCB progress = {},
+                         std::function<bool(std::size_t)> shouldCancel = {});
+
+    // Download remote->local for each pair (local parents must exist); preserves remote mtime.
+    virtual bool getMany(const std::vector<TransferPair>& items,
+                         std::string& err,
+                         ItemDoneCB onItemDone,
+                         ItemProgressCB progress = {},
+                         std::function<bool(std::size_t)> shouldCancel = {});
+
+    // ---- Batch metadata ----
+    // Primitives take many paths and return one result per path (same order); backends may
+    // pipeline the requests, the defaults loop over the single-path calls.
+    // The return value is false only if the batch could not run at all (e.g., not connected).
+    struct StatResult {
+        bool exists = false;   // false with empty err => does not exist
+        FileInfo info;         // valid when exists
+        std::string err;
+    };
+    using PathErrors = std::vector<std::pair<std::string, std::string>>; // (path, error)
+
+    virtual bool statMany(const std::vector<std::string>& paths,
+                          std::vector<StatResult>& out,
+                          std::string& err);
+
+    // Single-level mkdir per path (parents must exist). errors[i] empty on success.
+    virtual bool mkdirMany(const std::vector<std::string>& dirs,
+                           std::vector<std::string>& errors,
+                           std::string& err,
+                           unsigned int mode = 0755);
+
+    virtual bool chmodMany(const std::vector<std::string>& paths,
+                           std::uint32_t mode,
+                           std::vector<std::string>& errors,
+                           std::string& err);
+
+    virtual bool chownMany(const std::vector<std::string>& paths,
+                           std::uint32_t uid,
+                           std::uint32_t gid,
+                           std::vector<std::string>& errors,
+                           std::string& err);
+
+    virtual bool removeMany(const std::vector<std::string>& files,
+                            std::vector<std::string>& errors,
+                            std::string& err);
+
+    virtual bool rmdirMany(const std::vector<std::string>& dirs,
+                           std::vector<std::string>& errors,
+                           std::string& err);
+
+    // Composite helpers built on the primitives above.
+    // exists[i]/isDir[i] per path; errors[i] non-empty when the check itself failed.
+    bool existsMany(const std::vector<std::string>& paths,
+                    std::vector<bool>& exists,
+                    std::vector<bool>& isDir,
+                    std::vector<std::string>& errors,
+                    std::string& err);
+    // mkdir -p for every path: missing components are created level by level.
+    bool mkdirs(const std::vector<std::string>& dirs,
+                std::vector<std::string>& errors,
+                std::string& err,
+                unsigned int mode = 0755);
+    // Apply to root and every descendant (symlinks are not followed).
+    bool chmodRecursive(const std::string& root, std::uint32_t mode,
+                        PathErrors& failures, std::string& err,
+                        std::function<bool()> shouldCancel = {});
+    bool chownRecursive(const std::string& root, std::uint32_t uid, std::uint32_t gid,
+                        PathErrors& failures, std::string& err,
+                        std::function<bool()> shouldCancel = {});
+    // Delete files and whole directory trees (missing roots count as success).
+    bool removeRecursive(const std::vector<std::string>& roots,
+                         PathErrors& failures, std::string& err,
+                         std::function<bool()> shouldCancel = {});
+
     // Create a new connection of the same type with the given options.
     virtual std::unique_ptr<SftpClient> newConnectionLike(const SessionOptions& opt,
                                                           std::string& err) = 0;
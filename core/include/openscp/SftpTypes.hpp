@@ -16,6 +16,20 @@ enum class KnownHostsPolicy {
     Off         // No verification (not recommended).
 };
 
+// SSH transport compression (zlib) for the session.
+enum class CompressionMode {
+    Off,    // Never compress (default).
+    On,     // Always negotiate compression.
+    Auto    // Main session uncompressed; compressible transfers use a compressed session.
+};
+
+// Engine used for single-file get/put.
+enum class TransferEngine {
+    Sftp,   // Always SFTP (default).
+    Scp,    // SCP for every non-resumed transfer (falls back to SFTP if unavailable).
+    Auto    // SCP for large files once measured faster than SFTP on this server.
+};
+
 struct FileInfo {
     std::string   name;         // base name
     bool          is_dir = false;
@@ -52,6 +66,11 @@ struct SessionOptions {
     // Visual preference: show fingerprint in HEX colon format (UI only)
     bool show_fp_hex = false;
 
+    // Transport compression (see CompressionMode)
+    CompressionMode compression = CompressionMode::Off;
+    // File transfer engine (see TransferEngine)
+    TransferEngine transfer_engine = TransferEngine::Sftp;
+
     // Host key confirmation (TOFU) when known_hosts lacks an entry.
     // Return true to accept and save, false to reject.
     // canSave: whether the client will be able to persist the host key (false means user must explicitly allow a one‑time connection without saving)
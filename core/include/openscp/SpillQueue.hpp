@@ -0,0 +1,51 @@
+// On-disk FIFO for batches that outgrow their memory budget: records are appended to
+// memory-mapped segment files and read back in order. Segments are unlinked at creation
+// (nothing is left behind after a crash) and released as soon as they are consumed.
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace openscp {
+
+// Not thread-safe: one owner pushes and pops.
+class SpillQueue {
+public:
+    // Segments are created in "dir" (must exist), segmentBytes each (larger records get
+    // a segment of their own)
+    explicit SpillQueue(std::string dir, std::size_t segmentBytes = 64u << 20);
+    ~SpillQueue();
+    SpillQueue(const SpillQueue&) = delete;
+    SpillQueue& operator=(const SpillQueue&) = delete;
+
+    // False if a segment could not be created or grown (disk full, err set)
+    bool push(std::string_view rec, std::string& err);
+    // Oldest record; false when empty
+    bool pop(std::string& out);
+    bool empty() const { return count_ == 0; }
+    std::uint64_t size() const { return count_; }
+    std::uint64_t diskBytes() const { return diskBytes_; }
+    void clear();
+
+private:
+    struct Segment {
+        int fd = -1;
+        char* base = nullptr;     // mapping (nullptr where files are used directly)
+        std::size_t cap = 0;
+        std::size_t wpos = 0;     // end of the last record
+        std::size_t rpos = 0;     // next record to read
+        void* file = nullptr;     // std::FILE* on platforms without mmap
+    };
+    std::string dir_;
+    std::size_t segmentBytes_;
+    std::deque<Segment> segs_;
+    std::uint64_t count_ = 0;
+    std::uint64_t diskBytes_ = 0;
+    std::uint64_t serial_ = 0;
+
+    bool addSegment(std::size_t minBytes, std::string& err);
+    void dropSegment(Segment& s);
+};
+
+} // namespace openscp
@@ -0,0 +1,86 @@
+// Minimal streaming tar (ustar + GNU long names) writer and extractor.
+// Used to move whole folder trees over a single SSH exec channel.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace openscp {
+
+// Per-entry error callback: relative path + message. The stream continues.
+using TarFileErrorCB = std::function<void(const std::string& path, const std::string& message)>;
+
+// Serializes local entries into a tar stream pushed to "sink".
+class TarWriter {
+public:
+    // sink returns false to abort (e.g., channel write failed)
+    explicit TarWriter(std::function<bool(const char*, std::size_t)> sink) : sink_(std::move(sink)) {}
+
+    bool addDirectory(const std::string& rel, std::uint32_t mode, std::uint64_t mtime);
+    // Streams the local file content. "onBytes" reports payload bytes written.
+    // A local read failure is reported through onError and the entry is padded so the stream stays valid.
+    bool addFile(const std::string& rel, const std::string& localPath,
+                 std::uint64_t size, std::uint32_t mode, std::uint64_t mtime,
+                 const std::function<void(std::size_t)>& onBytes,
+                 const std::function<bool()>& shouldCancel,
+                 const TarFileErrorCB& onError,
+                 std::string& err);
+    // Writes the two terminating zero blocks.
+    bool finish();
+
+private:
+    std::function<bool(const char*, std::size_t)> sink_;
+    bool writeHeader(const std::string& rel, char type, std::uint64_t size,
+                     std::uint32_t mode, std::uint64_t mtime);
+    bool writeLongName(const std::string& rel);
+    bool pad(std::uint64_t size);
+};
+
+// Push-parser that extracts a tar stream below a local root directory.
+// Regular files and directories are created; links and special files are reported and skipped.
+class TarExtractor {
+public:
+    TarExtractor(std::string root, TarFileErrorCB onError)
+        : root_(std::move(root)), onError_(std::move(onError)) {}
+    ~TarExtractor();
+
+    // Feed the next chunk of the stream. Returns false on a fatal (format/IO) error.
+    bool feed(const char* data, std::size_t len, std::string& err);
+    // True once the end-of-archive marker has been seen.
+    bool finished() const { return finished_; }
+    // Payload bytes written so far (file contents only)
+    std::uint64_t bytesWritten() const { return bytes_; }
+
+private:
+    enum class State { Header, Data, Padding };
+    std::string root_;
+    TarFileErrorCB onError_;
+    State state_ = State::Header;
+    std::vector<char> header_;        // accumulates the current 512-byte header
+    std::uint64_t remaining_ = 0;     // payload bytes left for the current entry
+    std::uint64_t padRemaining_ = 0;  // padding bytes left to the next block
+    std::uint64_t bytes_ = 0;
+    int zeroBlocks_ = 0;
+    bool finished_ = false;
+
+    // Current entry
+    char type_ = 0;
+    std::string path_;
+    std::uint32_t mode_ = 0;
+    std::uint64_t mtime_ = 0;
+    std::FILE* out_ = nullptr;        // open target for regular files
+    std::string meta_;                // buffered payload for GNU long name / pax records
+    std::string pendingLongName_;     // name carried over from an 'L' or pax entry
+
+    bool beginEntry(std::string& err);
+    void endEntry();
+    bool entryPath(std::string& out);
+};
+
+// Quote an argument for a POSIX shell command line.
+std::string shellQuote(const std::string& s);
+
+} // namespace openscp
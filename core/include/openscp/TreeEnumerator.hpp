@@ -0,0 +1,114 @@
+// Parallel recursive remote enumeration. Directory listings fan out across several
+// sessions to the same server; per-worker deques with work stealing keep them busy.
+#pragma once
+#include "PathRules.hpp"
+#include "SftpClient.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace openscp {
+
+// Extra sessions to one server (opened on demand with newConnectionLike), kept open
+// between enumerations so only the first one pays the handshakes.
+class SessionPool {
+public:
+    // "origin" must outlive the pool. maxSessions bounds the extra sessions.
+    SessionPool(SftpClient& origin, SessionOptions opt, std::size_t maxSessions = 3);
+    ~SessionPool();
+
+    std::size_t maxSessions() const { return max_; }
+    // An idle session, or a new connection while below the limit; nullptr otherwise.
+    std::unique_ptr<SftpClient> acquire(std::string& err);
+    // Hand a session back (dropped if it disconnected)
+    void release(std::unique_ptr<SftpClient> s);
+    // Reconnect a session the caller owns after it lost its transport, with backoff
+    bool reconnect(SftpClient& s, const std::atomic_bool* cancel, std::string& err);
+
+private:
+    SftpClient& origin_;
+    SessionOptions opt_;
+    std::size_t max_;
+    std::mutex mtx_;
+    std::vector<std::unique_ptr<SftpClient>> idle_;
+    std::size_t open_ = 0; // idle + lent out
+};
+
+struct TreeEntry {
+    std::string path; // full remote path
+    std::string rel;  // relative to the enumerated root ("sub/file")
+    FileInfo info;
+    int depth = 0;    // 1 for direct children of the root
+};
+
+// Where a walk stands: folders still to list (with the names already reported from one
+// that was interrupted half-way) and every folder queued or listed so far (also the cycle
+// guard). Filled when enumerateTree stops early; handing it back resumes the walk.
+struct EnumCursor {
+    struct Dir {
+        std::string path;
+        std::string rel;
+        int depth = 0;
+        std::vector<std::string> reported;
+    };
+    std::string root;
+    std::vector<Dir> pending;
+    std::unordered_set<std::string> visited;
+    std::string tag; // caller data kept with the snapshot (not used by the walk)
+
+    bool empty() const { return pending.empty(); }
+    void clear() { root.clear(); pending.clear(); visited.clear(); tag.clear(); }
+    // Binary snapshot (written to a temporary file, then renamed over "file")
+    bool save(const std::string& file, std::string& err) const;
+    bool load(const std::string& file, std::string& err);
+    // Only the tag of a snapshot, without reading the rest
+    static bool readTag(const std::string& file, std::string& tag);
+};
+
+struct TreeEnumOptions {
+    int maxDepth = 32;                       // directories deeper than this are not listed
+    bool skipSymlinks = true;                // otherwise reported as entries (never followed)
+    const std::atomic_bool* cancel = nullptr; // cooperative cancel flag
+    SessionPool* pool = nullptr;             // extra sessions; nullptr => serial on "client"
+    // "client" belongs to the walk alone and may be reconnected through the pool; a shared
+    // client that loses its transport ends the walk instead
+    bool ownsClient = false;
+    const PathRules* rules = nullptr;        // excluded entries are not reported (nor listed)
+    // Resume from *cursor when it holds a walk of the same root; when the walk stops early
+    // (cancel, connection lost for good) the rest of the frontier is left in it
+    EnumCursor* cursor = nullptr;
+};
+
+struct TreeEnumStats {
+    std::uint64_t dirs = 0;            // directories listed (root included)
+    std::uint64_t listFailures = 0;    // directories that could not be listed
+    std::uint64_t symlinksSkipped = 0;
+    std::uint64_t depthLimited = 0;    // directories not descended (maxDepth)
+    std::uint64_t excluded = 0;        // entries dropped by the rules
+    std::uint64_t reconnects = 0;      // lost connections recovered during the walk
+};
+
+// Called for every entry below the root, one call at a time (from any worker thread).
+// Return false to skip the entry; a skipped directory is not descended.
+using TreeEntryCB = std::function<bool(const TreeEntry&)>;
+
+// Walk "root" (listed with "client" on the calling thread, helpers on pooled sessions).
+// Unreadable directories are counted in stats and skipped. A folder whose listing failed
+// because the transport died (SftpClient::transportLost) is kept: pooled sessions, and
+// "client" when ownsClient is set, are reconnected and the walk goes on. Returns false
+// when cancelled or when the connection could not be recovered (err set; see
+// TreeEnumOptions::cursor to resume).
+bool enumerateTree(SftpClient& client,
+                   const std::string& root,
+                   const TreeEnumOptions& opt,
+                   const TreeEntryCB& onEntry,
+                   TreeEnumStats& stats,
+                   std::string& err);
+
+} // namespace openscp
@@ -0,0 +1,482 @@
+// Listing/stat cache in front of any SftpClient (see CachingSftpClient.hpp).
+#include "openscp/CachingSftpClient.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace openscp {
+
+using Clock = std::chrono::steady_clock;
+
+struct CachingSftpClient::Cache {
+    struct Dir {
+        DirListing listing;
+        std::uint64_t mtime = 0;
+        bool mtimeTrusted = false;   // false => always re-list once stale
+        Clock::time_point fetched;
+    };
+    struct Stat {
+        bool exists = false;
+        FileInfo info;
+        Clock::time_point fetched;
+    };
+    explicit Cache(ListingCacheOptions o) : opt(o) {}
+    ListingCacheOptions opt;
+    std::mutex mtx;                  // guards the maps only; never held across network calls
+    std::unordered_map<std::string, Dir> dirs;
+    std::size_t dirBytes = 0;        // sum of listing.memoryBytes() over dirs
+
+    void eraseDir(std::unordered_map<std::string, Dir>::iterator it) {
+        dirBytes -= it->second.listing.memoryBytes();
+        dirs.erase(it);
+    }
+    void eraseDir(const std::string& p) {
+        auto it = dirs.find(p);
+        if (it != dirs.end()) eraseDir(it);
+    }
+    std::unordered_map<std::string, Stat> stats;
+
+    // Keep the stat map bounded (batched stats of big uploads would otherwise pile up)
+    void trimStats(Clock::time_point now) {
+        static constexpr std::size_t kMaxStats = 8192;
+        if (stats.size() < kMaxStats) return;
+        for (auto it = stats.begin(); it != stats.end();) {
+            if (now - it->second.fetched >= opt.freshFor) it = stats.erase(it);
+            else ++it;
+        }
+        if (stats.size() >= kMaxStats) stats.clear();
+    }
+};
+
+static std::string normPath(const std::string& p) {
+    if (p.empty()) return "/";
+    std::string q = p;
+    while (q.size() > 1 && q.back() == '/') q.pop_back();
+    return q;
+}
+
+static std::string parentPath(const std::string& p) {
+    const auto slash = p.find_last_of('/');
+    if (slash == std::string::npos) return std::string();
+    return slash == 0 ? std::string("/") : p.substr(0, slash);
+}
+
+CachingSftpClient::CachingSftpClient(std::unique_ptr<SftpClient> inner, ListingCacheOptions opt)
+    : inner_(std::move(inner)), cache_(std::make_shared<Cache>(opt)) {}
+
+CachingSftpClient::CachingSftpClient(std::unique_ptr<SftpClient> inner, std::shared_ptr<Cache> cache)
+    : inner_(std::move(inner)), cache_(std::move(cache)) {}
+
+CachingSftpClient::~CachingSftpClient() = default;
+
+void CachingSftpClient::invalidateAll() {
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    cache_->dirs.clear();
+    cache_->dirBytes = 0;
+    cache_->stats.clear();
+}
+
+void CachingSftpClient::invalidate(const std::string& remote_path) {
+    invalidatePath(remote_path, true);
+}
+
+void CachingSftpClient::invalidatePath(const std::string& path, bool subtree) {
+    const std::string p = normPath(path);
+    const std::string parent = parentPath(p);
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    cache_->eraseDir(p);
+    cache_->stats.erase(p);
+    if (!parent.empty()) {
+        // The parent's listing and its own mtime change with any entry below it
+        cache_->eraseDir(parent);
+        cache_->stats.erase(parent);
+    }
+    if (!subtree) return;
+    const std::string prefix = (p == "/") ? p : p + "/";
+    for (auto it = cache_->dirs.begin(); it != cache_->dirs.end();) {
+        if (it->first.rfind(prefix, 0) == 0) cache_->eraseDir(it++);
+        else ++it;
+    }
+    for (auto it = cache_->stats.begin(); it != cache_->stats.end();) {
+        if (it->first.rfind(prefix, 0) == 0) it = cache_->stats.erase(it);
+        else ++it;
+    }
+}
+
+bool CachingSftpClient::cachedListing(const std::string& path, DirListing& out, std::string& err) {
+    const std::string p = normPath(path);
+    const auto now = Clock::now();
+    bool revalidate = false;
+    std::uint64_t cachedMtime = 0;
+    {
+        std::lock_guard<std::mutex> lk(cache_->mtx);
+        auto it = cache_->dirs.find(p);
+        if (it != cache_->dirs.end()) {
+            const auto age = now - it->second.fetched;
+            if (age < cache_->opt.freshFor) {
+                out = it->second.listing;
+                return true;
+            }
+            if (age < cache_->opt.revalidateFor && it->second.mtimeTrusted) {
+                revalidate = true;
+                cachedMtime = it->second.mtime;
+            } else {
+                cache_->eraseDir(it);
+            }
+        }
+    }
+
+    // Cheap check: an unchanged directory mtime means the entry set is unchanged
+    FileInfo st{};
+    std::string serr;
+    const bool haveStat = inner_->stat(p, st, serr) && st.is_dir;
+    if (revalidate && haveStat && st.mtime == cachedMtime) {
+        std::lock_guard<std::mutex> lk(cache_->mtx);
+        auto it = cache_->dirs.find(p);
+        if (it != cache_->dirs.end()) {
+            it->second.fetched = Clock::now();
+            out = it->second.listing;
+            return true;
+        }
+    }
+
+    DirListing fresh;
+    if (!inner_->listCompact(p, fresh, err)) return false;
+    storeListing(p, fresh, st, haveStat);
+    out = std::move(fresh);
+    return true;
+}
+
+void CachingSftpClient::storeListing(const std::string& p, const DirListing& listing, const FileInfo& st, bool haveStat) {
+    // mtime has one-second resolution: a change in the same second as the listing
+    // would go unnoticed, so such listings are never revalidated by mtime.
+    const auto wallNow = (std::uint64_t)std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    Cache::Dir d;
+    d.listing = listing;
+    d.mtime = st.mtime;
+    d.mtimeTrusted = haveStat && st.mtime > 0 && st.mtime + 1 < wallNow;
+    d.fetched = Clock::now();
+    const std::size_t bytes = d.listing.memoryBytes();
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    cache_->eraseDir(p);
+    // Evict oldest listings until both the count and the memory budget fit
+    while (!cache_->dirs.empty() && (cache_->dirs.size() >= cache_->opt.maxDirs ||
+                                     cache_->dirBytes + bytes > cache_->opt.maxBytes)) {
+        auto oldest = cache_->dirs.begin();
+        for (auto it = cache_->dirs.begin(); it != cache_->dirs.end(); ++it)
+            if (it->second.fetched < oldest->second.fetched) oldest = it;
+        cache_->eraseDir(oldest);
+    }
+    if (bytes > cache_->opt.maxBytes) return; // larger than the whole budget: not cached
+    cache_->dirBytes += bytes;
+    cache_->dirs[p] = std::move(d);
+}
+
+bool CachingSftpClient::peekListing(const std::string& remote_path, DirListing& out) const {
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    auto it = cache_->dirs.find(normPath(remote_path));
+    if (it == cache_->dirs.end()) return false;
+    out = it->second.listing;
+    return true;
+}
+
+bool CachingSftpClient::hasListing(const std::string& remote_path) const {
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    auto it = cache_->dirs.find(normPath(remote_path));
+    if (it == cache_->dirs.end()) return false;
+    const auto age = Clock::now() - it->second.fetched;
+    return age < cache_->opt.freshFor || (age < cache_->opt.revalidateFor && it->second.mtimeTrusted);
+}
+
+std::size_t CachingSftpClient::cachedBytes() const {
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    return cache_->dirBytes;
+}
+
+const ListingCacheOptions& CachingSftpClient::options() const {
+    return cache_->opt;
+}
+
+bool CachingSftpClient::connect(const SessionOptions& opt, std::string& err) {
+    invalidateAll();
+    return inner_->connect(opt, err);
+}
+
+void CachingSftpClient::disconnect() {
+    inner_->disconnect();
+    invalidateAll();
+}
+
+bool CachingSftpClient::list(const std::string& remote_path,
+                             std::vector<FileInfo>& out,
+                             std::string& err) {
+    DirListing l;
+    if (!cachedListing(remote_path, l, err)) return false;
+    out.clear();
+    out.reserve(l.size());
+    for (std::size_t i = 0; i < l.size(); ++i) out.push_back(l.at(i));
+    return true;
+}
+
+bool CachingSftpClient::listStream(const std::string& remote_path,
+                                   const ListBatchCB& onBatch,
+                                   std::string& err,
+                                   std::size_t batchSize) {
+    const std::string p = normPath(remote_path);
+    if (batchSize == 0) batchSize = 1;
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> lk(cache_->mtx);
+        cached = cache_->dirs.count(p) > 0;
+    }
+    if (cached) {
+        // Known directory: reuse (or revalidate) and replay it in batches
+        DirListing l;
+        if (!cachedListing(p, l, err)) return false;
+        std::vector<FileInfo> batch;
+        for (std::size_t i = 0; i < l.size(); ++i) {
+            batch.push_back(l.at(i));
+            if (batch.size() >= batchSize || i + 1 == l.size()) {
+                if (!onBatch(batch)) break;
+                batch.clear();
+            }
+        }
+        return true;
+    }
+
+    // Miss: stream from the server, keeping a copy for the cache if the listing completes
+    FileInfo st{};
+    std::string serr;
+    const bool haveStat = inner_->stat(p, st, serr) && st.is_dir;
+    DirListing copy;
+    bool stopped = false;
+    auto tee = [&](std::vector<FileInfo>& batch) {
+        for (const auto& fi : batch) copy.push(fi);
+        if (!onBatch(batch)) { stopped = true; return false; }
+        return true;
+    };
+    if (!inner_->listStream(p, tee, err, batchSize)) return false;
+    if (!stopped) storeListing(p, copy, st, haveStat);
+    return true;
+}
+
+bool CachingSftpClient::listCompact(const std::string& remote_path,
+                                    DirListing& out,
+                                    std::string& err) {
+    return cachedListing(remote_path, out, err);
+}
+
+bool CachingSftpClient::get(const std::string& remote,
+                            const std::string& local,
+                            std::string& err,
+                            std::function<void(std::size_t, std::size_t)> progress,
+                            std::function<bool()> shouldCancel,
+                            bool resume) {
+    return inner_->get(remote, local, err, std::move(progress), std::move(shouldCancel), resume);
+}
+
+bool CachingSftpClient::put(const std::string& local,
+                            const std::string& remote,
+                            std::string& err,
+                            std::function<void(std::size_t, std::size_t)> progress,
+                            std::function<bool()> shouldCancel,
+                            bool resume) {
+    const bool ok = inner_->put(local, remote, err, std::move(progress), std::move(shouldCancel), resume);
+    invalidatePath(remote, false); // also after failures: a partial file may exist
+    return ok;
+}
+
+bool CachingSftpClient::exists(const std::string& remote_path,
+                               bool& isDir,
+                               std::string& err) {
+    FileInfo info{};
+    const bool ok = stat(remote_path, info, err);
+    isDir = ok && info.is_dir;
+    return ok;
+}
+
+bool CachingSftpClient::stat(const std::string& remote_path,
+                             FileInfo& info,
+                             std::string& err) {
+    const std::string p = normPath(remote_path);
+    {
+        std::lock_guard<std::mutex> lk(cache_->mtx);
+        auto it = cache_->stats.find(p);
+        if (it != cache_->stats.end() && Clock::now() - it->second.fetched < cache_->opt.freshFor) {
+            if (it->second.exists) info = it->second.info;
+            err.clear();
+            return it->second.exists;
+        }
+    }
+    const bool ok = inner_->stat(p, info, err);
+    if (ok || err.empty()) {
+        // Only definite answers are cached (exists / does not exist)
+        std::lock_guard<std::mutex> lk(cache_->mtx);
+        cache_->trimStats(Clock::now());
+        cache_->stats[p] = Cache::Stat{ ok, ok ? info : FileInfo{}, Clock::now() };
+    }
+    return ok;
+}
+
+bool CachingSftpClient::chmod(const std::string& remote_path,
+                              std::uint32_t mode,
+                              std::string& err) {
+    const bool ok = inner_->chmod(remote_path, mode, err);
+    invalidatePath(remote_path, false);
+    return ok;
+}
+
+bool CachingSftpClient::chown(const std::string& remote_path,
+                              std::uint32_t uid,
+                              std::uint32_t gid,
+                              std::string& err) {
+    const bool ok = inner_->chown(remote_path, uid, gid, err);
+    invalidatePath(remote_path, false);
+    return ok;
+}
+
+bool CachingSftpClient::setTimes(const std::string& remote_path,
+                                 std::uint64_t atime,
+                                 std::uint64_t mtime,
+                                 std::string& err) {
+    const bool ok = inner_->setTimes(remote_path, atime, mtime, err);
+    invalidatePath(remote_path, false);
+    return ok;
+}
+
+bool CachingSftpClient::mkdir(const std::string& remote_dir,
+                              std::string& err,
+                              unsigned int mode) {
+    const bool ok = inner_->mkdir(remote_dir, err, mode);
+    invalidatePath(remote_dir, false);
+    return ok;
+}
+
+bool CachingSftpClient::removeFile(const std::string& remote_path,
+                                   std::string& err) {
+    const bool ok = inner_->removeFile(remote_path, err);
+    invalidatePath(remote_path, false);
+    return ok;
+}
+
+bool CachingSftpClient::removeDir(const std::string& remote_dir,
+                                  std::string& err) {
+    const bool ok = inner_->removeDir(remote_dir, err);
+    invalidatePath(remote_dir, true);
+    return ok;
+}
+
+bool CachingSftpClient::rename(const std::string& from,
+                               const std::string& to,
+                               std::string& err,
+                               bool overwrite) {
+    const bool ok = inner_->rename(from, to, err, overwrite);
+    invalidatePath(from, true);
+    invalidatePath(to, true);
+    return ok;
+}
+
+bool CachingSftpClient::getTree(const std::string& remote_dir,
+                                const std::string& local_dir,
+                                std::string& err,
+                                std::function<void(std::size_t, std::size_t)> progress,
+                                TreeFileErrorCB fileError,
+                                std::function<bool()> shouldCancel) {
+    return inner_->getTree(remote_dir, local_dir, err, std::move(progress), std::move(fileError), std::move(shouldCancel));
+}
+
+bool CachingSftpClient::putTree(const std::string& local_dir,
+                                const std::string& remote_dir,
+                                std::string& err,
+                                std::function<void(std::size_t, std::size_t)> progress,
+                                TreeFileErrorCB fileError,
+                                std::function<bool()> shouldCancel) {
+    const bool ok = inner_->putTree(local_dir, remote_dir, err, std::move(progress), std::move(fileError), std::move(shouldCancel));
+    invalidatePath(remote_dir, true);
+    return ok;
+}
+
+bool CachingSftpClient::putMany(const std::vector<TransferPair>& items,
+                                std::string& err,
+                                ItemDoneCB onItemDone,
+                                ItemProgressCB progress,
+                                std::function<bool(std::size_t)> shouldCancel) {
+    const bool ok = inner_->putMany(items, err, std::move(onItemDone), std::move(progress), std::move(shouldCancel));
+    for (const auto& it : items) invalidatePath(it.dst, false);
+    return ok;
+}
+
+bool CachingSftpClient::getMany(const std::vector<TransferPair>& items,
+                                std::string& err,
+                                ItemDoneCB onItemDone,
+                                ItemProgressCB progress,
+                                std::function<bool(std::size_t)> shouldCancel) {
+    return inner_->getMany(items, err, std::move(onItemDone), std::move(progress), std::move(shouldCancel));
+}
+
+bool CachingSftpClient::statMany(const std::vector<std::string>& paths,
+                                 std::vector<StatResult>& out,
+                                 std::string& err) {
+    if (!inner_->statMany(paths, out, err)) return false;
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lk(cache_->mtx);
+    cache_->trimStats(now);
+    for (std::size_t i = 0; i < paths.size() && i < out.size(); ++i) {
+        if (out[i].exists || out[i].err.empty())
+            cache_->stats[normPath(paths[i])] = Cache::Stat{ out[i].exists, out[i].info, now };
+    }
+    return true;
+}
+
+bool CachingSftpClient::mkdirMany(const std::vector<std::string>& dirs,
+                                  std::vector<std::string>& errors,
+                                  std::string& err,
+                                  unsigned int mode) {
+    const bool ok = inner_->mkdirMany(dirs, errors, err, mode);
+    for (const auto& d : dirs) invalidatePath(d, false);
+    return ok;
+}
+
+bool CachingSftpClient::chmodMany(const std::vector<std::string>& paths,
+                                  std::uint32_t mode,
+                                  std::vector<std::string>& errors,
+                                  std::string& err) {
+    const bool ok = inner_->chmodMany(paths, mode, errors, err);
+    for (const auto& p : paths) invalidatePath(p, false);
+    return ok;
+}
+
+bool CachingSftpClient::chownMany(const std::vector<std::string>& paths,
+                                  std::uint32_t uid,
+                                  std::uint32_t gid,
+                                  std::vector<std::string>& errors,
+                                  std::string& err) {
+    const bool ok = inner_->chownMany(paths, uid, gid, errors, err);
+    for (const auto& p : paths) invalidatePath(p, false);
+    return ok;
+}
+
+bool CachingSftpClient::removeMany(const std::vector<std::string>& files,
+                                   std::vector<std::string>& errors,
+                                   std::string& err) {
+    const bool ok = inner_->removeMany(files, errors, err);
+    for (const auto& f : files) invalidatePath(f, false);
+    return ok;
+}
+
+bool CachingSftpClient::rmdirMany(const std::vector<std::string>& dirs,
+                                  std::vector<std::string>& errors,
+                                  std::string& err) {
+    const bool ok = inner_->rmdirMany(dirs, errors, err);
+    for (const auto& d : dirs) invalidatePath(d, true);
+    return ok;
+}
+
+std::unique_ptr<SftpClient> CachingSftpClient::newConnectionLike(const SessionOptions& opt,
+                                                                 std::string& err) {
+    auto c = inner_->newConnectionLike(opt, err);
+    if (!c) return nullptr;
+    return std::unique_ptr<SftpClient>(new CachingSftpClient(std::move(c), cache_));
+}
+
+} // namespace openscp
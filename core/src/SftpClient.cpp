@@ -0,0 +1,402 @@
+// Default (serial) implementations of the optional SftpClient batch operations,
+// plus the composite helpers (mkdirs, recursive chmod/chown/remove) built on them.
+#include "openscp/SftpClient.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <system_error>
+
+namespace openscp {
+
+bool SftpClient::listStream(const std::string& remote_path,
+                            const ListBatchCB& onBatch,
+                            std::string& err,
+                            std::size_t batchSize) {
+    std::vector<FileInfo> all;
+    if (!list(remote_path, all, err)) return false;
+    if (batchSize == 0) batchSize = 1;
+    std::vector<FileInfo> batch;
+    for (std::size_t off = 0; off < all.size(); off += batchSize) {
+        const std::size_t end = std::min(all.size(), off + batchSize);
+        batch.assign(std::make_move_iterator(all.begin() + off), std::make_move_iterator(all.begin() + end));
+        if (!onBatch(batch)) break;
+    }
+    return true;
+}
+
+bool SftpClient::listCompact(const std::string& remote_path,
+                             DirListing& out,
+                             std::string& err) {
+    out.clear();
+    return listStream(remote_path, [&out](std::vector<FileInfo>& batch) {
+        for (const auto& fi : batch) out.push(fi);
+        return true;
+    }, err, 1024);
+}
+
+bool SftpClient::putMany(const std::vector<TransferPair>& items,
+                         std::string& err,
+                         ItemDoneCB onItemDone,
+                         ItemProgressCB progress,
+                         std::function<bool(std::size_t)> shouldCancel) {
+    if (!isConnected()) {
+        err = "No conectado";
+        return false;
+    }
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        std::string e;
+        bool ok = false;
+        if (shouldCancel && shouldCancel(i)) {
+            e = "Cancelado por usuario";
+        } else {
+            ok = put(items[i].src, items[i].dst, e,
+                     [&](std::size_t d, std::size_t t) { if (progress) progress(i, d, t); },
+                     [&]() { return shouldCancel && shouldCancel(i); });
+        }
+        if (onItemDone) onItemDone(i, ok, e);
+    }
+    return true;
+}
+
+bool SftpClient::getMany(const std::vector<TransferPair>& items,
+                         std::string& err,
+                         ItemDoneCB onItemDone,
+                         ItemProgressCB progress,
+                         std::function<bool(std::size_t)> shouldCancel) {
+    if (!isConnected()) {
+        err = "No conectado";
+        return false;
+    }
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        std::string e;
+        bool ok = false;
+        if (shouldCancel && shouldCancel(i)) {
+            e = "Cancelado por usuario";
+        } else {
+            ok = get(items[i].src, items[i].dst, e,
+                     [&](std::size_t d, std::size_t t) { if (progress) progress(i, d, t); },
+                     [&]() { return shouldCancel && shouldCancel(i); });
+        }
+        if (ok) {
+            // Preserve remote mtime like single downloads do
+            FileInfo fi{};
+            std::string se;
+            if (stat(items[i].src, fi, se) && fi.mtime > 0) {
+                std::error_code ec;
+                const auto tp = std::chrono::system_clock::from_time_t((std::time_t)fi.mtime);
+                std::filesystem::last_write_time(items[i].dst, std::chrono::file_clock::from_sys(tp), ec);
+            }
+        }
+        if (onItemDone) onItemDone(i, ok, e);
+    }
+    return true;
+}
+
+// ---- Batch metadata: serial defaults ----
+
+bool SftpClient::statMany(const std::vector<std::string>& paths,
+                          std::vector<StatResult>& out,
+                          std::string& err) {
+    if (!isConnected()) { err = "No conectado"; return false; }
+    out.assign(paths.size(), StatResult{});
+    for (std::size_t i = 0; i < paths.size(); ++i)
+        out[i].exists = stat(paths[i], out[i].info, out[i].err);
+    return true;
+}
+
+bool SftpClient::mkdirMany(const std::vector<std::string>& dirs,
+                           std::vector<std::string>& errors,
+                           std::string& err,
+                           unsigned int mode) {
+    if (!isConnected()) { err = "No conectado"; return false; }
+    errors.assign(dirs.size(), std::string());
+    for (std::size_t i = 0; i < dirs.size(); ++i) mkdir(dirs[i], errors[i], mode);
+    return true;
+}
+
+bool SftpClient::chmodMany(const std::vector<std::string>& paths,
+                           std::uint32_t mode,
+                           std::vector<std::string>& errors,
+                           std::string& err) {
+    if (!isConnected()) { err = "No conectado"; return false; }
+    errors.assign(paths.size(), std::string());
+    for (std::size_t i = 0; i < paths.size(); ++i) chmod(paths[i], mode, errors[i]);
+    return true;
+}
+
+bool SftpClient::chownMany(const std::vector<std::string>& paths,
+                           std::uint32_t uid,
+                           std::uint32_t gid,
+                           std::vector<std::string>& errors,
+                           std::string& err) {
+    if (!isConnected()) { err = "No conectado"; return false; }
+    errors.assign(paths.size(), std::string());
+    for (std::size_t i = 0; i < paths.size(); ++i) chown(paths[i], uid, gid, errors[i]);
+    return true;
+}
+
+bool SftpClient::removeMany(const std::vector<std::string>& files,
+                            std::vector<std::string>& errors,
+                            std::string& err) {
+    if (!isConnected()) { err = "No conectado"; return false; }
+    errors.assign(files.size(), std::string());
+    for (std::size_t i = 0; i < files.size(); ++i) removeFile(files[i], errors[i]);
+    return true;
+}
+
+bool SftpClient::rmdirMany(const std::vector<std::string>& dirs,
+                           std::vector<std::string>& errors,
+                           std::string& err) {
+    if (!isConnected()) { err = "No conectado"; return false; }
+    errors.assign(dirs.size(), std::string());
+    for (std::size_t i = 0; i < dirs.size(); ++i) removeDir(dirs[i], errors[i]);
+    return true;
+}
+
+// ---- Access inference ----
+
+bool SftpClient::remoteIdentity(RemoteIdentity& out, std::string& err) {
+    (void)out;
+    err = "No soportado por este backend";
+    return false;
+}
+
+bool SftpClient::canModifyDir(const FileInfo& dir, const RemoteIdentity& id) {
+    if (id.uid == 0) return true; // root
+    std::uint32_t bits;
+    if (dir.uid == id.uid) bits = (dir.mode >> 6) & 07;
+    else if (std::find(id.gids.begin(), id.gids.end(), dir.gid) != id.gids.end()) bits = (dir.mode >> 3) & 07;
+    else bits = dir.mode & 07;
+    return (bits & 03) == 03; // write + search
+}
+
+// ---- Composite helpers ----
+
+static std::string joinPath(const std::string& base, const std::string& name) {
+    if (base.empty() || base.back() == '/') return base + name;
+    return base + "/" + name;
+}
+
+static bool isSymlinkMode(std::uint32_t mode) {
+    return (mode & 0170000) == 0120000;
+}
+
+// Breadth-first walk below root (root excluded). Directories come with their depth.
+struct TreeListing {
+    std::vector<std::string> files;                     // non-directories (symlinks included)
+    std::vector<std::pair<std::string, int>> dirs;      // directories (path, depth)
+    std::set<std::string> symlinks;                     // subset of files that are symlinks
+};
+
+static bool walkTree(SftpClient& c, const std::string& root, TreeListing& out,
+                     SftpClient::PathErrors& failures, const std::function<bool()>& shouldCancel) {
+    std::vector<std::pair<std::string, int>> frontier{ { root, 0 } };
+    while (!frontier.empty()) {
+        if (shouldCancel && shouldCancel()) return false;
+        std::vector<std::pair<std::string, int>> next;
+        for (const auto& [dir, depth] : frontier) {
+            std::string lerr;
+            auto onBatch = [&, d = dir, dd = depth](std::vector<FileInfo>& entries) {
+                for (const auto& e : entries) {
+                    const std::string child = joinPath(d, e.name);
+                    if (e.is_dir) {
+                        out.dirs.push_back({ child, dd + 1 });
+                        next.push_back({ child, dd + 1 });
+                    } else {
+                        out.files.push_back(child);
+                        if (isSymlinkMode(e.mode)) out.symlinks.insert(child);
+                    }
+                }
+                return true;
+            };
+            if (!c.listStream(dir, onBatch, lerr)) failures.push_back({ dir, lerr });
+        }
+        frontier.swap(next);
+    }
+    return true;
+}
+
+bool SftpClient::existsMany(const std::vector<std::string>& paths,
+                            std::vector<bool>& exists,
+                            std::vector<bool>& isDir,
+                            std::vector<std::string>& errors,
+                            std::string& err) {
+    std::vector<StatResult> st;
+    if (!statMany(paths, st, err)) return false;
+    exists.assign(paths.size(), false);
+    isDir.assign(paths.size(), false);
+    errors.assign(paths.size(), std::string());
+    for (std::size_t i = 0; i < st.size(); ++i) {
+        exists[i] = st[i].exists;
+        isDir[i] = st[i].exists && st[i].info.is_dir;
+        errors[i] = st[i].err;
+    }
+    return true;
+}
+
+bool SftpClient::mkdirs(const std::vector<std::string>& dirs,
+                        std::vector<std::string>& errors,
+                        std::string& err,
+                        unsigned int mode) {
+    errors.assign(dirs.size(), std::string());
+    // Every distinct path prefix, keyed by depth so parents are handled first
+    std::map<std::string, int> depthOf;
+    std::vector<std::vector<std::string>> chains(dirs.size());
+    for (std::size_t i = 0; i < dirs.size(); ++i) {
+        const std::string& d = dirs[i];
+        std::string cur = (!d.empty() && d.front() == '/') ? "/" : "";
+        int depth = 0;
+        std::size_t pos = 0;
+        while (pos < d.size()) {
+            std::size_t slash = d.find('/', pos);
+            if (slash == std::string::npos) slash = d.size();
+            if (slash > pos) {
+                cur = (cur.empty() || cur == "/") ? cur + d.substr(pos, slash - pos)
+                                                   : cur + "/" + d.substr(pos, slash - pos);
+                depthOf.emplace(cur, ++depth);
+                chains[i].push_back(cur);
+            }
+            pos = slash + 1;
+        }
+    }
+    if (depthOf.empty()) return true;
+
+    std::vector<std::string> all;
+    all.reserve(depthOf.size());
+    for (const auto& kv : depthOf) all.push_back(kv.first);
+    std::vector<StatResult> st;
+    if (!statMany(all, st, err)) return false;
+
+    std::map<std::string, std::string> failed; // prefix -> error
+    std::map<int, std::vector<std::string>> missingByDepth;
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        if (st[i].exists) {
+            if (!st[i].info.is_dir) failed[all[i]] = "Existe y no es una carpeta: " + all[i];
+        } else if (!st[i].err.empty()) {
+            failed[all[i]] = st[i].err;
+        } else {
+            missingByDepth[depthOf[all[i]]].push_back(all[i]);
+        }
+    }
+    auto parentOf = [](const std::string& p) {
+        const auto slash = p.find_last_of('/');
+        if (slash == std::string::npos) return std::string();
+        return slash == 0 ? std::string("/") : p.substr(0, slash);
+    };
+    for (auto& [depth, level] : missingByDepth) {
+        (void)depth;
+        std::vector<std::string> todo;
+        for (const auto& p : level) {
+            auto pf = failed.find(parentOf(p));
+            if (pf != failed.end()) failed[p] = pf->second;
+            else todo.push_back(p);
+        }
+        if (todo.empty()) continue;
+        std::vector<std::string> merr;
+        if (!mkdirMany(todo, merr, err, mode)) return false;
+        for (std::size_t i = 0; i < todo.size(); ++i)
+            if (!merr[i].empty()) failed[todo[i]] = merr[i];
+    }
+    for (std::size_t i = 0; i < dirs.size(); ++i) {
+        for (const auto& p : chains[i]) {
+            auto f = failed.find(p);
+            if (f != failed.end()) { errors[i] = f->second; break; }
+        }
+    }
+    return true;
+}
+
+// Apply "op" to root + descendants in chunks so cancellation stays responsive.
+static bool applyRecursive(SftpClient& c, const std::string& root,
+                           const std::function<bool(const std::vector<std::string>&, std::vector<std::string>&, std::string&)>& op,
+                           SftpClient::PathErrors& failures, std::string& err,
+                           const std::function<bool()>& shouldCancel) {
+    FileInfo rootInfo{};
+    if (!c.stat(root, rootInfo, err)) {
+        if (err.empty()) err = "No existe: " + root;
+        return false;
+    }
+    std::vector<std::string> targets{ root };
+    if (rootInfo.is_dir) {
+        TreeListing t;
+        if (!walkTree(c, root, t, failures, shouldCancel)) { err = "Cancelado por usuario"; return false; }
+        for (const auto& d : t.dirs) targets.push_back(d.first);
+        for (const auto& f : t.files)
+            if (!t.symlinks.count(f)) targets.push_back(f); // SETSTAT would follow the link
+    }
+    static constexpr std::size_t kChunk = 1024;
+    for (std::size_t off = 0; off < targets.size(); off += kChunk) {
+        if (shouldCancel && shouldCancel()) { err = "Cancelado por usuario"; return false; }
+        std::vector<std::string> chunk(targets.begin() + off,
+                                       targets.begin() + std::min(targets.size(), off + kChunk));
+        std::vector<std::string> errors;
+        if (!op(chunk, errors, err)) return false;
+        for (std::size_t i = 0; i < chunk.size(); ++i)
+            if (!errors[i].empty()) failures.push_back({ chunk[i], errors[i] });
+    }
+    return true;
+}
+
+bool SftpClient::chmodRecursive(const std::string& root, std::uint32_t mode,
+                                PathErrors& failures, std::string& err,
+                                std::function<bool()> shouldCancel) {
+    return applyRecursive(*this, root,
+        [this, mode](const std::vector<std::string>& p, std::vector<std::string>& e, std::string& er) {
+            return chmodMany(p, mode, e, er);
+        }, failures, err, shouldCancel);
+}
+
+bool SftpClient::chownRecursive(const std::string& root, std::uint32_t uid, std::uint32_t gid,
+                                PathErrors& failures, std::string& err,
+                                std::function<bool()> shouldCancel) {
+    return applyRecursive(*this, root,
+        [this, uid, gid](const std::vector<std::string>& p, std::vector<std::string>& e, std::string& er) {
+            return chownMany(p, uid, gid, e, er);
+        }, failures, err, shouldCancel);
+}
+
+bool SftpClient::removeRecursive(const std::vector<std::string>& roots,
+                                 PathErrors& failures, std::string& err,
+                                 std::function<bool()> shouldCancel) {
+    std::vector<StatResult> st;
+    if (!statMany(roots, st, err)) return false;
+    std::vector<std::string> files;
+    std::vector<std::pair<std::string, int>> dirs;
+    for (std::size_t i = 0; i < roots.size(); ++i) {
+        if (!st[i].exists) {
+            if (!st[i].err.empty()) failures.push_back({ roots[i], st[i].err });
+            continue; // already gone
+        }
+        if (!st[i].info.is_dir) { files.push_back(roots[i]); continue; }
+        TreeListing t;
+        if (!walkTree(*this, roots[i], t, failures, shouldCancel)) { err = "Cancelado por usuario"; return false; }
+        files.insert(files.end(), t.files.begin(), t.files.end());
+        dirs.insert(dirs.end(), t.dirs.begin(), t.dirs.end());
+        dirs.push_back({ roots[i], 0 });
+    }
+    if (shouldCancel && shouldCancel()) { err = "Cancelado por usuario"; return false; }
+    std::vector<std::string> errors;
+    if (!files.empty()) {
+        if (!removeMany(files, errors, err)) return false;
+        for (std::size_t i = 0; i < files.size(); ++i)
+            if (!errors[i].empty()) failures.push_back({ files[i], errors[i] });
+    }
+    // Deepest directories first; each level is one batch
+    std::stable_sort(dirs.begin(), dirs.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    std::size_t i = 0;
+    while (i < dirs.size()) {
+        if (shouldCancel && shouldCancel()) { err = "Cancelado por usuario"; return false; }
+        std::size_t j = i;
+        std::vector<std::string> level;
+        while (j < dirs.size() && dirs[j].second == dirs[i].second) level.push_back(dirs[j++].first);
+        if (!rmdirMany(level, errors, err)) return false;
+        for (std::size_t k = 0; k < level.size(); ++k)
+            if (!errors[k].empty()) failures.push_back({ level[k], errors[k] });
+        i = j;
+    }
+    return true;
+}
+
+} // namespace openscp
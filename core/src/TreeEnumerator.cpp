@@ -0,0 +1,403 @@
+// Work-stealing parallel tree walk over several SFTP sessions (see TreeEnumerator.hpp).
+#include "openscp/TreeEnumerator.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unordered_set>
+
+namespace openscp {
+
+// ---- SessionPool ----
+
+SessionPool::SessionPool(SftpClient& origin, SessionOptions opt, std::size_t maxSessions)
+    : origin_(origin), opt_(std::move(opt)), max_(maxSessions) {}
+
+SessionPool::~SessionPool() = default;
+
+std::unique_ptr<SftpClient> SessionPool::acquire(std::string& err) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!idle_.empty()) {
+            auto s = std::move(idle_.back());
+            idle_.pop_back();
+            return s;
+        }
+        if (open_ >= max_) return nullptr;
+        ++open_; // reserve the slot while connecting
+    }
+    auto s = origin_.newConnectionLike(opt_, err);
+    if (!s) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        --open_;
+    }
+    return s;
+}
+
+void SessionPool::release(std::unique_ptr<SftpClient> s) {
+    if (!s) return;
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (s->isConnected()) {
+        idle_.push_back(std::move(s));
+    } else {
+        --open_;
+    }
+}
+
+bool SessionPool::reconnect(SftpClient& s, const std::atomic_bool* cancel, std::string& err) {
+    s.disconnect();
+    // Backoff as TransferManager::ensureConnected: 0.5 s, 1 s, 2 s
+    for (int i = 0; i < 3; ++i) {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(500 << i);
+        while (std::chrono::steady_clock::now() < until) {
+            if (cancel && cancel->load()) { err = "Cancelado por usuario"; return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (s.connect(opt_, err)) return true;
+    }
+    return false;
+}
+
+// ---- EnumCursor ----
+
+namespace {
+
+void putU32(std::ostream& o, std::uint32_t v) { o.write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+void putStr(std::ostream& o, const std::string& v) { putU32(o, (std::uint32_t)v.size()); o.write(v.data(), (std::streamsize)v.size()); }
+bool getU32(std::istream& i, std::uint32_t& v) { return (bool)i.read(reinterpret_cast<char*>(&v), sizeof(v)); }
+// Strings never claim more than the file holds (a corrupt length fails, not allocates)
+bool getStr(std::istream& i, std::string& v, std::uint64_t limit) {
+    std::uint32_t n = 0;
+    if (!getU32(i, n) || n > limit) return false;
+    v.resize(n);
+    return n == 0 || (bool)i.read(v.data(), n);
+}
+
+constexpr char kCursorMagic[8] = { 'O', 'S', 'C', 'P', 'C', 'U', 'R', '2' };
+
+} // namespace
+
+bool EnumCursor::save(const std::string& file, std::string& err) const {
+    const std::string tmp = file + ".tmp";
+    {
+        std::ofstream o(tmp, std::ios::binary | std::ios::trunc);
+        if (!o) { err = "No se pudo escribir " + tmp; return false; }
+        o.write(kCursorMagic, sizeof(kCursorMagic));
+        putStr(o, tag);
+        putStr(o, root);
+        putU32(o, (std::uint32_t)pending.size());
+        for (const Dir& d : pending) {
+            putStr(o, d.path);
+            putStr(o, d.rel);
+            putU32(o, (std::uint32_t)d.depth);
+            putU32(o, (std::uint32_t)d.reported.size());
+            for (const auto& n : d.reported) putStr(o, n);
+        }
+        putU32(o, (std::uint32_t)visited.size());
+        for (const auto& v : visited) putStr(o, v);
+        if (!o.flush()) { err = "No se pudo escribir " + tmp; return false; }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, file, ec); // replaces the previous snapshot atomically
+    if (ec) { err = "No se pudo guardar " + file + ": " + ec.message(); return false; }
+    return true;
+}
+
+bool EnumCursor::readTag(const std::string& file, std::string& tag) {
+    std::error_code ec;
+    const std::uint64_t size = std::filesystem::file_size(file, ec);
+    if (ec) return false;
+    std::ifstream i(file, std::ios::binary);
+    char magic[sizeof(kCursorMagic)];
+    return i.read(magic, sizeof(magic)) && std::memcmp(magic, kCursorMagic, sizeof(magic)) == 0
+           && getStr(i, tag, size);
+}
+
+bool EnumCursor::load(const std::string& file, std::string& err) {
+    clear();
+    std::error_code ec;
+    const std::uint64_t size = std::filesystem::file_size(file, ec);
+    std::ifstream i(file, std::ios::binary);
+    if (ec || !i) { err = "No se pudo abrir " + file; return false; }
+    char magic[sizeof(kCursorMagic)];
+    std::uint32_t n = 0;
+    bool ok = (bool)i.read(magic, sizeof(magic)) && std::memcmp(magic, kCursorMagic, sizeof(magic)) == 0
+              && getStr(i, tag, size) && getStr(i, root, size) && getU32(i, n);
+    for (std::uint32_t k = 0; ok && k < n; ++k) {
+        Dir d;
+        std::uint32_t depth = 0, reported = 0;
+        ok = getStr(i, d.path, size) && getStr(i, d.rel, size) && getU32(i, depth) && getU32(i, reported);
+        d.depth = (int)depth;
+        for (std::uint32_t r = 0; ok && r < reported; ++r) {
+            std::string name;
+            ok = getStr(i, name, size);
+            d.reported.push_back(std::move(name));
+        }
+        pending.push_back(std::move(d));
+    }
+    ok = ok && getU32(i, n);
+    for (std::uint32_t k = 0; ok && k < n; ++k) {
+        std::string v;
+        ok = getStr(i, v, size);
+        visited.insert(std::move(v));
+    }
+    if (!ok) {
+        clear();
+        err = "Cursor de enumeración dañado: " + file;
+    }
+    return ok;
+}
+
+// ---- enumerateTree ----
+
+namespace {
+
+struct DirTask {
+    std::string path;
+    std::string rel;
+    int depth = 0;
+    std::vector<std::string> reported; // entries already reported (resumed folder)
+    int retries = 0;                   // listings lost to a dropped connection
+};
+
+// Listings of one folder retried after reconnecting before it counts as unreadable
+constexpr int kListRetries = 2;
+
+// One deque per worker: the owner pushes/pops at the back (depth-first, warm caches on
+// the server), idle workers steal from the front of the others (oldest, usually the
+// largest remaining subtrees).
+class WorkQueues {
+public:
+    explicit WorkQueues(std::size_t workers) {
+        for (std::size_t i = 0; i < workers; ++i) qs_.push_back(std::make_unique<Q>());
+    }
+    void push(std::size_t w, DirTask t) {
+        outstanding_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lk(qs_[w]->m);
+            qs_[w]->d.push_back(std::move(t));
+        }
+        queued_.fetch_add(1);
+        cv_.notify_one();
+    }
+    bool pop(std::size_t w, DirTask& out) {
+        {
+            std::lock_guard<std::mutex> lk(qs_[w]->m);
+            if (!qs_[w]->d.empty()) {
+                out = std::move(qs_[w]->d.back());
+                qs_[w]->d.pop_back();
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+        for (std::size_t k = 1; k < qs_.size(); ++k) {
+            Q& v = *qs_[(w + k) % qs_.size()];
+            std::lock_guard<std::mutex> lk(v.m);
+            if (!v.d.empty()) {
+                out = std::move(v.d.front());
+                v.d.pop_front();
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+    // A popped task is finished (its children were pushed first)
+    void done() {
+        if (outstanding_.fetch_sub(1) == 1) cv_.notify_all();
+    }
+    bool finished() const { return outstanding_.load() == 0; }
+    std::size_t queued() const { return queued_.load(); }
+    void wait(const std::atomic_bool* cancel) {
+        std::unique_lock<std::mutex> lk(idleM_);
+        cv_.wait_for(lk, std::chrono::milliseconds(20), [&] {
+            return finished() || queued() > 0 || (cancel && cancel->load());
+        });
+    }
+    void wakeAll() { cv_.notify_all(); }
+    // Everything still queued (workers stopped)
+    std::vector<DirTask> drain() {
+        std::vector<DirTask> out;
+        for (auto& q : qs_) {
+            std::lock_guard<std::mutex> lk(q->m);
+            for (auto& t : q->d) out.push_back(std::move(t));
+            q->d.clear();
+        }
+        return out;
+    }
+
+private:
+    struct Q {
+        std::mutex m;
+        std::deque<DirTask> d;
+    };
+    std::vector<std::unique_ptr<Q>> qs_;
+    std::atomic<std::size_t> outstanding_{0}; // queued + being listed
+    std::atomic<std::size_t> queued_{0};
+    std::mutex idleM_;
+    std::condition_variable cv_;
+};
+
+std::string normPath(const std::string& p) {
+    if (p.empty()) return "/";
+    std::string q = p;
+    while (q.size() > 1 && q.back() == '/') q.pop_back();
+    return q;
+}
+
+std::string joinPath(const std::string& base, const std::string& name) {
+    if (base.empty() || base.back() == '/') return base + name;
+    return base + "/" + name;
+}
+
+} // namespace
+
+bool enumerateTree(SftpClient& client,
+                   const std::string& root,
+                   const TreeEnumOptions& opt,
+                   const TreeEntryCB& onEntry,
+                   TreeEnumStats& stats,
+                   std::string& err) {
+    auto cancelled = [&] { return opt.cancel && opt.cancel->load(std::memory_order_relaxed); };
+    std::atomic_bool lost{false};              // connection could not be recovered
+    std::string lostErr;                       // guarded by cbMtx
+    auto stopped = [&] { return cancelled() || lost.load(std::memory_order_relaxed); };
+    const std::size_t helpersMax = opt.pool ? opt.pool->maxSessions() : 0;
+    WorkQueues queues(1 + helpersMax);
+
+    std::mutex cbMtx;                          // serializes onEntry, stats and visited
+    std::unordered_set<std::string> visited;   // cycle guard (normalized paths)
+    const std::string base = normPath(root);
+    EnumCursor* cur = opt.cursor;
+    if (cur && !cur->empty() && cur->root == base) {
+        visited = std::move(cur->visited);
+        for (auto& d : cur->pending)
+            queues.push(0, DirTask{ std::move(d.path), std::move(d.rel), d.depth, std::move(d.reported), 0 });
+        cur->clear();
+    } else {
+        visited.insert(base);
+        queues.push(0, DirTask{ base, std::string(), 0, {}, 0 });
+    }
+
+    // False if the folder must stay queued: stopped half-way, or its listing was lost
+    // with the connection
+    auto process = [&](SftpClient& c, std::size_t w, DirTask& t) {
+        std::vector<FileInfo> children;
+        std::string lerr;
+        const bool ok = c.list(t.path, children, lerr);
+        if (!ok && c.transportLost()) {
+            // Once the walk is stopping (another session may be the one that died), the
+            // folder stays queued for the cursor rather than counting as unreadable
+            if (stopped()) return false;
+            if (t.retries < kListRetries) {
+                ++t.retries;
+                return false;
+            }
+        }
+        std::lock_guard<std::mutex> lk(cbMtx);
+        ++stats.dirs;
+        if (!ok) {
+            ++stats.listFailures;
+            return true;
+        }
+        // A resumed folder: what was reported before the interruption is not reported again
+        const std::unordered_set<std::string> seen(t.reported.begin(), t.reported.end());
+        for (auto& fi : children) {
+            if (stopped()) return false;
+            if (!seen.empty() && seen.count(fi.name)) continue;
+            const bool isLink = (fi.mode & 0170000u) == 0120000u;
+            if (isLink && opt.skipSymlinks) {
+                ++stats.symlinksSkipped;
+                continue;
+            }
+            TreeEntry e;
+            e.path = joinPath(t.path, fi.name);
+            e.rel = t.rel.empty() ? fi.name : t.rel + "/" + fi.name;
+            e.depth = t.depth + 1;
+            if (opt.rules && opt.rules->excluded(e.rel, fi.is_dir && !isLink)) {
+                ++stats.excluded;
+                continue;
+            }
+            e.info = std::move(fi);
+            const bool take = !onEntry || onEntry(e);
+            if (!take && stopped()) return false; // the consumer gave up on this entry
+            if (cur) t.reported.push_back(e.info.name);
+            if (!take || !e.info.is_dir || isLink) continue;
+            if (e.depth > opt.maxDepth) {
+                ++stats.depthLimited;
+                continue;
+            }
+            if (!visited.insert(normPath(e.path)).second) continue;
+            queues.push(w, DirTask{ std::move(e.path), std::move(e.rel), e.depth, {}, 0 });
+        }
+        return true;
+    };
+
+    // Returns false when the worker's session is gone for good. Only sessions the walk
+    // owns are reconnected: the caller's client may be in use elsewhere.
+    auto runWorker = [&](SftpClient& c, std::size_t w, bool owned, const std::function<void()>& afterTask) {
+        while (!stopped()) {
+            DirTask t;
+            if (queues.pop(w, t)) {
+                const bool finished = process(c, w, t);
+                if (!finished) queues.push(w, std::move(t)); // listed again, or kept for the cursor
+                queues.done();
+                if (!finished && !stopped() && c.transportLost()) {
+                    std::string rerr = "transporte SSH interrumpido";
+                    if (!owned || !opt.pool || !opt.pool->reconnect(c, opt.cancel, rerr)) {
+                        std::lock_guard<std::mutex> lk(cbMtx);
+                        if (lostErr.empty()) lostErr = rerr;
+                        return false;
+                    }
+                    std::lock_guard<std::mutex> lk(cbMtx);
+                    ++stats.reconnects;
+                }
+                if (afterTask) afterTask();
+                continue;
+            }
+            if (queues.finished()) break;
+            queues.wait(opt.cancel);
+        }
+        return true;
+    };
+
+    // Helpers join only once there is more than one directory waiting: small trees
+    // never wait for extra handshakes. A helper whose session cannot be recovered just
+    // leaves; its queue is stolen by the others.
+    std::vector<std::thread> helpers;
+    auto maybeSpawn = [&] {
+        if (helpers.size() >= helpersMax || queues.queued() < 2) return;
+        const std::size_t w = helpers.size() + 1;
+        helpers.emplace_back([&, w] {
+            std::string serr;
+            std::unique_ptr<SftpClient> s = opt.pool->acquire(serr);
+            if (!s) return; // pool exhausted or connection refused: the others carry on
+            runWorker(*s, w, true, {});
+            opt.pool->release(std::move(s));
+        });
+    };
+    // Returns once nothing is queued or being listed anywhere, on cancel, or when the
+    // main session is lost
+    if (!runWorker(client, 0, opt.ownsClient, maybeSpawn)) lost = true;
+    queues.wakeAll();
+    for (auto& th : helpers) th.join();
+
+    if (!stopped()) {
+        if (cur) cur->clear();
+        return true;
+    }
+    if (cur) {
+        cur->clear();
+        cur->root = base;
+        for (auto& t : queues.drain())
+            cur->pending.push_back(EnumCursor::Dir{ std::move(t.path), std::move(t.rel), t.depth, std::move(t.reported) });
+        cur->visited = std::move(visited);
+    }
+    err = cancelled() ? std::string("Cancelado por usuario") : "Conexión perdida: " + lostErr;
+    return false;
+}
+
+} // namespace openscp
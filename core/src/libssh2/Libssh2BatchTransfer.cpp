@@ -0,0 +1,452 @@
+// Pipelined multi-file engine (Libssh2SftpClient::putMany/getMany).
+// libssh2 allows a single pending OPEN/CLOSE per SFTP channel, so several SFTP
+// channels are opened on the same SSH session and driven in non-blocking mode:
+// while one file is writing, others are opening, setting times or closing.
+// The same channels carry batched metadata requests (stat/setstat/mkdir/unlink/rmdir).
+#include "openscp/Libssh2SftpClient.hpp"
+#include <libssh2.h>
+#include <libssh2_sftp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+#include <sys/select.h>
+#include <sys/stat.h>
+
+namespace openscp {
+
+// Files in flight at once (one per SFTP channel)
+static constexpr std::size_t kPipelineSlots = 8;
+static constexpr std::size_t kPipelineChunk = 32 * 1024;
+
+namespace {
+
+enum class Step { Idle, Open, Stat, Io, SetStat, Close };
+
+struct Slot {
+    LIBSSH2_SFTP* sftp = nullptr;
+    LIBSSH2_SFTP_HANDLE* h = nullptr;
+    Step step = Step::Idle;
+    std::size_t idx = 0;
+    FILE* lf = nullptr;
+    std::vector<char> buf;
+    std::size_t bufOff = 0;
+    std::size_t bufLen = 0;
+    std::size_t done = 0;
+    std::size_t total = 0;
+    std::uint64_t mtime = 0;
+    unsigned long mode = 0644;
+    // A call returned EAGAIN: libssh2 keeps that request's state on the channel, so the
+    // same call must be repeated until it resolves (cancel is only honored in between)
+    bool pending = false;
+    bool failed = false;
+    std::string err;
+};
+
+} // namespace
+
+// Sleep until the session socket is ready in the direction libssh2 is blocked on.
+static void waitSocket(int sock, LIBSSH2_SESSION* session) {
+    timeval tv{0, 100 * 1000};
+    fd_set fd;
+    FD_ZERO(&fd);
+    FD_SET(sock, &fd);
+    const int dir = libssh2_session_block_directions(session);
+    fd_set* rfd = (dir & LIBSSH2_SESSION_BLOCK_INBOUND) ? &fd : nullptr;
+    fd_set* wfd = (dir & LIBSSH2_SESSION_BLOCK_OUTBOUND) ? &fd : nullptr;
+    ::select(sock + 1, rfd, wfd, nullptr, &tv);
+}
+
+// How long a pipeline may go without any reply before the transport is considered dead
+static std::chrono::milliseconds stallLimit(LIBSSH2_SESSION* session) {
+    const long ms = libssh2_session_get_timeout(session);
+    return std::chrono::milliseconds(ms > 0 ? ms : 20000);
+}
+
+std::vector<LIBSSH2_SFTP*> Libssh2SftpClient::pipelineChannels(std::size_t want) {
+    // Channels are opened in blocking mode and kept for later batches
+    while (extraSftp_.size() + 1 < want) {
+        LIBSSH2_SFTP* extra = libssh2_sftp_init(session_);
+        if (!extra) break; // server limit on channels: use what we have
+        extraSftp_.push_back(extra);
+    }
+    std::vector<LIBSSH2_SFTP*> out{ sftp_ };
+    for (std::size_t i = 0; out.size() < want && i < extraSftp_.size(); ++i) out.push_back(extraSftp_[i]);
+    return out;
+}
+
+bool Libssh2SftpClient::putMany(const std::vector<TransferPair>& items,
+                                std::string& err,
+                                ItemDoneCB onItemDone,
+                                ItemProgressCB progress,
+                                std::function<bool(std::size_t)> shouldCancel) {
+    return runPipeline(true, items, err, onItemDone, progress, shouldCancel);
+}
+
+bool Libssh2SftpClient::getMany(const std::vector<TransferPair>& items,
+                                std::string& err,
+                                ItemDoneCB onItemDone,
+                                ItemProgressCB progress,
+                                std::function<bool(std::size_t)> shouldCancel) {
+    return runPipeline(false, items, err, onItemDone, progress, shouldCancel);
+}
+
+bool Libssh2SftpClient::runPipeline(bool upload,
+                                    const std::vector<TransferPair>& items,
+                                    std::string& err,
+                                    const ItemDoneCB& onItemDone,
+                                    const ItemProgressCB& progress,
+                                    const std::function<bool(std::size_t)>& shouldCancel) {
+    if (!connected_ || !sftp_) {
+        err = "No conectado";
+        return false;
+    }
+    if (items.empty()) return true;
+
+    const std::vector<LIBSSH2_SFTP*> channels = pipelineChannels(std::min(kPipelineSlots, items.size()));
+    std::vector<Slot> slots(channels.size());
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        slots[i].sftp = channels[i];
+        slots[i].buf.resize(kPipelineChunk);
+    }
+
+    auto finishItem = [&](Slot& s) {
+        if (s.lf) { std::fclose(s.lf); s.lf = nullptr; }
+        const TransferPair& it = items[s.idx];
+        if (!upload) {
+            if (!s.failed && s.mtime > 0) {
+                std::error_code ec;
+                const auto tp = std::chrono::system_clock::from_time_t((std::time_t)s.mtime);
+                std::filesystem::last_write_time(it.dst, std::chrono::file_clock::from_sys(tp), ec);
+            }
+        }
+        if (onItemDone) onItemDone(s.idx, !s.failed, s.err);
+        // Reset for the next item, keeping the channel and buffer
+        LIBSSH2_SFTP* ch = s.sftp;
+        std::vector<char> buf = std::move(s.buf);
+        s = Slot{};
+        s.sftp = ch;
+        s.buf = std::move(buf);
+    };
+    auto fail = [&](Slot& s, const char* msg) {
+        s.failed = true;
+        if (s.err.empty()) s.err = msg;
+        s.step = s.h ? Step::Close : Step::Idle;
+        if (!s.h) finishItem(s);
+    };
+    auto isAgain = [&]() { return libssh2_session_last_errno(session_) == LIBSSH2_ERROR_EAGAIN; };
+
+    // Advances one slot by one protocol step. Returns true if something happened.
+    auto stepSlot = [&](Slot& s) -> bool {
+        const TransferPair& it = items[s.idx];
+        switch (s.step) {
+        case Step::Idle:
+            return false;
+        case Step::Open: {
+            if (!s.pending && shouldCancel && shouldCancel(s.idx)) { fail(s, "Cancelado por usuario"); return true; }
+            const std::string& rpath = upload ? it.dst : it.src;
+            const unsigned long flags = upload ? (LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC)
+                                               : LIBSSH2_FXF_READ;
+            s.h = libssh2_sftp_open_ex(s.sftp, rpath.c_str(), (unsigned)rpath.size(), flags,
+                                       upload ? (long)s.mode : 0, LIBSSH2_SFTP_OPENFILE);
+            if (!s.h && isAgain()) { s.pending = true; return false; }
+            s.pending = false;
+            if (!s.h) {
+                fail(s, upload ? "No se pudo abrir remoto para escritura" : "No se pudo abrir remoto para lectura");
+                return true;
+            }
+            // Canceled while the OPEN was in flight: close the handle it produced
+            if (shouldCancel && shouldCancel(s.idx)) { fail(s, "Cancelado por usuario"); return true; }
+            s.step = upload ? Step::Io : Step::Stat;
+            return true;
+        }
+        case Step::Stat: {
+            LIBSSH2_SFTP_ATTRIBUTES a{};
+            int rc = libssh2_sftp_fstat(s.h, &a);
+            if (rc == LIBSSH2_ERROR_EAGAIN) return false;
+            if (rc == 0) {
+                if (a.flags & LIBSSH2_SFTP_ATTR_SIZE) s.total = (std::size_t)a.filesize;
+                if (a.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) s.mtime = a.mtime;
+            }
+            s.lf = std::fopen(it.dst.c_str(), "wb");
+            if (!s.lf) { fail(s, "No se pudo abrir archivo local para escribir"); return true; }
+            s.step = Step::Io;
+            return true;
+        }
+        case Step::Io: {
+            if (!s.pending && shouldCancel && shouldCancel(s.idx)) { fail(s, "Cancelado por usuario"); return true; }
+            if (upload) {
+                if (s.bufOff == s.bufLen) {
+                    s.bufOff = 0;
+                    s.bufLen = std::fread(s.buf.data(), 1, s.buf.size(), s.lf);
+                    if (s.bufLen == 0) {
+                        if (std::ferror(s.lf)) { fail(s, "Lectura local falló"); return true; }
+                        s.step = Step::SetStat;
+                        return true;
+                    }
+                }
+                ssize_t w = libssh2_sftp_write(s.h, s.buf.data() + s.bufOff, s.bufLen - s.bufOff);
+                s.pending = w == LIBSSH2_ERROR_EAGAIN;
+                if (s.pending) return false;
+                if (w < 0) { fail(s, "Escritura remota falló"); return true; }
+                s.bufOff += (std::size_t)w;
+                s.done += (std::size_t)w;
+            } else {
+                ssize_t n = libssh2_sftp_read(s.h, s.buf.data(), s.buf.size());
+                s.pending = n == LIBSSH2_ERROR_EAGAIN;
+                if (s.pending) return false;
+                if (n < 0) { fail(s, "Lectura remota falló"); return true; }
+                if (n == 0) { s.step = Step::Close; return true; }
+                if (std::fwrite(s.buf.data(), 1, (size_t)n, s.lf) != (size_t)n) { fail(s, "Escritura local falló"); return true; }
+                s.done += (std::size_t)n;
+            }
+            if (progress && s.total) progress(s.idx, s.done, s.total);
+            return true;
+        }
+        case Step::SetStat: {
+            // Preserve local mtime; a refusal is not an error for the transfer itself
+            LIBSSH2_SFTP_ATTRIBUTES a{};
+            a.flags = LIBSSH2_SFTP_ATTR_ACMODTIME;
+            a.atime = (unsigned long)s.mtime;
+            a.mtime = (unsigned long)s.mtime;
+            int rc = libssh2_sftp_fsetstat(s.h, &a);
+            if (rc == LIBSSH2_ERROR_EAGAIN) return false;
+            s.step = Step::Close;
+            return true;
+        }
+        case Step::Close: {
+            int rc = libssh2_sftp_close_handle(s.h);
+            if (rc == LIBSSH2_ERROR_EAGAIN) return false;
+            s.h = nullptr;
+            if (rc != 0 && !s.failed) {
+                s.failed = true;
+                s.err = "Cierre remoto falló";
+            }
+            finishItem(s);
+            return true;
+        }
+        }
+        return false;
+    };
+
+    // Start the next item on an idle slot (local work only; no network)
+    std::size_t next = 0;
+    auto startItem = [&](Slot& s) {
+        s.idx = next++;
+        s.step = Step::Open;
+        if (!upload) return;
+        const TransferPair& it = items[s.idx];
+        s.lf = std::fopen(it.src.c_str(), "rb");
+        if (!s.lf) { fail(s, "No se pudo abrir archivo local para lectura"); return; }
+        struct stat st{};
+        if (::fstat(fileno(s.lf), &st) == 0) {
+            s.total = (std::size_t)st.st_size;
+            s.mtime = (std::uint64_t)st.st_mtime;
+            s.mode = (unsigned long)(st.st_mode & 0777);
+        }
+    };
+
+    const auto stall = stallLimit(session_);
+    auto lastProgress = std::chrono::steady_clock::now();
+    libssh2_session_set_blocking(session_, 0);
+    while (true) {
+        bool active = false;
+        bool progressed = false;
+        for (auto& s : slots) {
+            if (s.step == Step::Idle && next < items.size()) { startItem(s); progressed = true; }
+            if (s.step != Step::Idle) {
+                active = true;
+                if (stepSlot(s)) progressed = true;
+            }
+        }
+        if (!active && next >= items.size()) break;
+        if (progressed) {
+            lastProgress = std::chrono::steady_clock::now();
+        } else if (std::chrono::steady_clock::now() - lastProgress > stall) {
+            // No reply for too long: the channels still hold unanswered requests, so
+            // fail what is left and let the owner reconnect before the next batch
+            transportLost_ = true;
+            for (auto& s : slots) {
+                if (s.step == Step::Idle) continue;
+                if (s.lf) { std::fclose(s.lf); s.lf = nullptr; }
+                if (onItemDone) onItemDone(s.idx, false, "Sin respuesta del servidor");
+            }
+            for (; next < items.size(); ++next)
+                if (onItemDone) onItemDone(next, false, "Sin respuesta del servidor");
+            break;
+        } else {
+            waitSocket(sock_, session_);
+        }
+    }
+    libssh2_session_set_blocking(session_, 1);
+    return true;
+}
+
+// ---- Batched metadata ----
+
+static void fillFileInfo(const LIBSSH2_SFTP_ATTRIBUTES& st, FileInfo& info) {
+    info.is_dir = (st.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS)
+                      ? ((st.permissions & LIBSSH2_SFTP_S_IFMT) == LIBSSH2_SFTP_S_IFDIR)
+                      : false;
+    info.has_size = (st.flags & LIBSSH2_SFTP_ATTR_SIZE) != 0;
+    info.size = info.has_size ? (std::uint64_t)st.filesize : 0;
+    info.mtime = (st.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) ? (std::uint64_t)st.mtime : 0;
+    info.mode = (st.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS) ? st.permissions : 0;
+    if (st.flags & LIBSSH2_SFTP_ATTR_UIDGID) {
+        info.uid = st.uid;
+        info.gid = st.gid;
+    }
+}
+
+bool Libssh2SftpClient::runMetaPipeline(MetaKind kind,
+                                        const std::vector<std::string>& paths,
+                                        const void* attrs,
+                                        unsigned int mode,
+                                        std::vector<StatResult>* stats,
+                                        std::vector<std::string>* errors,
+                                        std::string& err) {
+    if (!connected_ || !sftp_) {
+        err = "No conectado";
+        return false;
+    }
+    if (stats) stats->assign(paths.size(), StatResult{});
+    if (errors) errors->assign(paths.size(), std::string());
+    if (paths.empty()) return true;
+
+    // One outstanding request per channel; each channel picks the next path when done
+    const std::vector<LIBSSH2_SFTP*> channels = pipelineChannels(std::min(kPipelineSlots, paths.size()));
+    std::vector<std::size_t> busy(channels.size(), (std::size_t)-1);
+    std::vector<LIBSSH2_SFTP_ATTRIBUTES> scratch(channels.size());
+    const char* failMsg = "";
+    switch (kind) {
+    case MetaKind::Stat:    failMsg = "stat remoto falló"; break;
+    case MetaKind::SetStat: failMsg = "setstat remoto falló"; break;
+    case MetaKind::Mkdir:   failMsg = "sftp_mkdir falló"; break;
+    case MetaKind::Unlink:  failMsg = "sftp_unlink falló"; break;
+    case MetaKind::Rmdir:   failMsg = "sftp_rmdir falló (¿directorio no vacío?)"; break;
+    }
+
+    auto issue = [&](std::size_t c) -> int {
+        const std::string& p = paths[busy[c]];
+        switch (kind) {
+        case MetaKind::Stat:
+            return libssh2_sftp_stat_ex(channels[c], p.c_str(), (unsigned)p.size(), LIBSSH2_SFTP_STAT, &scratch[c]);
+        case MetaKind::SetStat:
+            return libssh2_sftp_stat_ex(channels[c], p.c_str(), (unsigned)p.size(), LIBSSH2_SFTP_SETSTAT, &scratch[c]);
+        case MetaKind::Mkdir:
+            return libssh2_sftp_mkdir_ex(channels[c], p.c_str(), (unsigned)p.size(), (long)mode);
+        case MetaKind::Unlink:
+            return libssh2_sftp_unlink_ex(channels[c], p.c_str(), (unsigned)p.size());
+        case MetaKind::Rmdir:
+            return libssh2_sftp_rmdir_ex(channels[c], p.c_str(), (unsigned)p.size());
+        }
+        return -1;
+    };
+    auto complete = [&](std::size_t c, int rc) {
+        const std::size_t i = busy[c];
+        if (kind == MetaKind::Stat) {
+            StatResult& r = (*stats)[i];
+            if (rc == 0) {
+                r.exists = true;
+                fillFileInfo(scratch[c], r.info);
+            } else {
+                const unsigned long fx = libssh2_sftp_last_error(channels[c]);
+                if (fx != LIBSSH2_FX_NO_SUCH_FILE && fx != LIBSSH2_FX_FAILURE) r.err = failMsg;
+            }
+        } else if (rc != 0) {
+            (*errors)[i] = failMsg;
+        }
+        busy[c] = (std::size_t)-1;
+    };
+
+    std::size_t next = 0;
+    std::size_t inFlight = 0;
+    const auto stall = stallLimit(session_);
+    auto lastProgress = std::chrono::steady_clock::now();
+    libssh2_session_set_blocking(session_, 0);
+    while (next < paths.size() || inFlight > 0) {
+        bool progressed = false;
+        for (std::size_t c = 0; c < channels.size(); ++c) {
+            if (busy[c] == (std::size_t)-1) {
+                if (next >= paths.size()) continue;
+                busy[c] = next++;
+                ++inFlight;
+                // Request attributes are re-sent unchanged while the call is pending
+                if (kind == MetaKind::SetStat) scratch[c] = *static_cast<const LIBSSH2_SFTP_ATTRIBUTES*>(attrs);
+                else scratch[c] = LIBSSH2_SFTP_ATTRIBUTES{};
+            }
+            const int rc = issue(c);
+            if (rc == LIBSSH2_ERROR_EAGAIN) continue;
+            complete(c, rc);
+            --inFlight;
+            progressed = true;
+        }
+        if (progressed) {
+            lastProgress = std::chrono::steady_clock::now();
+        } else if (inFlight > 0 && std::chrono::steady_clock::now() - lastProgress > stall) {
+            transportLost_ = true;
+            libssh2_session_set_blocking(session_, 1);
+            err = "Sin respuesta del servidor";
+            return false;
+        } else if (inFlight > 0) {
+            waitSocket(sock_, session_);
+        }
+    }
+    libssh2_session_set_blocking(session_, 1);
+    return true;
+}
+
+bool Libssh2SftpClient::statMany(const std::vector<std::string>& paths,
+                                 std::vector<StatResult>& out,
+                                 std::string& err) {
+    return runMetaPipeline(MetaKind::Stat, paths, nullptr, 0, &out, nullptr, err);
+}
+
+bool Libssh2SftpClient::mkdirMany(const std::vector<std::string>& dirs,
+                                  std::vector<std::string>& errors,
+                                  std::string& err,
+                                  unsigned int mode) {
+    return runMetaPipeline(MetaKind::Mkdir, dirs, nullptr, mode, nullptr, &errors, err);
+}
+
+bool Libssh2SftpClient::chmodMany(const std::vector<std::string>& paths,
+                                  std::uint32_t mode,
+                                  std::vector<std::string>& errors,
+                                  std::string& err) {
+    LIBSSH2_SFTP_ATTRIBUTES a{};
+    a.flags = LIBSSH2_SFTP_ATTR_PERMISSIONS;
+    a.permissions = mode;
+    return runMetaPipeline(MetaKind::SetStat, paths, &a, 0, nullptr, &errors, err);
+}
+
+bool Libssh2SftpClient::chownMany(const std::vector<std::string>& paths,
+                                  std::uint32_t uid,
+                                  std::uint32_t gid,
+                                  std::vector<std::string>& errors,
+                                  std::string& err) {
+    if (uid == (std::uint32_t)-1 || gid == (std::uint32_t)-1) {
+        // SFTP v3 sets uid and gid together: keep the per-path semantics of chown()
+        return SftpClient::chownMany(paths, uid, gid, errors, err);
+    }
+    LIBSSH2_SFTP_ATTRIBUTES a{};
+    a.flags = LIBSSH2_SFTP_ATTR_UIDGID;
+    a.uid = uid;
+    a.gid = gid;
+    return runMetaPipeline(MetaKind::SetStat, paths, &a, 0, nullptr, &errors, err);
+}
+
+bool Libssh2SftpClient::removeMany(const std::vector<std::string>& files,
+                                   std::vector<std::string>& errors,
+                                   std::string& err) {
+    return runMetaPipeline(MetaKind::Unlink, files, nullptr, 0, nullptr, &errors, err);
+}
+
+bool Libssh2SftpClient::rmdirMany(const std::vector<std::string>& dirs,
+                                  std::vector<std::string>& errors,
+                                  std::string& err) {
+    return runMetaPipeline(MetaKind::Rmdir, dirs, nullptr, 0, nullptr, &errors, err);
+}
+
+} // namespace openscp
@@ -1,6 +1,7 @@
 // libssh2 backend: manages TCP socket, SSH session, and SFTP channel.
 // Includes keepalive, known_hosts validation, and resume support.
 #include "openscp/Libssh2SftpClient.hpp"
+#include "openscp/ScpClient.hpp"
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
@@ -337,6 +338,11 @@ bool Libssh2SftpClient::sshHandshakeAuth(const SessionOptions& opt, std::string&
         "hmac-sha2-512,hmac-sha2-256");
 #endif
 
+    // Compression must be requested before the handshake to be negotiated
+    // (the server may still refuse it; the session then proceeds uncompressed)
+    if (opt.compression == CompressionMode::On)
+        (void)libssh2_session_flag(session_, LIBSSH2_FLAG_COMPRESS, 1);
+
     // Handshake
     if (libssh2_session_handshake(session_, sock_) != 0) {
         err = "SSH handshake falló";
@@ -887,11 +893,15 @@ bool Libssh2SftpClient::connect(const SessionOptions& opt, std::string& err) {
     if (!tcpConnect(opt.host, opt.port, err)) return false;
     if (!sshHandshakeAuth(opt, err)) return false;
 
+    engine_ = opt.transfer_engine;
     connected_ = true;
+    transportLost_ = false;
     return true;
 }
 
 void Libssh2SftpClient::disconnect() {
+    for (auto* extra : extraSftp_) libssh2_sftp_shutdown(extra);
+    extraSftp_.clear();
     if (sftp_) {
         libssh2_sftp_shutdown(sftp_);
         sftp_ = nullptr;
@@ -906,11 +916,41 @@ void Libssh2SftpClient::disconnect() {
         sock_ = -1;
     }
     connected_ = false;
+    transportLost_ = false;
+    treeExec_ = -1;
+    identityKnown_ = false;
+    identity_ = RemoteIdentity{};
+}
+
+void Libssh2SftpClient::noteTransportFailure() {
+    if (!session_) return;
+    // A slow reply (LIBSSH2_ERROR_TIMEOUT) is not a dead transport
+    switch (libssh2_session_last_errno(session_)) {
+    case LIBSSH2_ERROR_SOCKET_DISCONNECT:
+    case LIBSSH2_ERROR_SOCKET_SEND:
+    case LIBSSH2_ERROR_SOCKET_RECV:
+    case LIBSSH2_ERROR_SOCKET_TIMEOUT:
+        transportLost_ = true;
+        break;
+    default:
+        break;
+    }
 }
 
 bool Libssh2SftpClient::list(const std::string& remote_path,
                              std::vector<FileInfo>& out,
                              std::string& err) {
+    out.clear();
+    out.reserve(64);
+    return listStream(remote_path, [&out](std::vector<FileInfo>& batch) {
+        for (auto& fi : batch) out.push_back(std::move(fi));
+        return true;
+    }, err, 1024);
+}
+
+bool Libssh2SftpClient::readDir(const std::string& remote_path,
+                                std::string& err,
+                                const std::function<bool(const char*, std::size_t, const LIBSSH2_SFTP_ATTRIBUTES&)>& onEntry) {
     if (!connected_ || !sftp_) {
         err = "No conectado";
         return false;
@@ -921,44 +961,30 @@ bool Libssh2SftpClient::list(const std::string& remote_path,
     LIBSSH2_SFTP_HANDLE* dir = libssh2_sftp_opendir(sftp_, path.c_str());
     if (!dir) {
         err = "sftp_opendir falló para: " + path;
+        noteTransportFailure();
         return false;
     }
 
-    out.clear();
-    out.reserve(64);
-
-    char filename[512];
-    char longentry[1024];
+    // libssh2 drops an entry that does not fit (it cannot be re-read), so the name
+    // buffer is sized for any path component up front. longentry is not requested.
+    std::vector<char> filename(4096);
     LIBSSH2_SFTP_ATTRIBUTES attrs;
 
     while (true) {
         memset(&attrs, 0, sizeof(attrs));
-        int rc = libssh2_sftp_readdir_ex(dir,
-                                         filename, sizeof(filename),
-                                         longentry, sizeof(longentry),
-                                         &attrs);
+        int rc = libssh2_sftp_readdir_ex(dir, filename.data(), filename.size(), nullptr, 0, &attrs);
         if (rc > 0) {
             // rc = name length
-            FileInfo fi{};
-            fi.name = std::string(filename, rc);
-            fi.is_dir = (attrs.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS)
-                            ? ((attrs.permissions & LIBSSH2_SFTP_S_IFMT) == LIBSSH2_SFTP_S_IFDIR)
-                            : false;
-            if (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE) { fi.size = attrs.filesize; fi.has_size = true; }
-            if (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) fi.mtime = attrs.mtime;
-            if (attrs.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS) fi.mode = attrs.permissions;
-            if (attrs.flags & LIBSSH2_SFTP_ATTR_UIDGID) {
-                fi.uid = attrs.uid;
-                fi.gid = attrs.gid;
-            }
-            if (fi.name == "." || fi.name == "..") continue;
-            out.push_back(std::move(fi));
+            if ((rc == 1 && filename[0] == '.') || (rc == 2 && filename[0] == '.' && filename[1] == '.')) continue;
+            if (!onEntry(filename.data(), (std::size_t)rc, attrs)) break;
         } else if (rc == 0) {
             // end of directory
             break;
         } else {
-            err = "sftp_readdir_ex falló";
+            err = (rc == LIBSSH2_ERROR_BUFFER_TOO_SMALL) ? "Nombre de archivo demasiado largo en: " + path
+                                                         : "sftp_readdir_ex falló";
             libssh2_sftp_closedir(dir);
+            noteTransportFailure();
             return false;
         }
     }
@@ -967,6 +993,62 @@ bool Libssh2SftpClient::list(const std::string& remote_path,
     return true;
 }
 
+// Incremental READDIR: entries are handed over in batches and never accumulated here.
+bool Libssh2SftpClient::listStream(const std::string& remote_path,
+                                   const ListBatchCB& onBatch,
+                                   std::string& err,
+                                   std::size_t batchSize) {
+    if (batchSize == 0) batchSize = 1;
+    std::vector<FileInfo> batch;
+    batch.reserve(std::min<std::size_t>(batchSize, 4096));
+    bool stopped = false;
+    auto onEntry = [&](const char* name, std::size_t len, const LIBSSH2_SFTP_ATTRIBUTES& attrs) {
+        FileInfo fi{};
+        fi.name.assign(name, len);
+        fi.is_dir = (attrs.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS)
+                        ? ((attrs.permissions & LIBSSH2_SFTP_S_IFMT) == LIBSSH2_SFTP_S_IFDIR)
+                        : false;
+        if (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE) { fi.size = attrs.filesize; fi.has_size = true; }
+        if (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) fi.mtime = attrs.mtime;
+        if (attrs.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS) fi.mode = attrs.permissions;
+        if (attrs.flags & LIBSSH2_SFTP_ATTR_UIDGID) {
+            fi.uid = attrs.uid;
+            fi.gid = attrs.gid;
+        }
+        batch.push_back(std::move(fi));
+        if (batch.size() < batchSize) return true;
+        if (!onBatch(batch)) { stopped = true; return false; }
+        batch.clear();
+        return true;
+    };
+    if (!readDir(remote_path, err, onEntry)) return false;
+    if (!stopped && !batch.empty()) (void)onBatch(batch);
+    return true;
+}
+
+// Compact listing: names go straight from the READDIR buffer into the arena.
+bool Libssh2SftpClient::listCompact(const std::string& remote_path,
+                                    DirListing& out,
+                                    std::string& err) {
+    out.clear();
+    auto onEntry = [&out](const char* name, std::size_t len, const LIBSSH2_SFTP_ATTRIBUTES& attrs) {
+        const bool hasPerm = (attrs.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS) != 0;
+        const bool hasIds = (attrs.flags & LIBSSH2_SFTP_ATTR_UIDGID) != 0;
+        out.push(std::string_view(name, len),
+                 hasPerm && (attrs.permissions & LIBSSH2_SFTP_S_IFMT) == LIBSSH2_SFTP_S_IFDIR,
+                 (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE) != 0,
+                 (std::uint64_t)attrs.filesize,
+                 (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) ? (std::uint64_t)attrs.mtime : 0,
+                 hasPerm ? (std::uint32_t)attrs.permissions : 0,
+                 hasIds ? (std::uint32_t)attrs.uid : 0,
+                 hasIds ? (std::uint32_t)attrs.gid : 0);
+        return true;
+    };
+    if (!readDir(remote_path, err, onEntry)) return false;
+    out.shrinkToFit();
+    return true;
+}
+
 // Download a remote file to local. Reports progress and supports cooperative cancellation.
 bool Libssh2SftpClient::get(const std::string& remote,
                             const std::string& local,
@@ -988,6 +1070,22 @@ bool Libssh2SftpClient::get(const std::string& remote,
     }
     std::size_t total = (st.flags & LIBSSH2_SFTP_ATTR_SIZE) ? (std::size_t)st.filesize : 0;
 
+    // Large single files may stream over SCP (no resume support there)
+    bool scpFellBack = false;
+    if (!resume && preferScp(total)) {
+        ScpClient scp(session_);
+        const auto t0 = std::chrono::steady_clock::now();
+        if (scp.get(remote, local, err, progress, shouldCancel)) {
+            noteThroughput(true, total, t0);
+            return true;
+        }
+        if (!scp.failedBeforeData() || (shouldCancel && shouldCancel())) return false;
+        // SCP never got going: continue with SFTP, which tells a refused SCP from a bad file
+        scpFellBack = true;
+        if (scp.channelFailed()) scpUnavailable_ = true;
+        err.clear();
+    }
+
     // Open remote for reading
     LIBSSH2_SFTP_HANDLE* rh = libssh2_sftp_open_ex(
         sftp_, remote.c_str(), (unsigned)remote.size(),
@@ -1021,6 +1119,7 @@ bool Libssh2SftpClient::get(const std::string& remote,
     const std::size_t CHUNK = 64 * 1024;
     std::vector<char> buf(CHUNK);
     std::size_t done = offset;
+    const auto t0 = std::chrono::steady_clock::now();
 
     while (true) {
         if (shouldCancel && shouldCancel()) {
@@ -1051,6 +1150,9 @@ bool Libssh2SftpClient::get(const std::string& remote,
 
     std::fclose(lf);
     libssh2_sftp_close(rh);
+    noteThroughput(false, done - offset, t0);
+    // SFTP handled the file SCP could not even start: SCP is unusable on this server
+    if (scpFellBack) scpUnavailable_ = true;
     return true;
 }
 
@@ -1079,6 +1181,26 @@ bool Libssh2SftpClient::put(const std::string& local,
     std::fseek(lf, 0, SEEK_SET);
     std::size_t total = fsz > 0 ? (std::size_t)fsz : 0;
 
+    bool scpFellBack = false;
+    if (!resume && preferScp(total)) {
+        std::fclose(lf);
+        ScpClient scp(session_);
+        const auto t0 = std::chrono::steady_clock::now();
+        if (scp.put(local, remote, err, progress, shouldCancel)) {
+            noteThroughput(true, total, t0);
+            return true;
+        }
+        if (!scp.failedBeforeData() || (shouldCancel && shouldCancel())) return false;
+        scpFellBack = true;
+        if (scp.channelFailed()) scpUnavailable_ = true;
+        err.clear();
+        lf = ::fopen(local.c_str(), "rb");
+        if (!lf) {
+            err = "No se pudo abrir archivo local para lectura";
+            return false;
+        }
+    }
+
     // Open remote for writing (create, optionally resume without truncation)
     long startOffset = 0;
     if (resume) {
@@ -1114,6 +1236,8 @@ bool Libssh2SftpClient::put(const std::string& local,
         }
         done = (std::size_t)startOffset;
     }
+    const std::size_t startDone = done;
+    const auto t0 = std::chrono::steady_clock::now();
 
     while (true) {
         size_t n = std::fread(buf.data(), 1, buf.size(), lf);
@@ -1152,9 +1276,34 @@ bool Libssh2SftpClient::put(const std::string& local,
 
     libssh2_sftp_close(wh);
     std::fclose(lf);
+    noteThroughput(false, done - startDone, t0);
+    if (scpFellBack) scpUnavailable_ = true;
     return true;
 }
 
+// Files below this size are not worth an SCP channel nor a meaningful throughput sample.
+static constexpr std::size_t kScpMinSize = 8u * 1024 * 1024;
+
+bool Libssh2SftpClient::preferScp(std::size_t size) const {
+    if (scpUnavailable_ || engine_ == TransferEngine::Sftp) return false;
+    if (engine_ == TransferEngine::Scp) return true;
+    // Auto: large files only; measure SFTP first, then probe SCP once, then pick the faster
+    if (size < kScpMinSize) return false;
+    if (sftpBps_ <= 0.0) return false;
+    if (scpBps_ <= 0.0) return true;
+    return scpBps_ > sftpBps_ * 1.1;
+}
+
+void Libssh2SftpClient::noteThroughput(bool scp, std::size_t bytes,
+                                       std::chrono::steady_clock::time_point start) {
+    if (bytes < kScpMinSize) return;
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (secs <= 0.0) return;
+    const double cur = double(bytes) / secs;
+    double& bps = scp ? scpBps_ : sftpBps_;
+    bps = (bps <= 0.0) ? cur : (0.7 * bps + 0.3 * cur);
+}
+
 // Lightweight existence check using sftp_stat.
 bool Libssh2SftpClient::exists(const std::string& remote_path,
                                bool& isDir,
@@ -1230,7 +1379,6 @@ bool Libssh2SftpClient::chmod(const std::string& remote_path,
         err = "No conectado";
         return false;
     }
-#ifdef LIBSSH2_SFTP
     // For compatibility, via SETSTAT
     LIBSSH2_SFTP_ATTRIBUTES a{};
     a.flags = LIBSSH2_SFTP_ATTR_PERMISSIONS;
@@ -1241,12 +1389,6 @@ bool Libssh2SftpClient::chmod(const std::string& remote_path,
         return false;
     }
     return true;
-#else
-    (void)remote_path;
-    (void)mode;
-    err = "chmod no soportado";
-    return false;
-#endif
 }
 
 bool Libssh2SftpClient::setTimes(const std::string& remote_path,
@@ -0,0 +1,358 @@
+// SSH exec channel helpers: folder transfers as a tar stream (Libssh2SftpClient::getTree/putTree)
+// and the login identity probe (remoteIdentity).
+#include "openscp/Libssh2SftpClient.hpp"
+#include "openscp/TarStream.hpp"
+#include <libssh2.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace openscp {
+
+// Open a session channel and start "cmd" on it. Returns nullptr if exec is refused.
+static LIBSSH2_CHANNEL* openExec(LIBSSH2_SESSION* session, const std::string& cmd, std::string& err) {
+    LIBSSH2_CHANNEL* ch = libssh2_channel_open_session(session);
+    if (!ch) {
+        err = "No se pudo abrir canal SSH";
+        return nullptr;
+    }
+    if (libssh2_channel_exec(ch, cmd.c_str()) != 0) {
+        libssh2_channel_free(ch);
+        err = "El servidor no permite exec";
+        return nullptr;
+    }
+    return ch;
+}
+
+// Remote stderr of a tar channel, forwarded as "tar: <path>: <message>" lines. It shares
+// the channel window with the archive, so it is drained while the stream runs, not after.
+namespace {
+class StderrForwarder {
+public:
+    StderrForwarder(LIBSSH2_SESSION* session, LIBSSH2_CHANNEL* ch, const SftpClient::TreeFileErrorCB& fileError)
+        : session_(session), ch_(ch), fileError_(fileError) {}
+
+    // Take what has already arrived, without waiting
+    void poll() {
+        libssh2_session_set_blocking(session_, 0);
+        read();
+        libssh2_session_set_blocking(session_, 1);
+    }
+    // Read up to EOF (the remote command is done or its stdin was closed). Returns the
+    // number of lines reported.
+    int finish() {
+        read();
+        forward(true);
+        return reported_;
+    }
+    const std::string& lastMessage() const { return last_; }
+
+private:
+    LIBSSH2_SESSION* session_;
+    LIBSSH2_CHANNEL* ch_;
+    const SftpClient::TreeFileErrorCB& fileError_;
+    std::string pending_;
+    std::string last_;
+    int reported_ = 0;
+
+    void read() {
+        char buf[4096];
+        while (true) {
+            ssize_t n = libssh2_channel_read_stderr(ch_, buf, sizeof(buf));
+            if (n <= 0) break;
+            pending_.append(buf, (size_t)n);
+        }
+        forward(false);
+    }
+    // Forward complete lines (and the trailing partial one when "all")
+    void forward(bool all) {
+        std::size_t pos = 0;
+        while (pos < pending_.size()) {
+            std::size_t nl = pending_.find('\n', pos);
+            if (nl == std::string::npos) {
+                if (!all) break;
+                nl = pending_.size();
+            }
+            std::string line = pending_.substr(pos, nl - pos);
+            pos = nl + 1;
+            if (line.empty()) continue;
+            if (line.find("Exiting with failure status") != std::string::npos) continue;
+            if (line.rfind("tar: ", 0) == 0) line.erase(0, 5);
+            last_ = line;
+            std::string path, msg = line;
+            const std::size_t sep = line.find(": ");
+            if (sep != std::string::npos) {
+                path = line.substr(0, sep);
+                msg = line.substr(sep + 2);
+            }
+            if (fileError_) fileError_(path, msg);
+            ++reported_;
+        }
+        pending_.erase(0, std::min(pos, pending_.size()));
+    }
+};
+} // namespace
+
+// Run a short command and capture its stdout. Returns the exit status (or -1).
+static int execCapture(LIBSSH2_SESSION* session, const std::string& cmd, std::string& out) {
+    std::string err;
+    LIBSSH2_CHANNEL* ch = openExec(session, cmd, err);
+    if (!ch) return -1;
+    // Nothing to send: a command that reads stdin (a forced sftp-server) must not wait on it
+    libssh2_channel_send_eof(ch);
+    char buf[1024];
+    while (true) {
+        ssize_t n = libssh2_channel_read(ch, buf, sizeof(buf));
+        if (n <= 0) break;
+        out.append(buf, (size_t)n);
+    }
+    libssh2_channel_wait_closed(ch);
+    const int status = libssh2_channel_get_exit_status(ch);
+    libssh2_channel_free(ch);
+    return status;
+}
+
+bool Libssh2SftpClient::execTreeAvailable() {
+    if (!connected_ || !session_) return false;
+    if (treeExec_ < 0) {
+        std::string out;
+        treeExec_ = (execCapture(session_, "command -v tar", out) == 0 && !out.empty()) ? 1 : 0;
+    }
+    return treeExec_ == 1;
+}
+
+bool Libssh2SftpClient::remoteIdentity(RemoteIdentity& out, std::string& err) {
+    if (!connected_ || !session_) {
+        err = "No conectado";
+        return false;
+    }
+    if (!identityKnown_) {
+        RemoteIdentity id;
+        std::string text;
+        bool ok = false;
+        if (execCapture(session_, "id -u && id -G", text) == 0) {
+            // Line 1: uid. Line 2: all group ids.
+            std::istringstream in(text);
+            std::string line;
+            if (std::getline(in, line) && !line.empty()) {
+                id.uid = (std::uint32_t)std::strtoul(line.c_str(), nullptr, 10);
+                if (std::getline(in, line)) {
+                    std::istringstream gs(line);
+                    unsigned long g;
+                    while (gs >> g) id.gids.push_back((std::uint32_t)g);
+                }
+                ok = !id.gids.empty();
+            }
+        }
+        if (!ok) {
+            // No exec (SFTP-only accounts): the owner of the login directory is probably the
+            // user; supplementary groups stay unknown
+            FileInfo home{};
+            std::string serr;
+            if (!stat(".", home, serr) || home.mode == 0) {
+                err = "No se pudo determinar el usuario remoto";
+                return false;
+            }
+            id.uid = home.uid;
+            id.gids = { home.gid };
+            id.exact = false;
+        }
+        identity_ = std::move(id);
+        identityKnown_ = true;
+    }
+    out = identity_;
+    return true;
+}
+
+bool Libssh2SftpClient::getTree(const std::string& remote_dir,
+                                const std::string& local_dir,
+                                std::string& err,
+                                std::function<void(std::size_t, std::size_t)> progress,
+                                TreeFileErrorCB fileError,
+                                std::function<bool()> shouldCancel) {
+    if (!connected_ || !session_) {
+        err = "No conectado";
+        return false;
+    }
+
+    // Approximate total for progress (du -k is POSIX); unknown if it fails
+    std::size_t total = 0;
+    {
+        std::string out;
+        if (execCapture(session_, "du -sk -- " + shellQuote(remote_dir), out) == 0)
+            total = (std::size_t)std::strtoull(out.c_str(), nullptr, 10) * 1024;
+    }
+
+    std::error_code ec;
+    fs::create_directories(local_dir, ec);
+    if (ec) {
+        err = "No se pudo crear la carpeta local: " + local_dir;
+        return false;
+    }
+
+    LIBSSH2_CHANNEL* ch = openExec(session_, "tar -cf - -C " + shellQuote(remote_dir) + " .", err);
+    if (!ch) return false;
+
+    TarExtractor tar(local_dir, fileError);
+    StderrForwarder errs(session_, ch, fileError);
+    std::vector<char> buf(256 * 1024);
+    while (true) {
+        if (shouldCancel && shouldCancel()) {
+            libssh2_channel_free(ch);
+            err = "Cancelado por usuario";
+            return false;
+        }
+        ssize_t n = libssh2_channel_read(ch, buf.data(), buf.size());
+        if (n > 0) {
+            if (!tar.feed(buf.data(), (std::size_t)n, err)) {
+                libssh2_channel_free(ch);
+                return false;
+            }
+            if (progress) {
+                const std::size_t done = (std::size_t)tar.bytesWritten();
+                progress(done, std::max(total, done));
+            }
+            errs.poll();
+        } else if (n == 0) {
+            break; // EOF
+        } else {
+            libssh2_channel_free(ch);
+            err = "Lectura remota falló";
+            return false;
+        }
+    }
+
+    errs.finish();
+    libssh2_channel_wait_closed(ch);
+    const int status = libssh2_channel_get_exit_status(ch);
+    libssh2_channel_free(ch);
+    // Per-file problems are on fileError; a cut-short archive fails the whole transfer
+    if (!tar.finished()) {
+        err = status != 0 ? "tar remoto terminó con error" : "Flujo tar incompleto";
+        return false;
+    }
+    return true;
+}
+
+bool Libssh2SftpClient::putTree(const std::string& local_dir,
+                                const std::string& remote_dir,
+                                std::string& err,
+                                std::function<void(std::size_t, std::size_t)> progress,
+                                TreeFileErrorCB fileError,
+                                std::function<bool()> shouldCancel) {
+    if (!connected_ || !session_) {
+        err = "No conectado";
+        return false;
+    }
+
+    // Collect the tree first so progress has a real total
+    struct Entry {
+        std::string rel, path;
+        bool dir = false;
+        std::uint64_t size = 0;
+        std::uint32_t mode = 0;
+        std::uint64_t mtime = 0;
+    };
+    std::vector<Entry> entries;
+    std::size_t total = 0;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(local_dir, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        err = "No se pudo leer la carpeta local: " + local_dir;
+        return false;
+    }
+    for (; it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        const fs::directory_entry& de = *it;
+        Entry e;
+        e.rel = fs::relative(de.path(), local_dir, ec).generic_string();
+        e.path = de.path().string();
+        if (de.is_symlink(ec)) {
+            if (fileError) fileError(e.rel, "Enlace simbólico omitido");
+            continue;
+        }
+        const fs::file_status st = de.status(ec);
+        e.mode = (std::uint32_t)st.permissions() & 0777;
+        const auto ft = de.last_write_time(ec);
+        if (!ec) {
+            const auto sys = std::chrono::file_clock::to_sys(ft);
+            const auto secs = std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count();
+            e.mtime = secs > 0 ? (std::uint64_t)secs : 0;
+        }
+        if (fs::is_directory(st)) {
+            e.dir = true;
+        } else if (fs::is_regular_file(st)) {
+            e.size = de.file_size(ec);
+            total += (std::size_t)e.size;
+        } else {
+            if (fileError) fileError(e.rel, "Tipo de entrada no soportado; omitida");
+            continue;
+        }
+        entries.push_back(std::move(e));
+    }
+
+    const std::string q = shellQuote(remote_dir);
+    LIBSSH2_CHANNEL* ch = openExec(session_, "mkdir -p -- " + q + " && tar -xf - -C " + q, err);
+    if (!ch) return false;
+
+    StderrForwarder errs(session_, ch, fileError);
+    bool writeFailed = false;
+    auto sink = [&](const char* p, std::size_t n) -> bool {
+        while (n > 0) {
+            ssize_t w = libssh2_channel_write(ch, p, n);
+            if (w <= 0) { writeFailed = true; return false; }
+            p += w;
+            n -= (std::size_t)w;
+        }
+        errs.poll();
+        return true;
+    };
+    // The remote tar stopped reading (disk full, mkdir failed...): its stderr says why
+    auto remoteFailure = [&] {
+        libssh2_channel_send_eof(ch);
+        errs.finish();
+        err = errs.lastMessage().empty() ? "Escritura remota falló" : "tar remoto: " + errs.lastMessage();
+    };
+    TarWriter tar(sink);
+    std::size_t done = 0;
+    auto onBytes = [&](std::size_t n) {
+        done += n;
+        if (progress && total) progress(done, total);
+    };
+    for (const auto& e : entries) {
+        bool ok = e.dir ? tar.addDirectory(e.rel, e.mode, e.mtime)
+                        : tar.addFile(e.rel, e.path, e.size, e.mode, e.mtime, onBytes, shouldCancel, fileError, err);
+        if (!ok) {
+            if (writeFailed) remoteFailure();
+            else if (err.empty()) err = "Escritura remota falló";
+            libssh2_channel_free(ch);
+            return false;
+        }
+    }
+    if (!tar.finish()) {
+        remoteFailure();
+        libssh2_channel_free(ch);
+        return false;
+    }
+
+    libssh2_channel_send_eof(ch);
+    libssh2_channel_wait_eof(ch);
+    const int reported = errs.finish();
+    libssh2_channel_wait_closed(ch);
+    const int status = libssh2_channel_get_exit_status(ch);
+    libssh2_channel_free(ch);
+    if (status != 0 && reported == 0) {
+        err = "tar remoto terminó con error";
+        return false;
+    }
+    return true;
+}
+
+} // namespace openscp
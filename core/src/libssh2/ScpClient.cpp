@@ -0,0 +1,165 @@
+// SCP get/put using libssh2_scp_recv2 / libssh2_scp_send64 (blocking session).
+#include "openscp/ScpClient.hpp"
+#include <libssh2.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace openscp {
+
+// The server would not open the channel or run scp at all, as opposed to a
+// per-file failure (missing file, permission denied) reported by a running scp
+static bool channelRefused(LIBSSH2_SESSION* session) {
+    const int rc = libssh2_session_last_errno(session);
+    return rc == LIBSSH2_ERROR_CHANNEL_FAILURE || rc == LIBSSH2_ERROR_CHANNEL_REQUEST_DENIED;
+}
+
+bool ScpClient::get(const std::string& remote,
+                    const std::string& local,
+                    std::string& err,
+                    const std::function<void(std::size_t, std::size_t)>& progress,
+                    const std::function<bool()>& shouldCancel) {
+    channelFailed_ = false;
+    noData_ = true;
+    if (!session_) {
+        err = "No conectado";
+        return false;
+    }
+
+    libssh2_struct_stat sb{};
+    LIBSSH2_CHANNEL* ch = libssh2_scp_recv2(session_, remote.c_str(), &sb);
+    if (!ch) {
+        channelFailed_ = channelRefused(session_);
+        err = "scp_recv falló para: " + remote;
+        return false;
+    }
+    const std::size_t total = sb.st_size > 0 ? (std::size_t)sb.st_size : 0;
+
+    FILE* lf = std::fopen(local.c_str(), "wb");
+    if (!lf) {
+        libssh2_channel_free(ch);
+        err = "No se pudo abrir archivo local para escribir";
+        return false;
+    }
+
+    const std::size_t CHUNK = 256 * 1024;
+    std::vector<char> buf(CHUNK);
+    std::size_t done = 0;
+    while (done < total) {
+        if (shouldCancel && shouldCancel()) {
+            err = "Cancelado por usuario";
+            std::fclose(lf);
+            libssh2_channel_free(ch);
+            return false;
+        }
+        // Never read past the file payload: SCP appends a status byte
+        const std::size_t want = std::min(CHUNK, total - done);
+        ssize_t n = libssh2_channel_read(ch, buf.data(), want);
+        if (n > 0) {
+            if (std::fwrite(buf.data(), 1, (size_t)n, lf) != (size_t)n) {
+                err = "Escritura local falló";
+                std::fclose(lf);
+                libssh2_channel_free(ch);
+                return false;
+            }
+            done += (std::size_t)n;
+            noData_ = false;
+            if (progress && total) progress(done, total);
+        } else {
+            err = (n == 0) ? "scp: fin de datos inesperado" : "Lectura remota falló";
+            std::fclose(lf);
+            libssh2_channel_free(ch);
+            return false;
+        }
+    }
+
+    std::fclose(lf);
+    libssh2_channel_free(ch);
+    return true;
+}
+
+bool ScpClient::put(const std::string& local,
+                    const std::string& remote,
+                    std::string& err,
+                    const std::function<void(std::size_t, std::size_t)>& progress,
+                    const std::function<bool()>& shouldCancel,
+                    unsigned int mode) {
+    channelFailed_ = false;
+    noData_ = true;
+    if (!session_) {
+        err = "No conectado";
+        return false;
+    }
+
+    FILE* lf = std::fopen(local.c_str(), "rb");
+    if (!lf) {
+        err = "No se pudo abrir archivo local para lectura";
+        return false;
+    }
+    std::fseek(lf, 0, SEEK_END);
+    long fsz = std::ftell(lf);
+    std::fseek(lf, 0, SEEK_SET);
+    const std::size_t total = fsz > 0 ? (std::size_t)fsz : 0;
+
+    LIBSSH2_CHANNEL* ch = libssh2_scp_send64(session_, remote.c_str(), (int)(mode & 0777),
+                                             (libssh2_int64_t)total, 0, 0);
+    if (!ch) {
+        std::fclose(lf);
+        channelFailed_ = channelRefused(session_);
+        err = "scp_send falló para: " + remote;
+        return false;
+    }
+
+    const std::size_t CHUNK = 256 * 1024;
+    std::vector<char> buf(CHUNK);
+    std::size_t done = 0;
+    while (true) {
+        size_t n = std::fread(buf.data(), 1, buf.size(), lf);
+        if (n == 0) {
+            if (std::ferror(lf)) {
+                err = "Lectura local falló";
+                std::fclose(lf);
+                libssh2_channel_free(ch);
+                return false;
+            }
+            break; // EOF
+        }
+        char* p = buf.data();
+        size_t remain = n;
+        while (remain > 0) {
+            if (shouldCancel && shouldCancel()) {
+                err = "Cancelado por usuario";
+                std::fclose(lf);
+                libssh2_channel_free(ch);
+                return false;
+            }
+            ssize_t w = libssh2_channel_write(ch, p, remain);
+            if (w <= 0) { // a blocking session that writes nothing would spin forever
+                err = "Escritura remota falló";
+                std::fclose(lf);
+                libssh2_channel_free(ch);
+                return false;
+            }
+            remain -= (size_t)w;
+            p += w;
+            done += (size_t)w;
+            noData_ = false;
+            if (progress && total) progress(done, total);
+        }
+    }
+    std::fclose(lf);
+
+    // Flush and wait for the remote scp to acknowledge the file
+    libssh2_channel_send_eof(ch);
+    libssh2_channel_wait_eof(ch);
+    libssh2_channel_wait_closed(ch);
+    const int status = libssh2_channel_get_exit_status(ch);
+    libssh2_channel_free(ch);
+    if (status != 0) {
+        err = "scp remoto terminó con error";
+        return false;
+    }
+    return true;
+}
+
+} // namespace openscp
@@ -0,0 +1,88 @@
+// Entropy sampling and extension heuristics for adaptive compression.
+#include "openscp/Compressibility.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace openscp {
+
+// Files below this size gain nothing from a second (compressed) session
+static constexpr std::size_t kMinCompressibleSize = 64 * 1024;
+// Sample up to this many blocks from the start of the file
+static constexpr std::size_t kSampleBlock = 16 * 1024;
+static constexpr int kSampleBlocks = 4;
+// zlib typically wins clearly below ~6.5 bits/byte (text, logs, dumps)
+static constexpr double kEntropyThreshold = 6.5;
+
+double byteEntropy(const unsigned char* data, std::size_t len) {
+    if (!data || len == 0) return 0.0;
+    std::array<std::size_t, 256> freq{};
+    for (std::size_t i = 0; i < len; ++i) ++freq[data[i]];
+    double h = 0.0;
+    const double n = double(len);
+    for (std::size_t c : freq) {
+        if (!c) continue;
+        const double p = double(c) / n;
+        h -= p * std::log2(p);
+    }
+    return h;
+}
+
+bool hasCompressedExtension(const std::string& name) {
+    static const char* kExts[] = {
+        "gz", "tgz", "bz2", "tbz2", "xz", "txz", "zst", "lz4", "lzma", "7z", "zip", "rar", "jar", "apk",
+        "jpg", "jpeg", "png", "gif", "webp", "heic", "avif",
+        "mp3", "aac", "ogg", "opus", "flac", "m4a",
+        "mp4", "mkv", "mov", "avi", "webm", "m4v",
+        "pdf", "docx", "xlsx", "pptx", "odt", "ods", "odp", "deb", "rpm", "dmg", "iso"
+    };
+    const auto dot = name.find_last_of('.');
+    if (dot == std::string::npos || dot + 1 >= name.size()) return false;
+    std::string ext = name.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    for (const char* e : kExts)
+        if (ext == e) return true;
+    return false;
+}
+
+bool localFileLooksCompressible(const std::string& path) {
+    if (hasCompressedExtension(path)) return false;
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    const long sz = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    if (sz < (long)kMinCompressibleSize) {
+        std::fclose(f);
+        return false;
+    }
+    std::vector<unsigned char> buf(kSampleBlock * kSampleBlocks);
+    const std::size_t n = std::fread(buf.data(), 1, buf.size(), f);
+    std::fclose(f);
+    if (n == 0) return false;
+    return byteEntropy(buf.data(), n) < kEntropyThreshold;
+}
+
+bool remoteNameLooksCompressible(const std::string& name) {
+    static const char* kExts[] = {
+        "log", "txt", "csv", "tsv", "sql", "json", "xml", "html", "htm", "css", "js", "md",
+        "yaml", "yml", "ini", "conf", "cfg", "out", "dump", "tar", "svg", "c", "cpp", "h", "hpp", "py"
+    };
+    if (hasCompressedExtension(name)) return false;
+    const auto slash = name.find_last_of('/');
+    const std::string base = (slash == std::string::npos) ? name : name.substr(slash + 1);
+    // Rotated logs such as "syslog.1" or "app.log.3"
+    if (base.find(".log") != std::string::npos) return true;
+    const auto dot = base.find_last_of('.');
+    if (dot == std::string::npos || dot + 1 >= base.size()) return false;
+    std::string ext = base.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    for (const char* e : kExts)
+        if (ext == e) return true;
+    return false;
+}
+
+} // namespace openscp
@@ -0,0 +1,77 @@
+// Structure-of-arrays directory listing with a shared name arena.
+#include "openscp/DirListing.hpp"
+
+namespace openscp {
+
+void DirListing::clear() {
+    names_.clear();
+    nameOff_.clear();
+    nameLen_.clear();
+    flags_.clear();
+    size_.clear();
+    mtime_.clear();
+    mode_.clear();
+    uid_.clear();
+    gid_.clear();
+}
+
+void DirListing::reserve(std::size_t n, std::size_t nameBytes) {
+    nameOff_.reserve(n);
+    nameLen_.reserve(n);
+    flags_.reserve(n);
+    size_.reserve(n);
+    mtime_.reserve(n);
+    mode_.reserve(n);
+    uid_.reserve(n);
+    gid_.reserve(n);
+    if (nameBytes) names_.reserve(nameBytes);
+}
+
+void DirListing::shrinkToFit() {
+    names_.shrink_to_fit();
+    nameOff_.shrink_to_fit();
+    nameLen_.shrink_to_fit();
+    flags_.shrink_to_fit();
+    size_.shrink_to_fit();
+    mtime_.shrink_to_fit();
+    mode_.shrink_to_fit();
+    uid_.shrink_to_fit();
+    gid_.shrink_to_fit();
+}
+
+void DirListing::push(std::string_view name, bool isDir, bool hasSize, std::uint64_t size,
+                      std::uint64_t mtime, std::uint32_t mode, std::uint32_t uid, std::uint32_t gid) {
+    nameOff_.push_back(names_.size());
+    nameLen_.push_back((std::uint32_t)name.size());
+    names_.append(name.data(), name.size());
+    flags_.push_back((std::uint8_t)((isDir ? kDir : 0) | (hasSize ? kHasSize : 0)));
+    size_.push_back(hasSize ? size : 0);
+    mtime_.push_back(mtime);
+    mode_.push_back(mode);
+    uid_.push_back(uid);
+    gid_.push_back(gid);
+}
+
+FileInfo DirListing::at(std::size_t i) const {
+    FileInfo fi{};
+    fi.name = std::string(name(i));
+    fi.is_dir = isDir(i);
+    fi.has_size = hasSize(i);
+    fi.size = size_[i];
+    fi.mtime = mtime_[i];
+    fi.mode = mode_[i];
+    fi.uid = uid_[i];
+    fi.gid = gid_[i];
+    return fi;
+}
+
+std::size_t DirListing::memoryBytes() const {
+    return names_.capacity()
+         + nameOff_.capacity() * sizeof(std::uint64_t)
+         + nameLen_.capacity() * sizeof(std::uint32_t)
+         + flags_.capacity()
+         + (size_.capacity() + mtime_.capacity()) * sizeof(std::uint64_t)
+         + (mode_.capacity() + uid_.capacity() + gid_.capacity()) * sizeof(std::uint32_t);
+}
+
+} // namespace openscp
@@ -0,0 +1,24 @@
+// Disk space helpers (see FileSpace.hpp).
+#include "openscp/FileSpace.hpp"
+#include <cerrno>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace openscp {
+
+int reserveFileSpace(int fd, std::uint64_t bytes) {
+#if defined(__linux__)
+    // Reserve the blocks now: a full disk fails here instead of faulting a mapping
+    return ::posix_fallocate(fd, 0, (off_t)bytes);
+#elif !defined(_WIN32)
+    return ::ftruncate(fd, (off_t)bytes) == 0 ? 0 : errno;
+#else
+    (void)fd;
+    (void)bytes;
+    return ENOSYS;
+#endif
+}
+
+} // namespace openscp
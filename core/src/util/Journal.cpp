@@ -0,0 +1,257 @@
+// Crash-safe record log (see Journal.hpp). File layout: 8-byte magic, 8 reserved bytes,
+// then records of u32 length + u32 CRC-32 (host order) + payload. Unused space is zero.
+#include "openscp/Journal.hpp"
+#include "openscp/FileSpace.hpp"
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace openscp {
+
+static constexpr char kMagic[8] = { 'O', 'S', 'C', 'P', 'J', 'R', 'N', '1' };
+static constexpr std::size_t kHeaderBytes = 16;
+static constexpr std::size_t kRecordHead = 2 * sizeof(std::uint32_t);
+static constexpr std::size_t kInitialBytes = 1u << 20;
+
+static constexpr std::array<std::uint32_t, 256> makeCrcTable() {
+    std::array<std::uint32_t, 256> t{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        t[i] = c;
+    }
+    return t;
+}
+static constexpr auto kCrcTable = makeCrcTable();
+
+static std::uint32_t crc32(std::string_view data) {
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (unsigned char b : data) c = kCrcTable[(c ^ b) & 0xFFu] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+// Valid records of data[kHeaderBytes, size): returns where they end. tornEnd is past a
+// record cut short by a crash (to be cleared), or the end itself.
+static std::size_t scanRecords(const char* data, std::size_t size,
+                               const std::function<void(std::string_view)>& replay,
+                               std::uint64_t& count, std::size_t& tornEnd) {
+    std::size_t pos = kHeaderBytes;
+    count = 0;
+    tornEnd = pos;
+    while (size - pos >= kRecordHead) {
+        std::uint32_t len = 0, crc = 0;
+        std::memcpy(&len, data + pos, sizeof(len));
+        std::memcpy(&crc, data + pos + sizeof(len), sizeof(crc));
+        if (len == 0 && crc == 0) break; // unused space
+        const std::size_t avail = size - pos - kRecordHead;
+        const std::string_view rec(data + pos + kRecordHead, len <= avail ? len : avail);
+        if (len > avail || crc32(rec) != crc) {
+            tornEnd = pos + kRecordHead + rec.size();
+            return pos;
+        }
+        if (replay) replay(rec);
+        ++count;
+        pos += kRecordHead + len;
+    }
+    tornEnd = pos;
+    return pos;
+}
+
+Journal::~Journal() { close(); }
+
+void Journal::close() {
+#if !defined(_WIN32)
+    if (base_) ::munmap(base_, cap_);
+    if (fd_ >= 0) ::close(fd_);
+#else
+    if (file_) std::fclose((std::FILE*)file_);
+#endif
+    fd_ = -1;
+    base_ = nullptr;
+    file_ = nullptr;
+    cap_ = used_ = flushed_ = 0;
+    records_ = 0;
+}
+
+bool Journal::map(std::size_t cap, std::string& err) {
+#if !defined(_WIN32)
+    if (base_) {
+        ::munmap(base_, cap_);
+        base_ = nullptr;
+    }
+    struct stat st{};
+    if (::fstat(fd_, &st) == 0 && (std::size_t)st.st_size < cap) {
+        const int rc = reserveFileSpace(fd_, cap);
+        if (rc != 0) {
+            err = std::string("Sin espacio para el diario: ") + std::strerror(rc);
+            return false;
+        }
+    }
+    void* m = ::mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (m == MAP_FAILED) {
+        err = std::string("No se pudo mapear el diario: ") + std::strerror(errno);
+        return false;
+    }
+    base_ = static_cast<char*>(m);
+    cap_ = cap;
+    return true;
+#else
+    (void)cap;
+    (void)err;
+    return true;
+#endif
+}
+
+bool Journal::open(const std::string& file, const std::function<void(std::string_view)>& replay, std::string& err) {
+    close();
+    path_ = file;
+    std::size_t tornEnd = 0;
+#if !defined(_WIN32)
+    fd_ = ::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        err = std::string("No se pudo abrir el diario: ") + std::strerror(errno);
+        return false;
+    }
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) {
+        err = std::string("No se pudo abrir el diario: ") + std::strerror(errno);
+        close();
+        return false;
+    }
+    const std::size_t size = (std::size_t)st.st_size;
+    const bool fresh = size == 0;
+    if ((!fresh && size < kHeaderBytes) || !map(fresh ? kInitialBytes : size, err)) {
+        if (err.empty()) err = "No es un diario de OpenSCP: " + file;
+        close();
+        return false;
+    }
+    if (fresh) {
+        std::memcpy(base_, kMagic, sizeof(kMagic));
+    } else if (std::memcmp(base_, kMagic, sizeof(kMagic)) != 0) {
+        err = "No es un diario de OpenSCP: " + file;
+        close();
+        return false;
+    }
+    used_ = scanRecords(base_, cap_, replay, records_, tornEnd);
+    // Clear a record cut short by a crash so the next appends start on clean space
+    if (tornEnd > used_) std::memset(base_ + used_, 0, tornEnd - used_);
+    flushed_ = fresh ? 0 : used_;
+#else
+    std::FILE* f = std::fopen(file.c_str(), "r+b");
+    if (!f) f = std::fopen(file.c_str(), "w+b");
+    if (!f) {
+        err = "No se pudo abrir el diario: " + file;
+        return false;
+    }
+    file_ = f;
+    std::vector<char> data;
+    char buf[1 << 16];
+    for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) data.insert(data.end(), buf, buf + n);
+    if (data.empty()) {
+        data.assign(kHeaderBytes, '\0');
+        std::memcpy(data.data(), kMagic, sizeof(kMagic));
+        std::fseek(f, 0, SEEK_SET);
+        std::fwrite(data.data(), 1, data.size(), f);
+    } else if (data.size() < kHeaderBytes || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+        err = "No es un diario de OpenSCP: " + file;
+        close();
+        return false;
+    }
+    used_ = scanRecords(data.data(), data.size(), replay, records_, tornEnd);
+    if (tornEnd > used_) {
+        const std::vector<char> zero(tornEnd - used_, '\0');
+        std::fseek(f, (long)used_, SEEK_SET);
+        std::fwrite(zero.data(), 1, zero.size(), f);
+    }
+    flushed_ = used_;
+#endif
+    return true;
+}
+
+bool Journal::append(std::string_view rec, std::string& err) {
+    if (!isOpen()) {
+        err = "Diario cerrado";
+        return false;
+    }
+    const std::size_t need = kRecordHead + rec.size();
+    const std::uint32_t len = (std::uint32_t)rec.size();
+    const std::uint32_t crc = crc32(rec);
+#if !defined(_WIN32)
+    if (cap_ - used_ < need) {
+        std::size_t cap = cap_ * 2;
+        while (cap - used_ < need) cap *= 2;
+        if (!map(cap, err)) {
+            close(); // the old mapping is gone
+            return false;
+        }
+    }
+    char* p = base_ + used_;
+    std::memcpy(p + kRecordHead, rec.data(), rec.size());
+    std::memcpy(p + sizeof(len), &crc, sizeof(crc));
+    std::memcpy(p, &len, sizeof(len)); // last: the record exists once it is complete
+#else
+    auto* f = (std::FILE*)file_;
+    if (std::fseek(f, (long)used_, SEEK_SET) != 0 || std::fwrite(&len, sizeof(len), 1, f) != 1
+        || std::fwrite(&crc, sizeof(crc), 1, f) != 1
+        || (!rec.empty() && std::fwrite(rec.data(), rec.size(), 1, f) != 1)) {
+        err = "No se pudo escribir el diario";
+        return false;
+    }
+#endif
+    used_ += need;
+    ++records_;
+    return true;
+}
+
+void Journal::flush(bool wait) {
+    if (!isOpen() || used_ == flushed_) return;
+#if !defined(_WIN32)
+    static const std::size_t page = (std::size_t)::sysconf(_SC_PAGESIZE);
+    const std::size_t from = flushed_ / page * page;
+    ::msync(base_ + from, used_ - from, wait ? MS_SYNC : MS_ASYNC);
+#else
+    (void)wait;
+    std::fflush((std::FILE*)file_);
+#endif
+    flushed_ = used_;
+}
+
+bool Journal::compact(const std::function<void(const Emit&)>& produce, std::string& err) {
+    const std::string file = path_;
+    const std::string tmp = file + ".tmp";
+    std::remove(tmp.c_str());
+    {
+        Journal next;
+        if (!next.open(tmp, {}, err)) return false;
+        bool ok = true;
+        produce([&](std::string_view rec) { return ok = ok && next.append(rec, err); });
+        if (!ok) {
+            next.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+        next.flush(true);
+    }
+    close();
+    std::error_code ec;
+    std::filesystem::rename(tmp, file, ec); // replaces the old log atomically
+    if (ec) {
+        err = "No se pudo compactar el diario: " + ec.message();
+        std::remove(tmp.c_str());
+        std::string rerr;
+        open(file, {}, rerr);
+        return false;
+    }
+    return open(file, {}, err);
+}
+
+} // namespace openscp
@@ -0,0 +1,220 @@
+// Local folder scan for uploads (see LocalTreeScanner.hpp).
+#include "openscp/LocalTreeScanner.hpp"
+#include <cstring>
+#include <vector>
+#if defined(__linux__)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+#endif
+
+namespace openscp {
+
+static bool isHiddenName(const char* name) { return name[0] == '.'; }
+
+#if defined(__linux__)
+
+namespace {
+
+struct PendingDir {
+    std::string path;
+    std::string rel;
+};
+
+struct DirEnt {
+    std::string name;
+    unsigned char type;
+};
+
+enum class Kind { Other, File, Dir };
+
+// Type (and size/mtime) of "name" inside the open directory dirfd. statx asks only for
+// the fields needed and never forces a sync on network file systems.
+Kind statAt(int dirfd, const char* name, bool follow, bool wantTimes,
+            std::uint64_t& size, std::int64_t& mtime) {
+#ifdef STATX_SIZE
+    struct statx sx;
+    const unsigned mask = STATX_TYPE | STATX_SIZE | (wantTimes ? STATX_MTIME : 0u);
+    const int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+    if (::statx(dirfd, name, flags, mask, &sx) != 0) return Kind::Other;
+    const unsigned mode = sx.stx_mode;
+    size = sx.stx_size;
+    mtime = sx.stx_mtime.tv_sec;
+#else
+    struct stat st;
+    if (::fstatat(dirfd, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) return Kind::Other;
+    const unsigned mode = st.st_mode;
+    size = (std::uint64_t)st.st_size;
+    mtime = (std::int64_t)st.st_mtime;
+#endif
+    if (S_ISREG(mode)) return Kind::File;
+    if (S_ISDIR(mode)) return Kind::Dir;
+    return Kind::Other;
+}
+
+// All entries of an open directory through raw getdents64 (one syscall per 64 KiB of
+// names, d_type included)
+bool readDirEntries(int fd, std::vector<char>& buf, std::vector<DirEnt>& out) {
+    // struct linux_dirent64 { u64 d_ino; s64 d_off; u16 d_reclen; u8 d_type; char d_name[]; }
+    constexpr std::size_t kRecLenOff = 16, kTypeOff = 18, kNameOff = 19;
+    for (;;) {
+        const long n = ::syscall(SYS_getdents64, fd, buf.data(), buf.size());
+        if (n < 0) return false;
+        if (n == 0) return true;
+        for (long pos = 0; pos < n;) {
+            const char* rec = buf.data() + pos;
+            unsigned short reclen;
+            std::memcpy(&reclen, rec + kRecLenOff, sizeof(reclen));
+            const char* name = rec + kNameOff;
+            if (!(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))))
+                out.push_back(DirEnt{ name, (unsigned char)rec[kTypeOff] });
+            pos += reclen;
+        }
+    }
+}
+
+} // namespace
+
+bool scanLocalTree(const std::string& root,
+                   const LocalScanOptions& opt,
+                   const LocalFileCB& onFile,
+                   LocalScanStats& stats,
+                   std::string& err) {
+    auto cancelled = [&] { return opt.cancel && opt.cancel->load(std::memory_order_relaxed); };
+    const bool wantStat = opt.wantSize || opt.wantMtime;
+    std::vector<char> buf(64 * 1024);
+    std::vector<PendingDir> stack{ PendingDir{ root, std::string() } };
+    std::vector<DirEnt> ents;
+    std::vector<PendingDir> subdirs;
+    bool first = true;
+    while (!stack.empty()) {
+        if (cancelled()) { err = "Cancelado por usuario"; return false; }
+        PendingDir d = std::move(stack.back());
+        stack.pop_back();
+        const int fd = ::open(d.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            if (first) { err = std::string("No se pudo abrir la carpeta: ") + std::strerror(errno); return false; }
+            ++stats.errors;
+            continue;
+        }
+        first = false;
+        ++stats.dirs;
+        ents.clear();
+        if (!readDirEntries(fd, buf, ents)) ++stats.errors; // keep what was read
+        // Stat pass over the whole directory, relative to its fd (no path lookups)
+        subdirs.clear();
+        const std::string base = (!d.path.empty() && d.path.back() == '/') ? d.path : d.path + "/";
+        for (const DirEnt& e : ents) {
+            if (opt.skipHidden && isHiddenName(e.name.c_str())) continue;
+            std::uint64_t size = 0;
+            std::int64_t mtime = 0;
+            Kind kind = Kind::Other;
+            if (e.type == DT_DIR) {
+                kind = Kind::Dir;
+            } else if (e.type == DT_REG) {
+                kind = Kind::File;
+                if (wantStat && statAt(fd, e.name.c_str(), false, opt.wantMtime, size, mtime) != Kind::File) {
+                    ++stats.errors; // vanished or unreadable since getdents
+                    continue;
+                }
+            } else if (e.type == DT_LNK) {
+                // Links to files are uploaded as files; linked folders are not followed
+                if (statAt(fd, e.name.c_str(), true, opt.wantMtime, size, mtime) != Kind::File) continue;
+                kind = Kind::File;
+            } else if (e.type == DT_UNKNOWN) {
+                // Some file systems do not fill d_type
+                kind = statAt(fd, e.name.c_str(), false, opt.wantMtime, size, mtime);
+            }
+            if (kind == Kind::Other) continue;
+            const std::string rel = d.rel.empty() ? e.name : d.rel + "/" + e.name;
+            if (opt.rules && opt.rules->excluded(rel, kind == Kind::Dir)) {
+                ++stats.excluded;
+                continue;
+            }
+            if (kind == Kind::Dir) {
+                subdirs.push_back(PendingDir{ base + e.name, rel });
+            } else if (kind == Kind::File) {
+                LocalTreeFile f;
+                f.path = base + e.name;
+                f.rel = rel;
+                if (opt.wantSize) f.size = size;
+                if (opt.wantMtime) f.mtime = mtime;
+                ++stats.files;
+                stats.bytes += f.size;
+                if (onFile && !onFile(f)) {
+                    ::close(fd);
+                    err = "Cancelado por usuario";
+                    return false;
+                }
+            }
+        }
+        ::close(fd);
+        // Reverse so subfolders come off the stack in directory order
+        for (auto it = subdirs.rbegin(); it != subdirs.rend(); ++it) stack.push_back(std::move(*it));
+    }
+    return true;
+}
+
+#else // !__linux__
+
+bool scanLocalTree(const std::string& root,
+                   const LocalScanOptions& opt,
+                   const LocalFileCB& onFile,
+                   LocalScanStats& stats,
+                   std::string& err) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    const fs::path rootPath = fs::path(root);
+    fs::recursive_directory_iterator it(rootPath, fs::directory_options::skip_permission_denied, ec);
+    if (ec) { err = "No se pudo abrir la carpeta: " + ec.message(); return false; }
+    ++stats.dirs;
+    const std::size_t rootLen = rootPath.generic_string().size();
+    for (const fs::recursive_directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) { ++stats.errors; ec.clear(); continue; }
+        if (opt.cancel && opt.cancel->load(std::memory_order_relaxed)) { err = "Cancelado por usuario"; return false; }
+        const fs::directory_entry& e = *it;
+        const std::string name = e.path().filename().string();
+        if (opt.skipHidden && isHiddenName(name.c_str())) {
+            if (e.is_directory(ec)) it.disable_recursion_pending();
+            continue;
+        }
+        const bool isDir = e.is_directory(ec);
+        if (!isDir && !e.is_regular_file(ec)) continue;
+        const std::string full = e.path().generic_string();
+        const std::string rel = full.size() > rootLen ? full.substr(rootLen + (full[rootLen] == '/' ? 1 : 0)) : name;
+        if (opt.rules && opt.rules->excluded(rel, isDir && !e.is_symlink(ec))) {
+            ++stats.excluded;
+            if (isDir) it.disable_recursion_pending();
+            continue;
+        }
+        if (isDir) {
+            if (e.is_symlink(ec)) it.disable_recursion_pending(); // linked folders are not followed
+            else ++stats.dirs;
+            continue;
+        }
+        LocalTreeFile f;
+        f.path = e.path().string();
+        f.rel = rel;
+        if (opt.wantSize) f.size = (std::uint64_t)e.file_size(ec);
+        if (opt.wantMtime) {
+            const auto ft = e.last_write_time(ec);
+            const auto sys = std::chrono::system_clock::now() + (ft - fs::file_time_type::clock::now());
+            f.mtime = std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count();
+        }
+        ++stats.files;
+        stats.bytes += f.size;
+        if (onFile && !onFile(f)) { err = "Cancelado por usuario"; return false; }
+    }
+    return true;
+}
+
+#endif
+
+} // namespace openscp
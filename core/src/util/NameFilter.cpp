@@ -0,0 +1,164 @@
+// Glob compilation and matching for NameFilter.
+#include "openscp/NameFilter.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace openscp {
+
+// Index just past the UTF-8 character starting at i ('?' matches one character)
+static std::size_t nextChar(std::string_view s, std::size_t i) {
+    ++i;
+    while (i < s.size() && ((unsigned char)s[i] & 0xC0) == 0x80) ++i;
+    return i;
+}
+
+static bool isGlobText(std::string_view t) {
+    return t.find_first_of("*?[") != std::string_view::npos;
+}
+
+NameFilter::NameFilter(std::string_view text) {
+    if (!isGlobText(text)) {
+        // Plain text: substring search (surrounding blanks are not meaningful)
+        const auto b = text.find_first_not_of(' ');
+        const auto e = text.find_last_not_of(' ');
+        if (b != std::string_view::npos) needle_.assign(text.substr(b, e - b + 1));
+        return;
+    }
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        const std::size_t end = std::min(text.find_first_of(" ;", pos), text.size());
+        if (end > pos) globs_.push_back(compile(text.substr(pos, end - pos)));
+        pos = end + 1;
+    }
+}
+
+bool NameFilter::matches(std::string_view name) const {
+    if (!needle_.empty()) return name.find(needle_) != std::string_view::npos; // memchr-driven scan
+    if (globs_.empty()) return true;
+    for (const auto& g : globs_)
+        if (g.matches(name)) return true;
+    return false;
+}
+
+bool NameFilter::narrows(const NameFilter& prev) const {
+    if (prev.empty()) return true;
+    if (isGlob() || prev.isGlob()) return false;
+    return needle_.find(prev.needle_) != std::string::npos;
+}
+
+NameFilter::Glob NameFilter::compile(std::string_view p) {
+    Glob g;
+    for (std::size_t i = 0; i < p.size();) {
+        const char c = p[i];
+        if (c == '*') {
+            if (g.toks.empty() || g.toks.back().op != Glob::Op::Star) g.toks.push_back({ Glob::Op::Star });
+            ++i;
+        } else if (c == '?') {
+            g.toks.push_back({ Glob::Op::AnyChar });
+            ++g.minLen;
+            ++i;
+        } else if (c == '[' && p.find(']', i + 2) != std::string_view::npos) {
+            // [abc], [a-z], [!x] / [^x]; a ']' right after '[' (or the negation) is literal
+            std::bitset<256> set;
+            std::size_t j = i + 1;
+            const bool negate = (p[j] == '!' || p[j] == '^');
+            if (negate) ++j;
+            bool first = true;
+            while (j < p.size() && (p[j] != ']' || first)) {
+                const unsigned char lo = (unsigned char)p[j];
+                if (j + 2 < p.size() && p[j + 1] == '-' && p[j + 2] != ']') {
+                    const unsigned char hi = (unsigned char)p[j + 2];
+                    for (unsigned v = lo; v <= hi; ++v) set.set(v);
+                    j += 3;
+                } else {
+                    set.set(lo);
+                    ++j;
+                }
+                first = false;
+            }
+            if (j >= p.size()) { // unterminated: treat '[' literally
+                g.toks.push_back({ Glob::Op::Lit, (std::uint32_t)g.lits.size(), 1 });
+                g.lits.push_back('[');
+                ++g.minLen;
+                ++i;
+                continue;
+            }
+            if (negate) set.flip();
+            g.toks.push_back({ Glob::Op::Set, (std::uint32_t)g.sets.size() });
+            g.sets.push_back(set);
+            ++g.minLen;
+            i = j + 1;
+        } else {
+            // Run of literal bytes ('\' escapes the next character). The first byte is
+            // always taken: it may be a '[' with no closing ']'.
+            const std::uint32_t off = (std::uint32_t)g.lits.size();
+            const std::size_t start = i;
+            while (i < p.size() && (i == start || (p[i] != '*' && p[i] != '?' && p[i] != '['))) {
+                if (p[i] == '\\' && i + 1 < p.size()) ++i;
+                g.lits.push_back(p[i++]);
+            }
+            const std::uint32_t len = (std::uint32_t)g.lits.size() - off;
+            if (!g.toks.empty() && g.toks.back().op == Glob::Op::Lit) g.toks.back().b += len;
+            else g.toks.push_back({ Glob::Op::Lit, off, len });
+            g.minLen += len;
+        }
+    }
+
+    // Common shapes ("*.log", "build*", "*tmp*", "Makefile") get a direct test
+    using Op = Glob::Op;
+    const auto& t = g.toks;
+    auto lit = [&](const Glob::Tok& k) { return g.lits.substr(k.a, k.b); };
+    if (t.size() == 1 && t[0].op == Op::Lit) { g.shape = Glob::Shape::Exact; g.fixed = lit(t[0]); }
+    else if (t.size() == 2 && t[0].op == Op::Lit && t[1].op == Op::Star) { g.shape = Glob::Shape::Prefix; g.fixed = lit(t[0]); }
+    else if (t.size() == 2 && t[0].op == Op::Star && t[1].op == Op::Lit) { g.shape = Glob::Shape::Suffix; g.fixed = lit(t[1]); }
+    else if (t.size() == 3 && t[0].op == Op::Star && t[1].op == Op::Lit && t[2].op == Op::Star) { g.shape = Glob::Shape::Contains; g.fixed = lit(t[1]); }
+    return g;
+}
+
+bool NameFilter::Glob::matches(std::string_view s) const {
+    if (s.size() < minLen) return false;
+    switch (shape) {
+        case Shape::Exact:    return s == fixed;
+        case Shape::Prefix:   return s.compare(0, fixed.size(), fixed) == 0;
+        case Shape::Suffix:   return s.compare(s.size() - fixed.size(), fixed.size(), fixed) == 0;
+        case Shape::Contains: return s.find(fixed) != std::string_view::npos;
+        case Shape::General:  break;
+    }
+    // Greedy match with single-star backtracking: linear in practice, O(n*m) worst case
+    std::size_t ti = 0, i = 0;
+    std::size_t starTok = std::string::npos, starPos = 0;
+    while (i < s.size()) {
+        if (ti < toks.size()) {
+            const Tok& k = toks[ti];
+            bool ok = false;
+            switch (k.op) {
+                case Op::Star:
+                    starTok = ti++;
+                    starPos = i;
+                    continue;
+                case Op::Lit:
+                    ok = s.size() - i >= k.b && std::memcmp(s.data() + i, lits.data() + k.a, k.b) == 0;
+                    if (ok) i += k.b;
+                    break;
+                case Op::AnyChar:
+                    ok = true;
+                    i = nextChar(s, i);
+                    break;
+                case Op::Set:
+                    ok = sets[k.a].test((unsigned char)s[i]);
+                    if (ok) ++i;
+                    break;
+            }
+            if (ok) { ++ti; continue; }
+        }
+        if (starTok == std::string::npos) return false;
+        // Let the last star absorb one more character and retry after it
+        starPos = nextChar(s, starPos);
+        i = starPos;
+        ti = starTok + 1;
+    }
+    while (ti < toks.size() && toks[ti].op == Op::Star) ++ti;
+    return ti == toks.size();
+}
+
+} // namespace openscp
@@ -0,0 +1,148 @@
+// .gitignore-style rule parsing and matching (see PathRules.hpp).
+#include "openscp/PathRules.hpp"
+
+namespace openscp {
+
+// [...] class starting at p[i] against c. Sets "end" past the ']'. False if unterminated.
+static bool matchClass(std::string_view p, std::size_t i, unsigned char c, std::size_t& end, bool& hit) {
+    std::size_t j = i + 1;
+    const bool negate = j < p.size() && (p[j] == '!' || p[j] == '^');
+    if (negate) ++j;
+    bool first = true;
+    hit = false;
+    while (j < p.size() && (p[j] != ']' || first)) {
+        unsigned char lo = (unsigned char)p[j];
+        if (lo == '\\' && j + 1 < p.size()) lo = (unsigned char)p[++j];
+        if (j + 2 < p.size() && p[j + 1] == '-' && p[j + 2] != ']') {
+            const unsigned char hi = (unsigned char)p[j + 2];
+            if (c >= lo && c <= hi) hit = true;
+            j += 3;
+        } else {
+            if (c == lo) hit = true;
+            ++j;
+        }
+        first = false;
+    }
+    if (j >= p.size()) return false;
+    end = j + 1;
+    if (negate) hit = !hit;
+    return true;
+}
+
+// Glob match where '*', '?' and classes stay within one path segment and "**" spans
+// segments ("**/" also matches zero folders). Single stars backtrack greedily; "**"
+// tries each split point.
+static bool globMatch(std::string_view p, std::string_view s) {
+    std::size_t pi = 0, si = 0;
+    std::size_t starP = std::string_view::npos, starS = 0;
+    while (si < s.size() || pi < p.size()) {
+        if (pi < p.size()) {
+            const char c = p[pi];
+            if (c == '*' && pi + 1 < p.size() && p[pi + 1] == '*') {
+                std::size_t q = pi + 2;
+                if (q < p.size() && p[q] == '/') {
+                    const std::string_view rest = p.substr(q + 1);
+                    if (globMatch(rest, s.substr(si))) return true;
+                    for (std::size_t k = si; k < s.size(); ++k)
+                        if (s[k] == '/' && globMatch(rest, s.substr(k + 1))) return true;
+                    return false;
+                }
+                const std::string_view rest = p.substr(q);
+                for (std::size_t k = si; k <= s.size(); ++k)
+                    if (globMatch(rest, s.substr(k))) return true;
+                return false;
+            }
+            if (c == '*') {
+                starP = pi++;
+                starS = si;
+                continue;
+            }
+            if (si < s.size()) {
+                const char sc = s[si];
+                if (c == '?') {
+                    if (sc != '/') { ++pi; ++si; continue; }
+                } else if (c == '[') {
+                    std::size_t end = 0;
+                    bool hit = false;
+                    if (matchClass(p, pi, (unsigned char)sc, end, hit)) {
+                        if (hit && sc != '/') { pi = end; ++si; continue; }
+                    } else if (sc == '[') { // unterminated: literal '['
+                        ++pi; ++si; continue;
+                    }
+                } else {
+                    const bool esc = (c == '\\' && pi + 1 < p.size());
+                    if (sc == (esc ? p[pi + 1] : c)) { pi += esc ? 2 : 1; ++si; continue; }
+                }
+            }
+        }
+        // Mismatch: let the last single star absorb one more character of its segment
+        if (starP != std::string_view::npos && starS < s.size() && s[starS] != '/') {
+            pi = starP + 1;
+            si = ++starS;
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+static bool hasWildcards(std::string_view p) {
+    return p.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+void PathRules::add(std::string_view text) {
+    std::size_t pos = 0;
+    while (pos <= text.size()) {
+        std::size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        // Trailing blanks are not significant unless escaped
+        while (!line.empty() && line.back() == ' ' && !(line.size() >= 2 && line[line.size() - 2] == '\\'))
+            line.remove_suffix(1);
+        if (line.empty() || line.front() == '#') continue;
+        Rule r;
+        if (line.front() == '!') { r.negate = true; line.remove_prefix(1); }
+        if (!line.empty() && line.back() == '/') { r.dirOnly = true; line.remove_suffix(1); }
+        if (!line.empty() && line.front() == '/') { r.anchored = true; line.remove_prefix(1); }
+        // "**/name" is the same as "name"
+        while (line.size() > 3 && line.substr(0, 3) == "**/" && line.find('/', 3) == std::string_view::npos) {
+            line.remove_prefix(3);
+            r.anchored = false;
+        }
+        if (line.empty()) continue;
+        if (line.find('/') != std::string_view::npos) r.anchored = true;
+        r.pattern.assign(line);
+
+        const std::uint32_t idx = (std::uint32_t)rules_.size();
+        if (hasWildcards(r.pattern)) globs_.push_back(idx);
+        else (r.anchored ? byPath_ : byName_)[r.pattern].push_back(idx);
+        rules_.push_back(std::move(r));
+    }
+}
+
+bool PathRules::excluded(std::string_view rel, bool isDir) const {
+    if (rules_.empty() || rel.empty()) return false;
+    const std::size_t slash = rel.rfind('/');
+    const std::string_view name = slash == std::string_view::npos ? rel : rel.substr(slash + 1);
+    long best = -1;
+    auto consider = [&](const std::unordered_map<std::string, std::vector<std::uint32_t>>& m, std::string_view key) {
+        if (m.empty()) return;
+        auto it = m.find(std::string(key));
+        if (it == m.end()) return;
+        for (std::uint32_t i : it->second)
+            if ((long)i > best && (!rules_[i].dirOnly || isDir)) best = (long)i;
+    };
+    consider(byName_, name);
+    consider(byPath_, rel);
+    // Only wildcard rules after the best literal hit can change the outcome
+    for (auto it = globs_.rbegin(); it != globs_.rend() && (long)*it > best; ++it) {
+        const Rule& r = rules_[*it];
+        if (r.dirOnly && !isDir) continue;
+        if (globMatch(r.pattern, r.anchored ? rel : name)) { best = (long)*it; break; }
+    }
+    return best >= 0 && !rules_[(std::size_t)best].negate;
+}
+
+} // namespace openscp
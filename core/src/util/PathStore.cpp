@@ -0,0 +1,137 @@
+// Interned path storage (see PathStore.hpp).
+#include "openscp/PathStore.hpp"
+#include <functional>
+
+namespace openscp {
+
+static std::uint64_t nodeKey(PathStore::Id parent, std::string_view name) {
+    return std::hash<std::string_view>{}(name) ^ ((std::uint64_t)parent * 0x9E3779B97F4A7C15ull);
+}
+
+PathStore::PathStore() {
+    nodes_.push_back(Node{}); // kTop
+}
+
+PathStore::Id PathStore::childLocked(Id parent, std::string_view name) {
+    const std::uint64_t key = nodeKey(parent, name);
+    auto range = index_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        const Node& n = nodes_[it->second];
+        if (n.parent == parent && nameOf(n) == name) return it->second;
+    }
+    Node n;
+    n.parent = parent;
+    n.off = names_.size();
+    n.len = (std::uint32_t)name.size();
+    names_.append(name);
+    const Id id = (Id)nodes_.size();
+    nodes_.push_back(n);
+    index_.emplace(key, id);
+    return id;
+}
+
+// Every '/'-separated component of "path" is a level, empty ones included ("" is one
+// empty component: the root of an absolute path)
+PathStore::Id PathStore::dirLocked(std::string_view path, Id under) {
+    Id d = under;
+    std::size_t pos = 0;
+    for (;;) {
+        const std::size_t slash = path.find('/', pos);
+        const std::size_t end = slash == std::string_view::npos ? path.size() : slash;
+        d = childLocked(d, path.substr(pos, end - pos));
+        if (slash == std::string_view::npos) return d;
+        pos = slash + 1;
+    }
+}
+
+PathStore::Id PathStore::dir(std::string_view path, Id under) {
+    if (path.empty()) return under;
+    if (path.size() > 1 && path.back() == '/') path.remove_suffix(1);
+    else if (path == "/") path = std::string_view();
+    std::lock_guard<std::mutex> lk(mtx_);
+    return dirLocked(path, under);
+}
+
+PathRef PathStore::file(std::string_view path, Id under) {
+    const std::size_t slash = path.rfind('/');
+    std::lock_guard<std::mutex> lk(mtx_);
+    PathRef r;
+    if (slash == std::string_view::npos) {
+        r.dir = under;
+    } else {
+        const std::string_view dirPart = path.substr(0, slash);
+        if (!(lastValid_ && lastUnder_ == under && lastDirPath_ == dirPart)) {
+            lastDir_ = dirLocked(dirPart, under);
+            lastDirPath_.assign(dirPart);
+            lastUnder_ = under;
+            lastValid_ = true;
+        }
+        r.dir = lastDir_;
+    }
+    const std::string_view leaf = slash == std::string_view::npos ? path : path.substr(slash + 1);
+    r.leafOff = names_.size();
+    r.leafLen = (std::uint32_t)leaf.size();
+    names_.append(leaf);
+    return r;
+}
+
+PathRef PathStore::rebase(const PathRef& r, Id from, Id to) {
+    if (r.empty()) return PathRef{};
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::vector<Id> chain; // folders between "from" and the leaf, innermost first
+    Id d = r.dir;
+    while (d != from) {
+        if (d == kTop) return PathRef{};
+        chain.push_back(d);
+        d = nodes_[d].parent;
+    }
+    d = to;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        const std::string name(nameOf(nodes_[*it])); // childLocked may grow names_
+        d = childLocked(d, name);
+    }
+    PathRef out = r;
+    out.dir = d;
+    return out;
+}
+
+void PathStore::appendDir(Id d, std::string& out) const {
+    std::vector<Id> chain;
+    for (; d != kTop; d = nodes_[d].parent) chain.push_back(d);
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (it != chain.rbegin()) out += '/';
+        out.append(nameOf(nodes_[*it]));
+    }
+}
+
+std::string PathStore::str(const PathRef& r) const {
+    if (r.empty()) return std::string();
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::string out;
+    appendDir(r.dir, out);
+    if (r.dir != kTop) out += '/';
+    out.append(names_, r.leafOff, r.leafLen);
+    return out;
+}
+
+std::string PathStore::dirStr(Id d) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::string out;
+    appendDir(d, out);
+    if (out.empty() && d != kTop) out = "/"; // the root alone
+    return out;
+}
+
+std::size_t PathStore::dirCount() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return nodes_.size() - 1;
+}
+
+std::size_t PathStore::bytes() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return nodes_.capacity() * sizeof(Node) + names_.capacity()
+         + index_.size() * (sizeof(std::pair<const std::uint64_t, Id>) + 2 * sizeof(void*))
+         + index_.bucket_count() * sizeof(void*);
+}
+
+} // namespace openscp
@@ -0,0 +1,130 @@
+// On-disk FIFO (see SpillQueue.hpp). Record layout: u32 length (host order) + bytes.
+#include "openscp/SpillQueue.hpp"
+#include "openscp/FileSpace.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace openscp {
+
+static constexpr std::size_t kLenBytes = sizeof(std::uint32_t);
+
+SpillQueue::SpillQueue(std::string dir, std::size_t segmentBytes)
+    : dir_(std::move(dir)), segmentBytes_(segmentBytes) {}
+
+SpillQueue::~SpillQueue() { clear(); }
+
+void SpillQueue::clear() {
+    for (auto& s : segs_) dropSegment(s);
+    segs_.clear();
+    count_ = 0;
+    diskBytes_ = 0;
+}
+
+void SpillQueue::dropSegment(Segment& s) {
+#if !defined(_WIN32)
+    if (s.base) ::munmap(s.base, s.cap);
+    if (s.fd >= 0) ::close(s.fd);
+#else
+    if (s.file) std::fclose((std::FILE*)s.file);
+#endif
+    diskBytes_ -= s.cap;
+    s = Segment{};
+}
+
+bool SpillQueue::addSegment(std::size_t minBytes, std::string& err) {
+    Segment s;
+    s.cap = minBytes > segmentBytes_ ? minBytes : segmentBytes_;
+#if !defined(_WIN32)
+    std::string tmpl = dir_ + "/openscp-spill-" + std::to_string(serial_++) + "-XXXXXX";
+    std::vector<char> path(tmpl.begin(), tmpl.end());
+    path.push_back('\0');
+    s.fd = ::mkstemp(path.data());
+    if (s.fd < 0) { err = std::string("No se pudo crear el archivo temporal: ") + std::strerror(errno); return false; }
+    ::unlink(path.data()); // the space is released when the descriptor is closed
+    const int rc = reserveFileSpace(s.fd, s.cap);
+    if (rc != 0) {
+        ::close(s.fd);
+        err = std::string("Sin espacio para la cola en disco: ") + std::strerror(rc);
+        return false;
+    }
+    void* m = ::mmap(nullptr, s.cap, PROT_READ | PROT_WRITE, MAP_SHARED, s.fd, 0);
+    if (m == MAP_FAILED) {
+        ::close(s.fd);
+        err = std::string("No se pudo mapear la cola en disco: ") + std::strerror(errno);
+        return false;
+    }
+    s.base = static_cast<char*>(m);
+#ifdef MADV_SEQUENTIAL
+    ::madvise(s.base, s.cap, MADV_SEQUENTIAL);
+#endif
+#else
+    // Deleted automatically when closed
+    s.file = std::tmpfile();
+    if (!s.file) { err = "No se pudo crear el archivo temporal"; return false; }
+#endif
+    diskBytes_ += s.cap;
+    segs_.push_back(s);
+    return true;
+}
+
+bool SpillQueue::push(std::string_view rec, std::string& err) {
+    const std::size_t need = kLenBytes + rec.size();
+    if (!segs_.empty() && segs_.back().rpos == segs_.back().wpos) {
+        Segment& b = segs_.back();
+        b.rpos = b.wpos = 0; // fully consumed: reuse from the start
+    }
+    if (segs_.empty() || segs_.back().cap - segs_.back().wpos < need) {
+        if (!addSegment(need, err)) return false;
+    }
+    Segment& s = segs_.back();
+    const std::uint32_t len = (std::uint32_t)rec.size();
+#if !defined(_WIN32)
+    std::memcpy(s.base + s.wpos, &len, kLenBytes);
+    std::memcpy(s.base + s.wpos + kLenBytes, rec.data(), rec.size());
+#else
+    auto* f = (std::FILE*)s.file;
+    if (std::fseek(f, (long)s.wpos, SEEK_SET) != 0 || std::fwrite(&len, kLenBytes, 1, f) != 1
+        || (!rec.empty() && std::fwrite(rec.data(), rec.size(), 1, f) != 1)) {
+        err = "No se pudo escribir la cola en disco";
+        return false;
+    }
+#endif
+    s.wpos += need;
+    ++count_;
+    return true;
+}
+
+bool SpillQueue::pop(std::string& out) {
+    while (!segs_.empty()) {
+        Segment& s = segs_.front();
+        if (s.rpos < s.wpos) {
+            std::uint32_t len = 0;
+#if !defined(_WIN32)
+            std::memcpy(&len, s.base + s.rpos, kLenBytes);
+            out.assign(s.base + s.rpos + kLenBytes, len);
+#else
+            auto* f = (std::FILE*)s.file;
+            std::fseek(f, (long)s.rpos, SEEK_SET);
+            if (std::fread(&len, kLenBytes, 1, f) != 1) return false;
+            out.resize(len);
+            if (len && std::fread(out.data(), len, 1, f) != 1) return false;
+#endif
+            s.rpos += kLenBytes + len;
+            --count_;
+            return true;
+        }
+        if (segs_.size() == 1) return false; // the write segment, drained
+        dropSegment(s);
+        segs_.pop_front();
+    }
+    return false;
+}
+
+} // namespace openscp
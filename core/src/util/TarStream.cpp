@@ -0,0 +1,324 @@
+// Streaming tar writer/extractor (ustar headers, GNU 'L' long names, pax path records).
+#include "openscp/TarStream.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace openscp {
+
+static constexpr std::size_t kBlock = 512;
+
+// ---- numeric fields ----
+
+static void putOctal(char* field, std::size_t width, std::uint64_t v) {
+    // width includes the trailing NUL; fall back to GNU base-256 when it does not fit
+    const std::size_t digits = width - 1;
+    if (digits < 21 && v >= (std::uint64_t(1) << (3 * digits))) {
+        std::memset(field, 0, width);
+        field[0] = (char)0x80;
+        for (std::size_t i = width - 1; i > 0 && v; --i) {
+            field[i] = (char)(v & 0xFF);
+            v >>= 8;
+        }
+        return;
+    }
+    std::snprintf(field, width, "%0*llo", (int)digits, (unsigned long long)v);
+}
+
+static std::uint64_t getNumber(const char* field, std::size_t width) {
+    if ((unsigned char)field[0] & 0x80) {
+        std::uint64_t v = 0;
+        for (std::size_t i = 1; i < width; ++i) v = (v << 8) | (unsigned char)field[i];
+        return v;
+    }
+    std::uint64_t v = 0;
+    std::size_t i = 0;
+    while (i < width && (field[i] == ' ' || field[i] == '\0')) ++i;
+    for (; i < width && field[i] >= '0' && field[i] <= '7'; ++i) v = (v << 3) | std::uint64_t(field[i] - '0');
+    return v;
+}
+
+static std::uint32_t headerChecksum(const char* h) {
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < kBlock; ++i)
+        sum += (i >= 148 && i < 156) ? (unsigned char)' ' : (unsigned char)h[i];
+    return sum;
+}
+
+std::string shellQuote(const std::string& s) {
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'') out += "'\\''";
+        else out += c;
+    }
+    out += "'";
+    return out;
+}
+
+// ---- TarWriter ----
+
+bool TarWriter::writeHeader(const std::string& rel, char type, std::uint64_t size,
+                            std::uint32_t mode, std::uint64_t mtime) {
+    char h[kBlock];
+    std::memset(h, 0, sizeof(h));
+    std::memcpy(h, rel.data(), std::min<std::size_t>(rel.size(), 100));
+    putOctal(h + 100, 8, mode & 07777);
+    putOctal(h + 108, 8, 0);
+    putOctal(h + 116, 8, 0);
+    putOctal(h + 124, 12, size);
+    putOctal(h + 136, 12, mtime);
+    h[156] = type;
+    std::memcpy(h + 257, "ustar", 6);
+    std::memcpy(h + 263, "00", 2);
+    std::snprintf(h + 148, 8, "%06o", (unsigned)headerChecksum(h));
+    h[155] = ' ';
+    return sink_(h, sizeof(h));
+}
+
+bool TarWriter::pad(std::uint64_t size) {
+    static const char zeros[kBlock] = {};
+    const std::size_t rem = (std::size_t)(size % kBlock);
+    if (rem == 0) return true;
+    return sink_(zeros, kBlock - rem);
+}
+
+bool TarWriter::writeLongName(const std::string& rel) {
+    // GNU extension: an 'L' entry whose payload is the full name (NUL terminated)
+    const std::string payload = rel + '\0';
+    if (!writeHeader("././@LongLink", 'L', payload.size(), 0644, 0)) return false;
+    if (!sink_(payload.data(), payload.size())) return false;
+    return pad(payload.size());
+}
+
+bool TarWriter::addDirectory(const std::string& rel, std::uint32_t mode, std::uint64_t mtime) {
+    const std::string name = rel.empty() || rel.back() == '/' ? rel : rel + "/";
+    if (name.size() >= 100 && !writeLongName(name)) return false;
+    return writeHeader(name, '5', 0, mode ? mode : 0755, mtime);
+}
+
+bool TarWriter::addFile(const std::string& rel, const std::string& localPath,
+                        std::uint64_t size, std::uint32_t mode, std::uint64_t mtime,
+                        const std::function<void(std::size_t)>& onBytes,
+                        const std::function<bool()>& shouldCancel,
+                        const TarFileErrorCB& onError,
+                        std::string& err) {
+    FILE* f = std::fopen(localPath.c_str(), "rb");
+    if (!f) {
+        // Skip the entry entirely; the archive stays consistent
+        if (onError) onError(rel, "No se pudo abrir archivo local para lectura");
+        return true;
+    }
+    if (rel.size() >= 100 && !writeLongName(rel)) {
+        std::fclose(f);
+        err = "Escritura remota falló";
+        return false;
+    }
+    if (!writeHeader(rel, '0', size, mode ? mode : 0644, mtime)) {
+        std::fclose(f);
+        err = "Escritura remota falló";
+        return false;
+    }
+    std::vector<char> buf(64 * 1024);
+    std::uint64_t left = size;
+    bool shortRead = false;
+    while (left > 0) {
+        if (shouldCancel && shouldCancel()) {
+            std::fclose(f);
+            err = "Cancelado por usuario";
+            return false;
+        }
+        const std::size_t want = (std::size_t)std::min<std::uint64_t>(buf.size(), left);
+        std::size_t n = shortRead ? 0 : std::fread(buf.data(), 1, want, f);
+        if (n < want) {
+            // File shrank or failed mid-read: zero-fill to the declared size
+            if (!shortRead && onError) onError(rel, "Lectura local incompleta");
+            shortRead = true;
+            std::memset(buf.data() + n, 0, want - n);
+            n = want;
+        }
+        if (!sink_(buf.data(), n)) {
+            std::fclose(f);
+            err = "Escritura remota falló";
+            return false;
+        }
+        left -= n;
+        if (onBytes) onBytes(n);
+    }
+    std::fclose(f);
+    if (!pad(size)) {
+        err = "Escritura remota falló";
+        return false;
+    }
+    return true;
+}
+
+bool TarWriter::finish() {
+    static const char zeros[kBlock * 2] = {};
+    return sink_(zeros, sizeof(zeros));
+}
+
+// ---- TarExtractor ----
+
+TarExtractor::~TarExtractor() {
+    if (out_) std::fclose(out_);
+}
+
+bool TarExtractor::entryPath(std::string& out) {
+    std::string p = path_;
+    while (p.rfind("./", 0) == 0) p.erase(0, 2);
+    while (!p.empty() && p.back() == '/') p.pop_back();
+    if (p.empty() || p == ".") { out.clear(); return true; }
+    if (p.front() == '/') return false;
+    // Reject any ".." component (path traversal)
+    std::size_t start = 0;
+    while (start <= p.size()) {
+        const std::size_t end = p.find('/', start);
+        const std::string comp = p.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (comp == "..") return false;
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    out = p;
+    return true;
+}
+
+bool TarExtractor::beginEntry(std::string& err) {
+    const char* h = header_.data();
+    if (headerChecksum(h) != (std::uint32_t)getNumber(h + 148, 8)) {
+        err = "tar: cabecera inválida";
+        return false;
+    }
+    type_ = h[156];
+    mode_ = (std::uint32_t)getNumber(h + 100, 8);
+    mtime_ = getNumber(h + 136, 12);
+    remaining_ = getNumber(h + 124, 12);
+    padRemaining_ = (kBlock - remaining_ % kBlock) % kBlock;
+    meta_.clear();
+
+    if (!pendingLongName_.empty()) {
+        path_ = pendingLongName_;
+        pendingLongName_.clear();
+    } else {
+        std::string name(h, strnlen(h, 100));
+        const bool ustar = std::memcmp(h + 257, "ustar", 5) == 0;
+        std::string prefix = ustar ? std::string(h + 345, strnlen(h + 345, 155)) : std::string();
+        path_ = prefix.empty() ? name : prefix + "/" + name;
+    }
+
+    if (type_ == 'L' || type_ == 'x' || type_ == 'K' || type_ == 'g') {
+        // Metadata entries: payload is buffered (or discarded) and applies to the next header
+        return true;
+    }
+
+    std::string rel;
+    if (!entryPath(rel)) {
+        if (onError_) onError_(path_, "Ruta insegura en el archivo tar; omitida");
+        return true;
+    }
+    const fs::path target = rel.empty() ? fs::path(root_) : fs::path(root_) / rel;
+    std::error_code ec;
+    if (type_ == '5') {
+        fs::create_directories(target, ec);
+        if (ec && onError_) onError_(rel, "No se pudo crear la carpeta local: " + ec.message());
+        return true;
+    }
+    if (type_ == '0' || type_ == '\0' || type_ == '7') {
+        if (rel.empty()) return true;
+        fs::create_directories(target.parent_path(), ec);
+        out_ = std::fopen(target.string().c_str(), "wb");
+        if (!out_ && onError_) onError_(rel, "No se pudo abrir archivo local para escribir");
+        return true;
+    }
+    // Links, devices, FIFOs: not materialized locally
+    if (onError_) onError_(rel, "Tipo de entrada no soportado; omitida");
+    return true;
+}
+
+void TarExtractor::endEntry() {
+    if (type_ == 'L') {
+        pendingLongName_ = std::string(meta_.c_str());
+    } else if (type_ == 'x') {
+        // pax records: "<len> key=value\n"
+        std::size_t pos = 0;
+        while (pos < meta_.size()) {
+            const std::size_t sp = meta_.find(' ', pos);
+            if (sp == std::string::npos) break;
+            const std::size_t len = (std::size_t)std::strtoull(meta_.c_str() + pos, nullptr, 10);
+            if (len == 0 || pos + len > meta_.size()) break;
+            const std::string rec = meta_.substr(sp + 1, pos + len - sp - 2);
+            if (rec.rfind("path=", 0) == 0) pendingLongName_ = rec.substr(5);
+            pos += len;
+        }
+    }
+    if (out_) {
+        std::fclose(out_);
+        out_ = nullptr;
+        std::string rel;
+        if (entryPath(rel) && !rel.empty()) {
+            const fs::path target = fs::path(root_) / rel;
+            std::error_code ec;
+            fs::permissions(target, fs::perms(mode_ & 0777), ec);
+            const auto tp = std::chrono::system_clock::from_time_t((std::time_t)mtime_);
+            fs::last_write_time(target, std::chrono::file_clock::from_sys(tp), ec);
+        }
+    }
+    meta_.clear();
+}
+
+bool TarExtractor::feed(const char* data, std::size_t len, std::string& err) {
+    while (len > 0 && !finished_) {
+        if (state_ == State::Header) {
+            const std::size_t need = kBlock - header_.size();
+            const std::size_t take = std::min(need, len);
+            header_.insert(header_.end(), data, data + take);
+            data += take;
+            len -= take;
+            if (header_.size() < kBlock) break;
+            const bool zero = std::all_of(header_.begin(), header_.end(), [](char c) { return c == 0; });
+            if (zero) {
+                header_.clear();
+                if (++zeroBlocks_ >= 2) finished_ = true;
+                continue;
+            }
+            zeroBlocks_ = 0;
+            if (!beginEntry(err)) return false;
+            header_.clear();
+            if (remaining_ > 0) state_ = State::Data;
+            else if (padRemaining_ > 0) state_ = State::Padding;
+            else endEntry();
+        } else if (state_ == State::Data) {
+            const std::size_t take = (std::size_t)std::min<std::uint64_t>(remaining_, len);
+            if (type_ == 'L' || type_ == 'x') {
+                meta_.append(data, take);
+            } else if (out_) {
+                if (std::fwrite(data, 1, take, out_) != take) {
+                    std::fclose(out_);
+                    out_ = nullptr;
+                    if (onError_) onError_(path_, "Escritura local falló");
+                } else {
+                    bytes_ += take;
+                }
+            }
+            data += take;
+            len -= take;
+            remaining_ -= take;
+            if (remaining_ == 0) {
+                if (padRemaining_ > 0) state_ = State::Padding;
+                else { endEntry(); state_ = State::Header; }
+            }
+        } else {
+            const std::size_t take = (std::size_t)std::min<std::uint64_t>(padRemaining_, len);
+            data += take;
+            len -= take;
+            padRemaining_ -= take;
+            if (padRemaining_ == 0) { endEntry(); state_ = State::Header; }
+        }
+    }
+    return true;
+}
+
+} // namespace openscp
@@ -48,6 +48,20 @@ ConnectionDialog::ConnectionDialog(QWidget* parent) : QDialog(parent) {
     lay->addRow(tr("known_hosts:"), khPath_);
     lay->addRow(tr("Política:"), khPolicy_);
 
+    // Transport compression
+    compression_ = new QComboBox(this);
+    compression_->addItem(tr("Desactivada"), static_cast<int>(openscp::CompressionMode::Off));
+    compression_->addItem(tr("Activada"), static_cast<int>(openscp::CompressionMode::On));
+    compression_->addItem(tr("Automática (según contenido)"), static_cast<int>(openscp::CompressionMode::Auto));
+    lay->addRow(tr("Compresión:"), compression_);
+
+    // Transfer engine for single files
+    engine_ = new QComboBox(this);
+    engine_->addItem(tr("SFTP"), static_cast<int>(openscp::TransferEngine::Sftp));
+    engine_->addItem(tr("SCP"), static_cast<int>(openscp::TransferEngine::Scp));
+    engine_->addItem(tr("Automático (SCP si es más rápido)"), static_cast<int>(openscp::TransferEngine::Auto));
+    lay->addRow(tr("Transferencia:"), engine_);
+
     // Button to choose known_hosts
     khBrowse_ = new QPushButton(tr("Elegir known_hosts…"), this);
     lay->addRow("", khBrowse_);
@@ -94,6 +108,8 @@ openscp::SessionOptions ConnectionDialog::options() const {
     if (!khPath_->text().isEmpty())
         o.known_hosts_path = khPath_->text().toStdString();
     o.known_hosts_policy = static_cast<openscp::KnownHostsPolicy>(khPolicy_->currentData().toInt());
+    o.compression = static_cast<openscp::CompressionMode>(compression_->currentData().toInt());
+    o.transfer_engine = static_cast<openscp::TransferEngine>(engine_->currentData().toInt());
 
     return o;
 }
@@ -109,4 +125,8 @@ void ConnectionDialog::setOptions(const openscp::SessionOptions& o) {
     // Policy
     int idx = khPolicy_->findData(static_cast<int>(o.known_hosts_policy));
     if (idx >= 0) khPolicy_->setCurrentIndex(idx);
+    int cidx = compression_->findData(static_cast<int>(o.compression));
+    if (cidx >= 0) compression_->setCurrentIndex(cidx);
+    int eidx = engine_->findData(static_cast<int>(o.transfer_engine));
+    if (eidx >= 0) engine_->setCurrentIndex(eidx);
 }
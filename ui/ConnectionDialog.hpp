@@ -27,4 +27,9 @@ private:
     QLineEdit* khPath_ = nullptr;
     QPushButton* khBrowse_ = nullptr;
     QComboBox* khPolicy_ = nullptr;
+
+    // SSH compression (off/on/auto)
+    QComboBox* compression_ = nullptr;
+    // File transfer engine (SFTP/SCP/auto)
+    QComboBox* engine_ = nullptr;
 };
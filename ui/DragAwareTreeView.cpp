@@ -271,8 +271,10 @@ void DragAwareTreeView::startRemoteDragAsync(RemoteModel* rm) {
     // Show overlay early to cover potentially heavy folder enumeration
     showPrepOverlay(tr("Preparando archivos…"));
 
-    // Prepare list of downloads (support files and directories)
-    struct Pair { QString remote; QString local; quint64 size = 0; };
+    // Prepare list of downloads (support files and directories). Remote paths are
+    // interned in the queue's store; the local ones are needed as URLs for the drag.
+    const auto paths = transferMgr_->paths();
+    struct Pair { openscp::PathRef remote; QString local; quint64 size = 0; quint64 task = 0; };
     QVector<Pair> targets;
     targets.reserve(rows.size());
     quint64 totalBytes = 0;
@@ -291,7 +293,8 @@ void DragAwareTreeView::startRemoteDragAsync(RemoteModel* rm) {
         const QString rpath = joinRemote(rm->rootPath(), name);
         if (rm->isDir(idx)) {
             // Enumerate directory recursively
-            std::vector<RemoteModel::EnumeratedFile> files;
+            RemoteModel::EnumeratedFiles files;
+            files.paths = paths;
             QString e;
             RemoteModel::EnumOptions opt;
             QSettings s("OpenSCP", "OpenSCP");
@@ -312,22 +315,21 @@ void DragAwareTreeView::startRemoteDragAsync(RemoteModel* rm) {
             enumDenied_ += denied;
             unknownSizeCount += unkCountPart;
             // Map to local targets under staging/name/relative
-            // Map to local targets under staging/name/relative
-            for (const auto& f : files) {
+            for (const auto& f : files.files) {
                 if (enumCancelFlag_ && enumCancelFlag_->load(std::memory_order_relaxed)) { dragInProgress_ = false; return; }
-                const QString local = QDir(QDir(staging).filePath(nfc(name))).filePath(nfc(f.relativePath));
+                const QString local = QDir(QDir(staging).filePath(nfc(name))).filePath(nfc(files.relativePath(f)));
                 QDir().mkpath(QFileInfo(local).dir().absolutePath());
-                targets.push_back({ f.remotePath, local, f.hasSize ? f.size : 0 });
+                targets.push_back({ f.path, local, f.hasSize ? f.size : 0 });
                 if (f.hasSize) totalBytes += f.size; // unknown sizes not counted
             }
-            totalItems += (int)files.size();
+            totalItems += (int)files.files.size();
         } else {
             const QString lpath = uniquePath(staging, name);
             // Pick up size info (if available) from the model for single files
             quint64 sz = 0; bool hsz = false;
             if (rm->hasSize(idx)) { hsz = true; sz = rm->sizeAt(idx); }
             if (hsz) totalBytes += sz; else { anySizeUnknown = true; unknownSizeCount += 1; }
-            targets.push_back({ rpath, lpath, sz });
+            targets.push_back({ paths->file(rpath.toStdString()), lpath, sz });
             totalItems += 1;
         }
     }
@@ -439,13 +441,13 @@ void DragAwareTreeView::startRemoteDragAsync(RemoteModel* rm) {
     for (auto& p : targets) {
         QDir().mkpath(QFileInfo(p.local).dir().absolutePath());
         p.local = uniqueFullPath(p.local);
-        transferMgr_->enqueueDownload(p.remote, p.local);
+        p.task = transferMgr_->enqueueDownload(p.remote, paths->file(p.local.toStdString()), p.size > 0 ? (qint64)p.size : -1);
     }
     transferMgr_->resumeAll();
     overlayProgress_->setValue(0);
     stagingTimer_.restart();
 
-    // Track progress of our batch (identified by local dst prefix = staging)
+    // Track progress of our batch (by task id)
     QPointer<DragAwareTreeView> self(this);
     // Cancel button handler: cancel only our tasks
     QObject::connect(overlayCancel_, &QPushButton::clicked, this, [this]{
@@ -476,26 +478,20 @@ void DragAwareTreeView::startRemoteDragAsync(RemoteModel* rm) {
     waitTimer_->start();
 
     // Connect to tasksChanged to monitor our batch
-    stagingConn_ = QObject::connect(transferMgr_, &TransferManager::tasksChanged, this, [this, self, targets, totalDirs, totalItems]() mutable {
+    QSet<quint64> ours;
+    ours.reserve(targets.size());
+    for (const auto& p : targets) ours.insert(p.task);
+    stagingConn_ = QObject::connect(transferMgr_, &TransferManager::tasksChanged, this, [this, self, targets, ours, totalDirs, totalItems]() mutable {
         if (!self) return;
         if (!transferMgr_) return;
         int total = targets.size();
         int done = 0;
         int failed = 0;
-        const auto tasks = transferMgr_->tasks();
-        for (const auto& p : targets) {
-            bool matched = false;
-            for (const auto& t : tasks) {
-                if (t.type == TransferTask::Type::Download && t.dst == p.local) {
-                    matched = true;
-                    if (t.status == TransferTask::Status::Done) done++;
-                    else if (t.status == TransferTask::Status::Error || t.status == TransferTask::Status::Canceled) failed++;
-                    break;
-                }
-            }
-            if (!matched) {
-                // still queued but not yet visible; treat as pending
-            }
+        const auto& tasks = transferMgr_->tasks();
+        for (const auto& t : tasks) {
+            if (!ours.contains(t.id)) continue;
+            if (t.status == TransferTask::Status::Done) done++;
+            else if (t.status == TransferTask::Status::Error || t.status == TransferTask::Status::Canceled) failed++;
         }
         int pct = (total > 0) ? int((done * 100) / total) : 0;
         if (overlayProgress_) overlayProgress_->setValue(pct);
@@ -603,7 +599,7 @@ void DragAwareTreeView::cancelCurrentBatch(const QString& reason) {
     if (transferMgr_) {
         const auto tasks = transferMgr_->tasks();
         for (const auto& t : tasks) {
-            if (t.type == TransferTask::Type::Download && t.dst.startsWith(currentBatchDir_)) {
+            if (t.type == TransferTask::Type::Download && transferMgr_->dstOf(t).startsWith(currentBatchDir_)) {
                 transferMgr_->cancelTask(t.id);
             }
         }
@@ -3,6 +3,7 @@
 // create/rename/delete), a transfer queue with resume, and known_hosts validation.
 #include "MainWindow.hpp"
 #include "openscp/Libssh2SftpClient.hpp"
+#include "openscp/CachingSftpClient.hpp"
 #include "ConnectionDialog.hpp"
 #include "RemoteModel.hpp"
 #include <QApplication>
@@ -33,6 +34,7 @@
 #include <QMenuBar>
 #include <QDateTime>
 #include <QCheckBox>
+#include <QComboBox>
 #include "PermissionsDialog.hpp"
 #include "SiteManagerDialog.hpp"
 #include <QMimeData>
@@ -50,6 +52,7 @@
 #include <QDialog>
 #include <QScreen>
 #include <QGuiApplication>
+#include <algorithm>
 #include <QStyle>
 #include <QIcon>
 #include <QTemporaryFile>
@@ -69,6 +72,8 @@
 #include <memory>
 
 static constexpr int NAME_COL = 0;
+// Folder downloads: walks resumed after a connection that could not be recovered
+static constexpr int kTreeWalkPasses = 3;
 
 // Best-effort memory scrubbing helpers for sensitive data
 static inline void secureClear(QString& s) {
@@ -182,6 +187,9 @@ static bool isValidEntryName(const QString& name, QString* why = nullptr) {
     return true;
 }
 
+// Filter for background folder walks (called on the walk thread)
+static bool acceptEntryName(const QString& name) { return isValidEntryName(name); }
+
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     // Globally center dialogs relative to the main window
     qApp->installEventFilter(this);
@@ -410,6 +418,27 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     rightPaneBar_->addSeparator();
     rightPaneBar_->addAction(actDownloadF7_);
     rightPaneBar_->addAction(actUploadRight_);
+    // Remote listing filter: applied in memory on each keystroke (no re-list)
+    rightPaneBar_->addSeparator();
+    rightFilter_ = new QLineEdit(rightPaneBar_);
+    rightFilter_->setPlaceholderText(tr("Filtrar (texto o *.ext)"));
+    rightFilter_->setClearButtonEnabled(true);
+    rightFilter_->setMaximumWidth(220);
+    rightFilter_->setEnabled(false);
+    rightPaneBar_->addWidget(rightFilter_);
+    rightFilterType_ = new QComboBox(rightPaneBar_);
+    rightFilterType_->addItem(tr("Todo"), (int)RemoteModel::TypeFilter::All);
+    rightFilterType_->addItem(tr("Archivos"), (int)RemoteModel::TypeFilter::Files);
+    rightFilterType_->addItem(tr("Carpetas"), (int)RemoteModel::TypeFilter::Dirs);
+    rightFilterType_->setEnabled(false);
+    rightPaneBar_->addWidget(rightFilterType_);
+    connect(rightFilter_, &QLineEdit::textChanged, this, [this](const QString& t) {
+        if (rightRemoteModel_) rightRemoteModel_->setNameFilter(t);
+    });
+    connect(rightFilterType_, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](int) {
+        if (rightRemoteModel_)
+            rightRemoteModel_->setTypeFilter((RemoteModel::TypeFilter)rightFilterType_->currentData().toInt());
+    });
     // Delete shortcut also on right panel (limited to right panel widget)
     if (actDeleteRight_) {
         actDeleteRight_->setShortcut(QKeySequence(Qt::Key_Delete));
@@ -781,6 +810,13 @@ void MainWindow::showEvent(QShowEvent* e) {
     }
 }
 
+void MainWindow::changeEvent(QEvent* e) {
+    QMainWindow::changeEvent(e);
+    // Formatted sizes/dates in the remote pane depend on the locale
+    if (e->type() == QEvent::LocaleChange && rightRemoteModel_)
+        rightRemoteModel_->invalidateDisplayCache();
+}
+
 void MainWindow::copyLeftToRight() {
     if (rightIsRemote_) {
         // ---- REMOTE branch: upload files (PUT) to the current remote directory ----
@@ -788,6 +824,7 @@ void MainWindow::copyLeftToRight() {
             QMessageBox::warning(this, tr("SFTP"), tr("No hay sesión SFTP activa."));
             return;
         }
+        if (!confirmRemoteWritable()) return;
 
         // Selection on the left panel (local source)
         auto sel = leftView_->selectionModel();
@@ -804,28 +841,32 @@ void MainWindow::copyLeftToRight() {
         // Always enqueue uploads
         const QString remoteBase = rightRemoteModel_->rootPath();
         int enq = 0;
+        int walks = 0; // folders queued while still being enumerated
+        int tarState = -1; // resolved on the first folder
+        const auto rules = transferRules(); // tar streams cannot skip entries
         for (const QModelIndex& idx : rows) {
             const QFileInfo fi = leftModel_->fileInfo(idx);
             if (fi.isDir()) {
                 const QString remoteDirBase = joinRemotePath(remoteBase, fi.fileName());
-                QDirIterator it(fi.absoluteFilePath(), QDir::NoDotAndDotDot | QDir::AllEntries, QDirIterator::Subdirectories);
-                while (it.hasNext()) {
-                    it.next();
-                    const QFileInfo sfi = it.fileInfo();
-                    if (!sfi.isFile()) continue;
-                    const QString rel = QDir(fi.absoluteFilePath()).relativeFilePath(sfi.absoluteFilePath());
-                    const QString rTarget = joinRemotePath(remoteDirBase, rel);
-                    transferMgr_->enqueueUpload(sfi.absoluteFilePath(), rTarget);
+                if (tarState < 0) tarState = (!rules && useTarForFolders()) ? 1 : 0;
+                if (tarState == 1) {
+                    transferMgr_->enqueueTreeUpload(fi.absoluteFilePath(), remoteDirBase);
                     ++enq;
+                    continue;
                 }
+                // Files are queued while the local walk goes on (uploads start right away)
+                transferMgr_->enqueueUploadFeed(fi.absoluteFilePath(), remoteDirBase, rules);
+                ++walks;
             } else {
                 const QString rTarget = joinRemotePath(remoteBase, fi.fileName());
                 transferMgr_->enqueueUpload(fi.absoluteFilePath(), rTarget);
                 ++enq;
             }
         }
-        if (enq > 0) {
-            statusBar()->showMessage(QString(tr("Encolados: %1 subidas")).arg(enq), 4000);
+        if (enq > 0 || walks > 0) {
+            QString msg = QString(tr("Encolados: %1 subidas")).arg(enq);
+            if (walks > 0) msg += QString("  |  ") + tr("Carpetas en curso: %1").arg(walks);
+            statusBar()->showMessage(msg, 4000);
             if (!transferDlg_) transferDlg_ = new TransferQueueDialog(transferMgr_, this);
             transferDlg_->show(); transferDlg_->raise(); transferDlg_->activateWindow();
         }
@@ -1118,6 +1159,7 @@ void MainWindow::disconnectSftp() {
     m_isDisconnecting = true;
     // Detach client from the queue to avoid dangling pointers
     if (transferMgr_) transferMgr_->clearClient();
+    if (rightRemoteModel_) rightRemoteModel_->stopAsyncListing();
     if (sftp_) sftp_->disconnect();
     sftp_.reset();
     if (rightRemoteModel_) {
@@ -1130,6 +1172,11 @@ void MainWindow::disconnectSftp() {
     }
     rightIsRemote_ = false;
     rightRemoteWritable_ = false;
+    remoteAccess_.clear();
+    siteExcludes_.clear();
+    if (rightFilter_) { rightFilter_->clear(); rightFilter_->setEnabled(false); }
+    if (rightFilterType_) { rightFilterType_->setCurrentIndex(0); rightFilterType_->setEnabled(false); }
+    remoteIdKnown_ = false;
     if (actConnect_) actConnect_->setEnabled(true);
     if (actDisconnect_) actDisconnect_->setEnabled(false);
     if (actDownloadF7_) actDownloadF7_->setEnabled(false);
@@ -1217,6 +1264,14 @@ void MainWindow::maybeOpenSiteManagerAfterModal() {
 // Navigate remote pane to a new remote directory.
 void MainWindow::setRightRemoteRoot(const QString& path) {
     if (!rightIsRemote_ || !rightRemoteModel_) return;
+    if (rightRemoteModel_->asyncListing()) {
+        // Rows arrive in batches; completion is handled in onRightListingFinished()
+        rightPath_->setText(path);
+        statusBar()->showMessage(tr("Cargando %1…").arg(path));
+        rightRemoteModel_->requestRootPath(path);
+        updateDeleteShortcutEnables();
+        return;
+    }
     QString e;
     if (!rightRemoteModel_->setRootPath(path, &e)) {
         QMessageBox::warning(this, tr("Error remoto"), e);
@@ -1227,6 +1282,24 @@ void MainWindow::setRightRemoteRoot(const QString& path) {
     updateDeleteShortcutEnables();
 }
 
+// Completion of an asynchronous remote listing started by setRightRemoteRoot().
+void MainWindow::onRightListingFinished(const QString& path, bool ok, const QString& error) {
+    if (!rightIsRemote_ || !rightRemoteModel_) return;
+    if (!ok) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, tr("Error remoto"), error);
+        // Go back to where we were (normally served from the listing cache)
+        const QString prev = rightRemoteModel_->previousRootPath();
+        QString e;
+        if (!prev.isEmpty() && prev != path && rightRemoteModel_->setRootPath(prev, &e)) rightPath_->setText(prev);
+        updateDeleteShortcutEnables();
+        return;
+    }
+    statusBar()->showMessage(tr("%1 elementos").arg(rightRemoteModel_->rowCount()), 3000);
+    updateRemoteWriteability();
+    updateDeleteShortcutEnables();
+}
+
 // Handle activation (double-click/Enter) on the right pane.
 void MainWindow::rightItemActivated(const QModelIndex& idx) {
     // Local mode (right panel is local): navigate into directories
@@ -1417,6 +1490,9 @@ void MainWindow::downloadRightToLeft() {
     }
     int enq = 0;
     int bad = 0;
+    int walks = 0; // folders queued while still being enumerated
+    int tarState = -1; // resolved on the first folder
+    const auto rules = transferRules(); // tar streams cannot skip entries
     const QString remoteBase = rightRemoteModel_->rootPath();
     for (const QModelIndex& idx : rows) {
         const QString name = rightRemoteModel_->nameAt(idx);
@@ -1428,33 +1504,29 @@ void MainWindow::downloadRightToLeft() {
         rpath += name;
         const QString lpath = dst.filePath(name);
         if (rightRemoteModel_->isDir(idx)) {
-            QVector<QPair<QString, QString>> stack;
-            stack.push_back({ rpath, lpath });
-            while (!stack.isEmpty()) {
-                auto pair = stack.back();
-                stack.pop_back();
-                const QString curR = pair.first;
-                const QString curL = pair.second;
-                QDir().mkpath(curL);
-                std::vector<openscp::FileInfo> out;
-                std::string lerr;
-                if (!sftp_->list(curR.toStdString(), out, lerr)) continue;
-                for (const auto& e : out) {
-                    const QString ename = QString::fromStdString(e.name);
-                    QString why; if (!isValidEntryName(ename, &why)) { ++bad; continue; }
-                    const QString childR = (curR.endsWith('/') ? curR + ename : curR + "/" + ename);
-                    const QString childL = QDir(curL).filePath(ename);
-                    if (e.is_dir) stack.push_back({ childR, childL });
-                    else { transferMgr_->enqueueDownload(childR, childL); ++enq; }
-                }
+            if (tarState < 0) tarState = (!rules && useTarForFolders()) ? 1 : 0;
+            if (tarState == 1) {
+                transferMgr_->enqueueTreeDownload(rpath, lpath);
+                ++enq;
+                continue;
+            }
+            // Files are queued while the walk goes on (transfers start right away)
+            if (transferMgr_->enqueueDownloadFeed(rpath, lpath, acceptEntryName, rules)) {
+                ++walks;
+                continue;
             }
+            collectRemoteTree(rpath, lpath, bad, [&](const RemoteTreeFile& f) {
+                transferMgr_->enqueueDownload(f.remote, f.local, f.size);
+                ++enq;
+            });
         } else {
             transferMgr_->enqueueDownload(rpath, lpath);
             ++enq;
         }
     }
-    if (enq > 0) {
+    if (enq > 0 || walks > 0) {
         QString msg = QString(tr("Encolados: %1 descargas")).arg(enq);
+        if (walks > 0) msg += QString("  |  ") + tr("Carpetas en curso: %1").arg(walks);
         if (bad > 0) msg += QString("  |  ") + tr("Omitidos inválidos: %1").arg(bad);
         statusBar()->showMessage(msg, 4000);
         if (!transferDlg_) transferDlg_ = new TransferQueueDialog(transferMgr_, this);
@@ -1511,6 +1583,9 @@ void MainWindow::copyRightToLeft() {
     if (!sftp_ || !rightRemoteModel_) { QMessageBox::warning(this, tr("SFTP"), tr("No hay sesión SFTP activa.")); return; }
     int enq = 0;
     int bad = 0;
+    int walks = 0; // folders queued while still being enumerated
+    int tarState = -1; // resolved on the first folder
+    const auto rules = transferRules(); // tar streams cannot skip entries
     const QString remoteBase = rightRemoteModel_->rootPath();
     for (const QModelIndex& idx : rows) {
         const QString name = rightRemoteModel_->nameAt(idx);
@@ -1522,33 +1597,29 @@ void MainWindow::copyRightToLeft() {
         rpath += name;
         const QString lpath = dst.filePath(name);
         if (rightRemoteModel_->isDir(idx)) {
-            QVector<QPair<QString, QString>> stack;
-            stack.push_back({ rpath, lpath });
-            while (!stack.isEmpty()) {
-                auto pair = stack.back();
-                stack.pop_back();
-                const QString curR = pair.first;
-                const QString curL = pair.second;
-                QDir().mkpath(curL);
-                std::vector<openscp::FileInfo> out;
-                std::string lerr;
-                if (!sftp_->list(curR.toStdString(), out, lerr)) continue;
-                for (const auto& e : out) {
-                    const QString ename = QString::fromStdString(e.name);
-                    QString why; if (!isValidEntryName(ename, &why)) { ++bad; continue; }
-                    const QString childR = (curR.endsWith('/') ? curR + ename : curR + "/" + ename);
-                    const QString childL = QDir(curL).filePath(ename);
-                    if (e.is_dir) stack.push_back({ childR, childL });
-                    else { transferMgr_->enqueueDownload(childR, childL); ++enq; }
-                }
+            if (tarState < 0) tarState = (!rules && useTarForFolders()) ? 1 : 0;
+            if (tarState == 1) {
+                transferMgr_->enqueueTreeDownload(rpath, lpath);
+                ++enq;
+                continue;
+            }
+            // Files are queued while the walk goes on (transfers start right away)
+            if (transferMgr_->enqueueDownloadFeed(rpath, lpath, acceptEntryName, rules)) {
+                ++walks;
+                continue;
             }
+            collectRemoteTree(rpath, lpath, bad, [&](const RemoteTreeFile& f) {
+                transferMgr_->enqueueDownload(f.remote, f.local, f.size);
+                ++enq;
+            });
         } else {
             transferMgr_->enqueueDownload(rpath, lpath);
             ++enq;
         }
     }
-    if (enq > 0) {
+    if (enq > 0 || walks > 0) {
         QString msg = QString(tr("Encolados: %1 descargas")).arg(enq);
+        if (walks > 0) msg += QString("  |  ") + tr("Carpetas en curso: %1").arg(walks);
         if (bad > 0) msg += QString("  |  ") + tr("Omitidos inválidos: %1").arg(bad);
         statusBar()->showMessage(msg, 4000);
         if (!transferDlg_) transferDlg_ = new TransferQueueDialog(transferMgr_, this);
@@ -1605,6 +1676,7 @@ void MainWindow::moveRightToLeft() {
 
     // Remote -> Local: enqueue downloads and delete remote on completion
     if (!sftp_ || !rightRemoteModel_) { QMessageBox::warning(this, tr("SFTP"), tr("No hay sesión SFTP activa.")); return; }
+    if (!confirmRemoteWritable()) return; // sources are deleted afterwards
     const auto rows = sel->selectedRows(NAME_COL);
     const QString remoteBase = rightRemoteModel_->rootPath();
     QVector<QPair<QString, QString>> pairs; // (remote, local) files to download
@@ -1620,21 +1692,9 @@ void MainWindow::moveRightToLeft() {
         const bool isDir = rightRemoteModel_->isDir(idx);
         top.push_back({ rpath, isDir });
         if (isDir) {
-            QVector<QPair<QString, QString>> stack; stack.push_back({ rpath, lpath });
-            while (!stack.isEmpty()) {
-                auto pair = stack.back(); stack.pop_back();
-                const QString curR = pair.first; const QString curL = pair.second; QDir().mkpath(curL);
-                std::vector<openscp::FileInfo> out; std::string lerr;
-                if (!sftp_->list(curR.toStdString(), out, lerr)) continue;
-                for (const auto& e : out) {
-                    const QString ename = QString::fromStdString(e.name);
-                    QString why; if (!isValidEntryName(ename, &why)) { ++bad; continue; }
-                    const QString childR = (curR.endsWith('/') ? curR + ename : curR + "/" + ename);
-                    const QString childL = QDir(curL).filePath(ename);
-                    if (e.is_dir) { stack.push_back({ childR, childL }); }
-                    else { QDir().mkpath(QFileInfo(childL).dir().absolutePath()); pairs.push_back({ childR, childL }); }
-                }
-            }
+            collectRemoteTree(rpath, lpath, bad, [&](const RemoteTreeFile& f) {
+                pairs.push_back({ transferMgr_->pathOf(f.remote), transferMgr_->pathOf(f.local) });
+            });
         } else {
             QDir().mkpath(QFileInfo(lpath).dir().absolutePath());
             pairs.push_back({ rpath, lpath });
@@ -1748,6 +1808,7 @@ void MainWindow::moveRightToLeft() {
 
 void MainWindow::uploadViaDialog() {
     if (!rightIsRemote_ || !sftp_ || !rightRemoteModel_) { QMessageBox::information(this, tr("Subir"), tr("El panel derecho no es remoto o no hay sesión activa.")); return; }
+    if (!confirmRemoteWritable()) return;
     const QString startDir = uploadDir_.isEmpty() ? QDir::homePath() : uploadDir_;
     QFileDialog dlg(this, tr("Selecciona archivos o carpetas a subir"), startDir);
     dlg.setFileMode(QFileDialog::ExistingFiles);
@@ -1759,19 +1820,20 @@ void MainWindow::uploadViaDialog() {
     const QStringList picks = dlg.selectedFiles();
     if (picks.isEmpty()) return;
     uploadDir_ = QFileInfo(picks.first()).dir().absolutePath();
+    const QString remoteBase = rightRemoteModel_->rootPath();
     QStringList files;
+    int walks = 0; // folders scanned in the background while their files upload
     for (const QString& p : picks) {
         QFileInfo fi(p);
         if (fi.isDir()) {
-            QDirIterator it(p, QDir::NoDotAndDotDot | QDir::AllEntries, QDirIterator::Subdirectories);
-            while (it.hasNext()) { it.next(); if (it.fileInfo().isFile()) files << it.filePath(); }
+            transferMgr_->enqueueUploadFeed(fi.absoluteFilePath(), joinRemotePath(remoteBase, fi.fileName()), transferRules());
+            ++walks;
         } else if (fi.isFile()) {
             files << fi.absoluteFilePath();
         }
     }
-    if (files.isEmpty()) { statusBar()->showMessage(tr("Nada para subir."), 4000); return; }
+    if (files.isEmpty() && walks == 0) { statusBar()->showMessage(tr("Nada para subir."), 4000); return; }
     int enq = 0;
-    const QString remoteBase = rightRemoteModel_->rootPath();
     for (const QString& localPath : files) {
         const QFileInfo fi(localPath);
         QString relBase = fi.path().startsWith(uploadDir_) ? fi.path().mid(uploadDir_.size()).trimmed() : QString();
@@ -1790,8 +1852,10 @@ void MainWindow::uploadViaDialog() {
         transferMgr_->enqueueUpload(localPath, rTarget);
         ++enq;
     }
-    if (enq > 0) {
-        statusBar()->showMessage(QString(tr("Encolados: %1 subidas")).arg(enq), 4000);
+    if (enq > 0 || walks > 0) {
+        QString msg = QString(tr("Encolados: %1 subidas")).arg(enq);
+        if (walks > 0) msg += QString("  |  ") + tr("Carpetas en curso: %1").arg(walks);
+        statusBar()->showMessage(msg, 4000);
         if (!transferDlg_) transferDlg_ = new TransferQueueDialog(transferMgr_, this);
         transferDlg_->show(); transferDlg_->raise(); transferDlg_->activateWindow();
     }
@@ -1807,11 +1871,12 @@ void MainWindow::newDirRight() {
     QString why; if (!isValidEntryName(name, &why)) { QMessageBox::warning(this, tr("Nombre inválido"), why); return; }
     if (rightIsRemote_) {
         if (!sftp_ || !rightRemoteModel_) return;
+        if (!confirmRemoteWritable()) return;
         const QString path = joinRemotePath(rightRemoteModel_->rootPath(), name);
         std::string err;
         if (!sftp_->mkdir(path.toStdString(), err, 0755)) { QMessageBox::critical(this, tr("SFTP"), QString::fromStdString(err)); return; }
-        QString dummy;
-        rightRemoteModel_->setRootPath(rightRemoteModel_->rootPath(), &dummy);
+        refreshRemoteEntry(name);
+        revalidateRemoteIfEnabled();
         updateRemoteWriteability();
     } else {
         QDir base(rightPath_->text());
@@ -1828,6 +1893,7 @@ void MainWindow::newFileRight() {
     QString why; if (!isValidEntryName(name, &why)) { QMessageBox::warning(this, tr("Nombre inválido"), why); return; }
     if (rightIsRemote_) {
         if (!sftp_ || !rightRemoteModel_) return;
+        if (!confirmRemoteWritable()) return;
         const QString remotePath = joinRemotePath(rightRemoteModel_->rootPath(), name);
         bool isDir = false; std::string e;
         bool exists = sftp_->exists(remotePath.toStdString(), isDir, e);
@@ -1846,7 +1912,8 @@ void MainWindow::newFileRight() {
         std::string err;
         bool okPut = sftp_->put(tmp.fileName().toStdString(), remotePath.toStdString(), err);
         if (!okPut) { QMessageBox::critical(this, tr("SFTP"), QString::fromStdString(err)); return; }
-        QString dummy; rightRemoteModel_->setRootPath(rightRemoteModel_->rootPath(), &dummy);
+        refreshRemoteEntry(name);
+        revalidateRemoteIfEnabled();
         updateRemoteWriteability();
         statusBar()->showMessage(tr("Archivo creado: ") + remotePath, 4000);
     } else {
@@ -1873,6 +1940,7 @@ void MainWindow::renameRightSelected() {
     if (rows.size() != 1) { QMessageBox::information(this, tr("Renombrar"), tr("Selecciona exactamente un elemento.")); return; }
     if (rightIsRemote_) {
         if (!sftp_ || !rightRemoteModel_) return;
+        if (!confirmRemoteWritable()) return;
         const QModelIndex idx = rows.first();
         const QString oldName = rightRemoteModel_->nameAt(idx);
         bool ok = false;
@@ -1883,8 +1951,9 @@ void MainWindow::renameRightSelected() {
         const QString to   = joinRemotePath(base, newName);
         std::string err;
         if (!sftp_->rename(from.toStdString(), to.toStdString(), err, false)) { QMessageBox::critical(this, tr("SFTP"), QString::fromStdString(err)); return; }
-        QString dummy;
-        rightRemoteModel_->setRootPath(base, &dummy);
+        rightRemoteModel_->removeEntries({ oldName });
+        refreshRemoteEntry(newName);
+        revalidateRemoteIfEnabled();
         updateRemoteWriteability();
     } else {
         const QModelIndex idx = rows.first();
@@ -1957,50 +2026,53 @@ void MainWindow::deleteRightSelected() {
     if (rows.isEmpty()) { QMessageBox::information(this, tr("Borrar"), tr("Nada seleccionado.")); return; }
     if (rightIsRemote_) {
         if (!sftp_ || !rightRemoteModel_) return;
+        if (!confirmRemoteWritable()) return;
         if (QMessageBox::warning(this, tr("Confirmar borrado"), tr("Esto eliminará permanentemente en el servidor remoto.\n¿Continuar?"), QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) return;
         int ok = 0, fail = 0;
         QString lastErr;
         const QString base = rightRemoteModel_->rootPath();
-        std::function<bool(const QString&)> delRec = [&](const QString& p) {
-            // Determine if path is a directory or a file using stat/exists
-            bool isDir = false;
-            std::string xerr;
-            if (!sftp_->exists(p.toStdString(), isDir, xerr)) {
-                // If it doesn't exist, treat as success
-                if (xerr.empty()) return true;
-                lastErr = QString::fromStdString(xerr);
-                return false;
-            }
-            if (!isDir) {
-                std::string ferr;
-                if (!sftp_->removeFile(p.toStdString(), ferr)) { lastErr = QString::fromStdString(ferr); return false; }
-                return true;
-            }
-            // Directory: list and remove children first (depth-first)
-            std::vector<openscp::FileInfo> out;
-            std::string lerr;
-            if (!sftp_->list(p.toStdString(), out, lerr)) {
-                lastErr = QString::fromStdString(lerr);
-                return false;
-            }
-            for (const auto& e : out) {
-                const QString child = joinRemotePath(p, QString::fromStdString(e.name));
-                if (!delRec(child)) return false;
+        // Whole selection in one pass: stat, walk, then batched unlink/rmdir (deepest first)
+        std::vector<std::string> roots;
+        for (const QModelIndex& idx : rows)
+            roots.push_back(joinRemotePath(base, rightRemoteModel_->nameAt(idx)).toStdString());
+        openscp::SftpClient::PathErrors failures;
+        std::string rerr;
+        bool batchFailed = false;
+        if (!sftp_->removeRecursive(roots, failures, rerr)) {
+            batchFailed = true;
+            fail = (int)roots.size();
+            lastErr = QString::fromStdString(rerr);
+        } else {
+            // A root fails if anything at or below it failed
+            for (const auto& r : roots) {
+                const std::string prefix = r + "/";
+                bool rootFailed = false;
+                for (const auto& f : failures) {
+                    if (f.first == r || f.first.rfind(prefix, 0) == 0) {
+                        rootFailed = true;
+                        lastErr = QString::fromStdString(f.second);
+                        break;
+                    }
+                }
+                if (rootFailed) ++fail; else ++ok;
             }
-            std::string derr;
-            if (!sftp_->removeDir(p.toStdString(), derr)) { lastErr = QString::fromStdString(derr); return false; }
-            return true;
-        };
-        for (const QModelIndex& idx : rows) {
-            const QString name = rightRemoteModel_->nameAt(idx);
-            const QString path = joinRemotePath(base, name);
-            if (delRec(path)) ++ok; else ++fail;
         }
     QString msg = QString(tr("Borrados OK: %1  |  Fallidos: %2")).arg(ok).arg(fail);
         if (fail > 0 && !lastErr.isEmpty()) msg += "\n" + tr("Último error: ") + lastErr;
         statusBar()->showMessage(msg, 6000);
-        QString dummy;
-        rightRemoteModel_->setRootPath(base, &dummy);
+        // Drop the roots that are gone; partially deleted folders stay listed
+        QStringList removed;
+        for (const QModelIndex& idx : rows) {
+            const QString name = rightRemoteModel_->nameAt(idx);
+            const std::string r = joinRemotePath(base, name).toStdString();
+            const std::string prefix = r + "/";
+            const bool failed = std::any_of(failures.begin(), failures.end(), [&](const auto& f) {
+                return f.first == r || f.first.rfind(prefix, 0) == 0;
+            });
+            if (!failed && !batchFailed) removed << name;
+        }
+        rightRemoteModel_->removeEntries(removed);
+        revalidateRemoteIfEnabled();
         updateRemoteWriteability();
     } else {
         if (QMessageBox::warning(this, tr("Confirmar borrado"), tr("Esto eliminará permanentemente en el disco local.\n¿Continuar?"), QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) return;
@@ -2042,6 +2114,7 @@ void MainWindow::showRightContextMenu(const QPoint& pos) {
 
         // Always show "Download" on remote, regardless of selection
         if (actDownloadF7_) rightContextMenu_->addAction(actDownloadF7_);
+        if (hasSel) rightContextMenu_->addAction(tr("Descargar con exclusiones…"), this, [this] { runWithExcludes(&MainWindow::downloadRightToLeft); });
 
         if (!hasSel) {
             // No selection: creation and navigation
@@ -2110,6 +2183,7 @@ void MainWindow::showLeftContextMenu(const QPoint& pos) {
         leftContextMenu_->addSeparator();
         // Directional labels in the menu, wired to existing actions
         leftContextMenu_->addAction(tr("Copiar al panel derecho"), this, &MainWindow::copyLeftToRight);
+        if (rightIsRemote_) leftContextMenu_->addAction(tr("Subir con exclusiones…"), this, [this] { runWithExcludes(&MainWindow::copyLeftToRight); });
         leftContextMenu_->addAction(tr("Mover al panel derecho"), this, &MainWindow::moveLeftToRight);
         if (actDelete_)   leftContextMenu_->addAction(actDelete_);
     }
@@ -2134,36 +2208,31 @@ void MainWindow::changeRemotePermissions() {
     dlg.setMode(st.mode & 0777);
     if (dlg.exec() != QDialog::Accepted) return;
     unsigned int newMode = (st.mode & ~0777u) | (dlg.mode() & 0777u);
-    auto applyOne = [&](const QString& p) -> bool {
-        std::string cerrs;
-        if (!sftp_->chmod(p.toStdString(), newMode, cerrs)) { QMessageBox::critical(this, tr("Permisos"), QString::fromStdString(cerrs)); return false; }
-        return true;
-    };
     bool ok = true;
     if (dlg.recursive() && st.is_dir) {
-        QVector<QString> stack;
-        stack.push_back(path);
-        while (!stack.isEmpty() && ok) {
-            const QString cur = stack.back();
-            stack.pop_back();
-            if (!applyOne(cur)) { ok = false; break; }
-            std::vector<openscp::FileInfo> out;
-            std::string lerr;
-            if (!sftp_->list(cur.toStdString(), out, lerr)) continue;
-            for (const auto& e : out) {
-                const QString child = joinRemotePath(cur, QString::fromStdString(e.name));
-                if (e.is_dir) stack.push_back(child);
-                else {
-                    if (!applyOne(child)) { ok = false; break; }
-                }
-            }
+        // Walk once, then send the SETSTATs in pipelined batches
+        openscp::SftpClient::PathErrors failures;
+        std::string cerr;
+        if (!sftp_->chmodRecursive(path.toStdString(), newMode & 07777u, failures, cerr)) {
+            QMessageBox::critical(this, tr("Permisos"), QString::fromStdString(cerr));
+            ok = false;
+        } else if (!failures.empty()) {
+            QMessageBox::warning(this, tr("Permisos"),
+                                 tr("No se pudieron actualizar %1 elementos.\nPrimer error: %2 (%3)")
+                                     .arg(failures.size())
+                                     .arg(QString::fromStdString(failures.front().second))
+                                     .arg(QString::fromStdString(failures.front().first)));
         }
     } else {
-        ok = applyOne(path);
+        std::string cerrs;
+        if (!sftp_->chmod(path.toStdString(), newMode, cerrs)) {
+            QMessageBox::critical(this, tr("Permisos"), QString::fromStdString(cerrs));
+            ok = false;
+        }
     }
     if (!ok) return;
-    QString dummy;
-    rightRemoteModel_->setRootPath(base, &dummy);
+    remoteAccess_.clear(); // modes below (or of) this folder changed
+    refreshRemoteEntry(name);
     updateRemoteWriteability();
     statusBar()->showMessage(tr("Permisos actualizados"), 3000);
 }
@@ -2352,8 +2421,7 @@ bool MainWindow::eventFilter(QObject* obj, QEvent* ev) {
             if (urls.isEmpty()) { dd->acceptProposedAction(); return true; }
             if (rightIsRemote_) {
                 // Block upload if remote is read-only
-                if (!rightRemoteWritable_) {
-                    statusBar()->showMessage(tr("Directorio remoto en solo lectura; no se puede subir aquí"), 5000);
+                if (!confirmRemoteWritable()) {
                     dd->ignore();
                     return true;
                 }
@@ -2361,28 +2429,24 @@ bool MainWindow::eventFilter(QObject* obj, QEvent* ev) {
                 if (!sftp_ || !rightRemoteModel_) { dd->acceptProposedAction(); return true; }
                 const QString remoteBase = rightRemoteModel_->rootPath();
                 int enq = 0;
+                int walks = 0; // folders queued while still being enumerated
                 for (const QUrl& u : urls) {
                     const QString p = u.toLocalFile();
                     if (p.isEmpty()) continue;
                     QFileInfo fi(p);
                     if (fi.isDir()) {
-                        QDirIterator it(p, QDir::NoDotAndDotDot | QDir::AllEntries, QDirIterator::Subdirectories);
-                        while (it.hasNext()) {
-                            it.next();
-                            if (!it.fileInfo().isFile()) continue;
-                            const QString rel = QDir(p).relativeFilePath(it.filePath());
-                            const QString rTarget = joinRemotePath(remoteBase, rel);
-                            transferMgr_->enqueueUpload(it.filePath(), rTarget);
-                            ++enq;
-                        }
+                        transferMgr_->enqueueUploadFeed(p, remoteBase, transferRules());
+                        ++walks;
                     } else if (fi.isFile()) {
                         const QString rTarget = joinRemotePath(remoteBase, fi.fileName());
                         transferMgr_->enqueueUpload(fi.absoluteFilePath(), rTarget);
                         ++enq;
                     }
                 }
-    if (enq > 0) {
-        statusBar()->showMessage(QString(tr("Encolados: %1 subidas (DND)")).arg(enq), 4000);
+    if (enq > 0 || walks > 0) {
+        QString msg = QString(tr("Encolados: %1 subidas (DND)")).arg(enq);
+        if (walks > 0) msg += QString("  |  ") + tr("Carpetas en curso: %1").arg(walks);
+        statusBar()->showMessage(msg, 4000);
         if (!transferDlg_) transferDlg_ = new TransferQueueDialog(transferMgr_, this);
         transferDlg_->show(); transferDlg_->raise(); transferDlg_->activateWindow();
     }
@@ -2462,6 +2526,7 @@ bool MainWindow::eventFilter(QObject* obj, QEvent* ev) {
                 const auto rows = sel->selectedRows(NAME_COL);
                 int enq = 0;
                 int bad = 0;
+                int walks = 0; // folders queued while still being enumerated
                 const QString remoteBase = rightRemoteModel_->rootPath();
                 QDir dst(leftPath_->text());
                 for (const QModelIndex& idx : rows) {
@@ -2472,33 +2537,22 @@ bool MainWindow::eventFilter(QObject* obj, QEvent* ev) {
                     rpath += name;
                     const QString lpath = dst.filePath(name);
                     if (rightRemoteModel_->isDir(idx)) {
-                        QVector<QPair<QString, QString>> stack;
-                        stack.push_back({ rpath, lpath });
-                        while (!stack.isEmpty()) {
-                            auto pair = stack.back();
-                            stack.pop_back();
-                            const QString curR = pair.first;
-                            const QString curL = pair.second;
-                            QDir().mkpath(curL);
-                            std::vector<openscp::FileInfo> out;
-                            std::string lerr;
-                            if (!sftp_->list(curR.toStdString(), out, lerr)) continue;
-                            for (const auto& e : out) {
-                                const QString ename = QString::fromStdString(e.name);
-                                QString why; if (!isValidEntryName(ename, &why)) { ++bad; continue; }
-                                const QString childR = (curR.endsWith('/') ? curR + ename : curR + "/" + ename);
-                                const QString childL = QDir(curL).filePath(ename);
-                                if (e.is_dir) stack.push_back({ childR, childL });
-                                else { transferMgr_->enqueueDownload(childR, childL); ++enq; }
-                            }
+                        if (transferMgr_->enqueueDownloadFeed(rpath, lpath, acceptEntryName, transferRules())) {
+                            ++walks;
+                            continue;
                         }
+                        collectRemoteTree(rpath, lpath, bad, [&](const RemoteTreeFile& f) {
+                            transferMgr_->enqueueDownload(f.remote, f.local, f.size);
+                            ++enq;
+                        });
                     } else {
                         transferMgr_->enqueueDownload(rpath, lpath);
                         ++enq;
                     }
                 }
-                if (enq > 0) {
+                if (enq > 0 || walks > 0) {
                     QString msg = QString(tr("Encolados: %1 descargas (DND)")).arg(enq);
+                    if (walks > 0) msg += QString("  |  ") + tr("Carpetas en curso: %1").arg(walks);
                     if (bad > 0) msg += QString("  |  ") + tr("Omitidos inválidos: %1").arg(bad);
                     statusBar()->showMessage(msg, 4000);
                     if (!transferDlg_) transferDlg_ = new TransferQueueDialog(transferMgr_, this);
@@ -2620,7 +2674,16 @@ bool MainWindow::establishSftpAsync(openscp::SessionOptions opt, std::string& er
             auto tmp = std::make_unique<openscp::Libssh2SftpClient>();
             okConn = tmp->connect(opt, err);
             if (okConn) {
-                QMetaObject::invokeMethod(this, [this, t = tmp.release()] { sftp_.reset(t); }, Qt::BlockingQueuedConnection);
+                // Exec probes are cached per session: run them here, not on the GUI thread
+                openscp::SftpClient::RemoteIdentity id;
+                std::string ierr;
+                tmp->remoteIdentity(id, ierr);
+                if (QSettings("OpenSCP", "OpenSCP").value("Advanced/tarFolderTransfers", false).toBool())
+                    tmp->execTreeAvailable();
+                // Listings/stats are cached in front of the session (instant back/up navigation)
+                QMetaObject::invokeMethod(this, [this, t = tmp.release()] {
+                    sftp_ = std::make_unique<openscp::CachingSftpClient>(std::unique_ptr<openscp::SftpClient>(t));
+                }, Qt::BlockingQueuedConnection);
             }
         } catch (const std::exception& ex) {
             err = std::string("Excepción en conexión: ") + ex.what();
@@ -2643,7 +2706,10 @@ void MainWindow::applyRemoteConnectedUI(const openscp::SessionOptions& opt) {
     delete rightRemoteModel_;
     rightRemoteModel_ = new RemoteModel(sftp_.get(), this);
     rightRemoteModel_->setShowHidden(prefShowHidden_);
+    if (rightFilter_) { rightFilter_->clear(); rightFilter_->setEnabled(true); }
+    if (rightFilterType_) { rightFilterType_->setCurrentIndex(0); rightFilterType_->setEnabled(true); }
     QString e;
+    // Initial listing stays synchronous so a failure aborts the connection cleanly
     if (!rightRemoteModel_->setRootPath("/", &e)) {
         QMessageBox::critical(this, "Error listando remoto", e);
         sftp_.reset();
@@ -2651,6 +2717,8 @@ void MainWindow::applyRemoteConnectedUI(const openscp::SessionOptions& opt) {
         rightRemoteModel_ = nullptr;
         return;
     }
+    rightRemoteModel_->enableAsyncListing(opt);
+    connect(rightRemoteModel_, &RemoteModel::listingFinished, this, &MainWindow::onRightListingFinished);
     rightView_->setModel(rightRemoteModel_);
     if (rightView_->selectionModel()) {
         connect(rightView_->selectionModel(), &QItemSelectionModel::selectionChanged, this, [this]{ updateDeleteShortcutEnables(); });
@@ -2682,6 +2750,12 @@ void MainWindow::applyRemoteConnectedUI(const openscp::SessionOptions& opt) {
     }
     statusBar()->showMessage(tr("Conectado (SFTP) a ") + QString::fromStdString(opt.host), 4000);
     setWindowTitle(tr("OpenSCP — local/remoto (SFTP)"));
+    remoteAccess_.clear();
+    siteExcludes_ = SiteManagerDialog::excludeRulesFor(opt);
+    {
+        std::string ierr;
+        remoteIdKnown_ = sftp_->remoteIdentity(remoteId_, ierr);
+    }
     updateRemoteWriteability();
     updateDeleteShortcutEnables();
 }
@@ -2705,13 +2779,12 @@ void MainWindow::applyPreferences() {
     applyLocalFilters(leftModel_);
     applyLocalFilters(rightLocalModel_);
 
-    // Remote: re-list with hidden filter
+    // Transfer queue: memory budget before tasks spill to disk
+    if (transferMgr_) transferMgr_->setQueueMemoryBudgetMB(s.value("Advanced/queueMemoryMB", 512).toInt());
+
+    // Remote: hidden entries are filtered in memory (no re-list)
     prefShowHidden_ = showHidden;
-    if (rightRemoteModel_) {
-        rightRemoteModel_->setShowHidden(showHidden);
-        QString dummy;
-        rightRemoteModel_->setRootPath(rightRemoteModel_->rootPath(), &dummy);
-    }
+    if (rightRemoteModel_) rightRemoteModel_->setShowHidden(showHidden);
 
     // Single-click activation (connect/disconnect to clicked())
     if (prefSingleClick_ != singleClick) {
@@ -2728,24 +2801,28 @@ void MainWindow::applyPreferences() {
 
 // Check if the current remote directory is writable and update enables.
 void MainWindow::updateRemoteWriteability() {
-    // Determine if the current remote directory is writable by attempting to create and delete
-    // a temporary folder. Conservative: if it fails, consider read-only.
+    // Infer from the directory's mode/uid/gid (one cached stat, no server-side writes).
+    // Bits only ever prove access: a denial may be lifted by ACLs or groups we cannot see,
+    // and a guessed identity proves nothing, so those stay Unknown and the first write
+    // attempt probes (confirmRemoteWritable).
     if (!rightIsRemote_ || !sftp_ || !rightRemoteModel_) {
         rightRemoteWritable_ = false;
         return;
     }
     const QString base = rightRemoteModel_->rootPath();
-    const QString testName = ".openscp-write-test-" + QString::number(QDateTime::currentMSecsSinceEpoch());
-    const QString testPath = base.endsWith('/') ? base + testName : base + "/" + testName;
-    std::string err;
-    bool created = sftp_->mkdir(testPath.toStdString(), err, 0755);
-    if (created) {
-        std::string derr;
-        sftp_->removeDir(testPath.toStdString(), derr);
-        rightRemoteWritable_ = true;
+    auto it = remoteAccess_.constFind(base);
+    RemoteAccess acc = RemoteAccess::Unknown;
+    if (it != remoteAccess_.constEnd()) {
+        acc = *it;
     } else {
-        rightRemoteWritable_ = false;
+        openscp::FileInfo st{};
+        std::string err;
+        if (remoteIdKnown_ && remoteId_.exact && sftp_->stat(base.toStdString(), st, err) && st.is_dir && (st.mode & 07777)
+            && openscp::SftpClient::canModifyDir(st, remoteId_))
+            acc = RemoteAccess::Writable;
+        remoteAccess_.insert(base, acc);
     }
+    rightRemoteWritable_ = (acc != RemoteAccess::ReadOnly);
     // Reflect in actions that require write access
     if (actUploadRight_) actUploadRight_->setEnabled(rightRemoteWritable_);
     if (actNewDirRight_)  actNewDirRight_->setEnabled(rightRemoteWritable_);
@@ -2756,6 +2833,127 @@ void MainWindow::updateRemoteWriteability() {
     if (actMoveRightTb_)  actMoveRightTb_->setEnabled(rightRemoteWritable_);
     updateDeleteShortcutEnables();
 }
+
+bool MainWindow::confirmRemoteWritable() {
+    if (!rightIsRemote_ || !sftp_ || !rightRemoteModel_) return true;
+    const QString base = rightRemoteModel_->rootPath();
+    RemoteAccess acc = remoteAccess_.value(base, RemoteAccess::Unknown);
+    if (acc == RemoteAccess::Unknown) {
+        // Permission bits were not conclusive: create and remove a temporary folder (once
+        // per folder; the verdict is cached)
+        const QString testName = ".openscp-write-test-" + QString::number(QDateTime::currentMSecsSinceEpoch());
+        const QString testPath = base.endsWith('/') ? base + testName : base + "/" + testName;
+        std::string err;
+        if (sftp_->mkdir(testPath.toStdString(), err, 0755)) {
+            std::string derr;
+            sftp_->removeDir(testPath.toStdString(), derr);
+            acc = RemoteAccess::Writable;
+        } else {
+            acc = RemoteAccess::ReadOnly;
+        }
+        remoteAccess_.insert(base, acc);
+        updateRemoteWriteability();
+    }
+    if (acc == RemoteAccess::ReadOnly) {
+        statusBar()->showMessage(tr("Directorio remoto en solo lectura; no se puede subir aquí"), 5000);
+        return false;
+    }
+    return true;
+}
+
+// Recursive listing for folder downloads: shared with the drag-out path, so folders are
+// listed in parallel (pooled sessions) with the same depth limit and cycle guard.
+void MainWindow::collectRemoteTree(const QString& rpath, const QString& lpath, int& bad,
+                                   const std::function<void(const RemoteTreeFile&)>& onFile) {
+    if (!rightRemoteModel_) return;
+    RemoteModel::EnumOptions opt;
+    opt.maxDepth = 0;            // Advanced/maxFolderDepth
+    opt.skipSymlinks = false;    // links are transferred as entries, never followed
+    opt.includeHidden = true;    // the whole folder, whatever the view shows
+    opt.accept = [&bad](const QString& name, bool) {
+        QString why;
+        if (isValidEntryName(name, &why)) return true;
+        ++bad;
+        return false;
+    };
+    std::vector<QString> dirs;
+    opt.dirsOut = &dirs;
+    const auto rules = transferRules();
+    opt.rules = rules.get();
+    RemoteModel::EnumeratedFiles found;
+    found.paths = transferMgr_->paths();
+    if (const std::size_t budget = transferMgr_->queueMemoryBudgetBytes()) {
+        found.spillAfter = budget / sizeof(RemoteModel::EnumeratedFile);
+        found.spillDir = TransferManager::spillDirectory();
+    }
+    bool partial = false, someUnknown = false;
+    // A walk whose connection could not be recovered picks up where it stopped
+    openscp::EnumCursor cursor;
+    opt.cursor = &cursor;
+    for (int pass = 0; pass < kTreeWalkPasses; ++pass) {
+        rightRemoteModel_->enumerateFilesUnderEx(rpath, found, opt, &partial, &someUnknown);
+        if (cursor.empty()) break;
+    }
+    if (!cursor.empty()) {
+        statusBar()->showMessage(tr("Conexión perdida: %1 carpetas sin enumerar en %2").arg(cursor.pending.size()).arg(rpath), 8000);
+    }
+    const QDir root(lpath);
+    QDir().mkpath(lpath);
+    for (const QString& d : dirs) QDir().mkpath(root.filePath(d)); // empty folders too
+    const auto localRoot = found.paths->dir(lpath.toStdString());
+    found.drain([&](const RemoteModel::EnumeratedFile& f) {
+        onFile({ f.path, found.localPath(f, localRoot), f.hasSize ? (qint64)f.size : -1 });
+    });
+}
+
+std::shared_ptr<const openscp::PathRules> MainWindow::transferRules() const {
+    QSettings s("OpenSCP", "OpenSCP");
+    const QString text = s.value("Transfer/excludeRules").toString() + '\n' + siteExcludes_ + '\n' + opExcludes_;
+    auto rules = std::make_shared<openscp::PathRules>(text.toStdString());
+    if (rules->empty()) return nullptr;
+    return rules;
+}
+
+void MainWindow::runWithExcludes(void (MainWindow::*op)()) {
+    bool ok = false;
+    const QString rules = QInputDialog::getMultiLineText(this, tr("Transferir con exclusiones"),
+                                                         tr("Reglas estilo .gitignore solo para esta transferencia (se suman a las de Ajustes y del sitio):"),
+                                                         lastOpExcludes_, &ok);
+    if (!ok) return;
+    lastOpExcludes_ = rules;
+    opExcludes_ = rules;
+    (this->*op)();
+    opExcludes_.clear();
+}
+
+void MainWindow::refreshRemoteEntry(const QString& name) {
+    if (!sftp_ || !rightRemoteModel_) return;
+    const QString path = joinRemotePath(rightRemoteModel_->rootPath(), name);
+    openscp::FileInfo st{};
+    std::string err;
+    if (!sftp_->stat(path.toStdString(), st, err)) {
+        // Cannot describe the new entry: fall back to a full refresh
+        QString dummy;
+        rightRemoteModel_->setRootPath(rightRemoteModel_->rootPath(), &dummy);
+        return;
+    }
+    st.name = name.toStdString();
+    rightRemoteModel_->upsertEntry(st);
+}
+
+void MainWindow::revalidateRemoteIfEnabled() {
+    if (!rightRemoteModel_) return;
+    QSettings s("OpenSCP", "OpenSCP");
+    if (s.value("Advanced/revalidateAfterEdits", true).toBool()) rightRemoteModel_->revalidate();
+}
+
+bool MainWindow::useTarForFolders() {
+    QSettings s("OpenSCP", "OpenSCP");
+    if (!s.value("Advanced/tarFolderTransfers", false).toBool()) return false;
+    if (!sftp_) return false;
+    // Falls back to per-file transfers when exec or tar is not available
+    return sftp_->execTreeAvailable();
+}
     // Enablement rules for buttons/shortcuts on both sub‑toolbars.
 // - General: require a selection.
 // - Exceptions: Up (if parent exists), Upload… (remote RW), Download (remote).
@@ -1,6 +1,7 @@
 // Declaration of the main window and its state/actions.
 #pragma once
 #include <QMainWindow>
+#include <QHash>
 #include <QFileSystemModel>
 #include <QTreeView>
 #include <QLineEdit>
@@ -8,15 +9,20 @@
 #include <string>
 #include <QPointer>
 #include <memory>
+#include <vector>
+#include <functional>
 #include <condition_variable>
+#include "openscp/PathRules.hpp"
+#include "openscp/PathStore.hpp"
+#include "openscp/SftpClient.hpp"
 
 class RemoteModel;              // fwd
 class QModelIndex;              // fwd for slot signatures
 class QToolBar;                 // fwd
+class QComboBox;                // fwd
 class QMenu;                    // fwd
 class QEvent;                   // fwd for eventFilter
 class QDialog;                  // fwd
-namespace openscp { class SftpClient; struct SessionOptions; } // fwd
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -32,6 +38,7 @@ public:
 protected:
     bool eventFilter(QObject* obj, QEvent* ev) override;
     void showEvent(QShowEvent* e) override;
+    void changeEvent(QEvent* e) override;
 
 private slots:
     void chooseLeftDir();
@@ -49,6 +56,7 @@ private slots:
     void connectSftp();
     void disconnectSftp();
     void rightItemActivated(const QModelIndex& idx); // double click on remote
+    void onRightListingFinished(const QString& path, bool ok, const QString& error); // async remote listing done
     void leftItemActivated(const QModelIndex& idx);  // double click on local (left)
     void downloadRightToLeft(); // remote -> local
     void uploadViaDialog();     // local -> remote (dialog: files or folder)
@@ -89,6 +97,9 @@ private:
 
     QLineEdit* leftPath_  = nullptr;
     QLineEdit* rightPath_ = nullptr;
+    // Remote listing filters (name: substring or globs; type: all/files/folders)
+    QLineEdit* rightFilter_ = nullptr;
+    QComboBox* rightFilterType_ = nullptr;
 
     // Actions
     QAction* actChooseLeft_  = nullptr;
@@ -162,8 +173,37 @@ private:
 
     // Writable state of the current remote directory
     bool rightRemoteWritable_ = false;
-    // Recompute if the current remote directory is writable (create/remove a temporary folder)
+    // Inferred from the directory's mode/uid/gid against the login identity (fetched once
+    // at connect) and cached per directory. Unknown means "assume writable": a real
+    // create/remove probe runs only when the user first attempts a write there.
+    enum class RemoteAccess { Writable, ReadOnly, Unknown };
+    QHash<QString, RemoteAccess> remoteAccess_;
+    openscp::SftpClient::RemoteIdentity remoteId_;
+    bool remoteIdKnown_ = false;
     void updateRemoteWriteability();
+    // Before a remote write: resolves Unknown with a probe. False (and a message) if read-only.
+    bool confirmRemoteWritable();
+    // After a successful remote edit: update the affected rows in place (stat of the entry)
+    // and optionally re-list in the background (Advanced/revalidateAfterEdits)
+    void refreshRemoteEntry(const QString& name);
+    void revalidateRemoteIfEnabled();
+    // True if folders should be transferred as one tar stream (preference + server exec support)
+    bool useTarForFolders();
+    // Files under remote folder rpath mapped below local lpath (local folders are created),
+    // handed to onFile in listing order. Entries with invalid names are skipped and counted
+    // in bad. Paths are interned in the transfer queue's store (TransferManager::paths());
+    // listings past the queue's memory budget wait on disk until they are handed over.
+    struct RemoteTreeFile { openscp::PathRef remote; openscp::PathRef local; qint64 size; };
+    void collectRemoteTree(const QString& rpath, const QString& lpath, int& bad,
+                           const std::function<void(const RemoteTreeFile&)>& onFile);
+    // Folder transfer exclusions: Settings (every site) + current site + this operation,
+    // later rules winning. nullptr when there are none.
+    std::shared_ptr<const openscp::PathRules> transferRules() const;
+    // Ask for extra rules for one operation, then run it
+    void runWithExcludes(void (MainWindow::*op)());
+    QString siteExcludes_;  // rules of the connected saved site
+    QString opExcludes_;    // rules of the operation in progress (runWithExcludes)
+    QString lastOpExcludes_; // proposed next time
 
     bool firstShow_ = true;
 
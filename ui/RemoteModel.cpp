@@ -1,9 +1,16 @@
 // Remote model implementation (table: Name, Size, Date, Permissions).
 #include "RemoteModel.hpp"
+#include "openscp/CachingSftpClient.hpp"
 #include <QVariant>
 #include <QDateTime>
 #include "TimeUtils.hpp"
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <iterator>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <QSet>
 #include <QLoggingCategory>
 
@@ -13,64 +20,635 @@ Q_LOGGING_CATEGORY(ocEnum, "openscp.enum")
 #include <QSettings>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFile>
 #include <QUrl>
 #include <QDateTime>
 
+// Rows exposed per fetchMore() call
+static constexpr std::size_t kFetchPage = 1000;
+// Subdirectories prefetched after a listing completes, and navigation history kept
+static constexpr std::size_t kPrefetchDirs = 8;
+static constexpr int kRecentDirs = 32;
+// Upper bound for cached display strings (a few screens worth of rows)
+static constexpr int kDisplayCacheMax = 4096;
+// Row removals in more separate runs than this reset the view instead
+static constexpr std::size_t kRemoveRunsMax = 64;
+// Extra sessions listing folders in parallel during recursive enumeration
+static constexpr std::size_t kEnumSessions = 3;
+
+// "drwxr-xr-x" strings for the three type letters ('-', 'd', 'l') x 512 permission sets,
+// built once; callers get an implicitly shared copy.
+static const QString& permissionText(quint32 mode, bool isDir) {
+    static const std::vector<QString> table = [] {
+        std::vector<QString> t;
+        t.reserve(3 * 512);
+        for (const char type : { '-', 'd', 'l' }) {
+            for (quint32 m = 0; m < 512; ++m) {
+                QString s(10, '-');
+                s[0] = QLatin1Char(type);
+                static const char rwx[] = "rwxrwxrwx";
+                for (int b = 0; b < 9; ++b)
+                    if (m & (0400u >> b)) s[b + 1] = QLatin1Char(rwx[b]);
+                t.push_back(s);
+            }
+        }
+        return t;
+    }();
+    const bool isLnk = (mode & 0170000u) == 0120000u;
+    const std::size_t type = isLnk ? 2 : (isDir ? 1 : 0);
+    return table[type * 512 + (mode & 0777u)];
+}
+
 RemoteModel::RemoteModel(openscp::SftpClient* client, QObject* parent)
     : QAbstractTableModel(parent), client_(client) {}
 
+RemoteModel::~RemoteModel() {
+    stopAsyncListing();
+}
+
+void RemoteModel::stopAsyncListing() {
+    generation_.fetch_add(1); // make the running job stop at its next batch
+    {
+        std::lock_guard<std::mutex> lk(jobMtx_);
+        stopWorker_ = true;
+        pendingJob_.reset();
+        prefetchQueue_.clear();
+    }
+    jobCv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+    enumPool_.reset();
+    asyncOpt_.reset();
+    loading_ = false;
+}
+
+void RemoteModel::enableAsyncListing(const openscp::SessionOptions& opt) {
+    asyncOpt_ = opt;
+    std::lock_guard<std::mutex> lk(jobMtx_);
+    stopWorker_ = false;
+}
+
+void RemoteModel::requestRootPath(const QString& path) {
+    if (!asyncOpt_.has_value()) {
+        QString e;
+        const bool ok = setRootPath(path, &e);
+        emit listingFinished(path, ok, e);
+        return;
+    }
+    const quint64 gen = generation_.fetch_add(1) + 1;
+    // A cached (possibly stale) listing is shown right away and revalidated by the worker
+    openscp::DirListing cached;
+    auto* cache = listingCache();
+    const bool fromCache = cache && cache->peekListing(path.toStdString(), cached);
+    beginResetModel();
+    if (fromCache) {
+        adoptListing(std::move(cached));
+    } else {
+        listing_.clear();
+        nameKeys_.clear();
+        dead_.clear();
+        byName_.clear();
+        byNameUpTo_ = 0;
+        displayCache_.clear();
+        resetRows({});
+    }
+    previousPath_ = currentPath_;
+    currentPath_ = path;
+    loading_ = true;
+    endResetModel();
+    noteVisited(path);
+    {
+        std::lock_guard<std::mutex> lk(jobMtx_);
+        pendingJob_ = ListJob{ path, gen, fromCache, false };
+        prefetchQueue_.clear();
+        if (!worker_.joinable()) worker_ = std::thread([this] { workerLoop(); });
+    }
+    jobCv_.notify_one();
+}
+
+void RemoteModel::workerLoop() {
+    std::unique_lock<std::mutex> lk(jobMtx_);
+    while (true) {
+        jobCv_.wait(lk, [this] { return stopWorker_ || pendingJob_.has_value() || !prefetchQueue_.empty(); });
+        if (stopWorker_) break;
+        if (pendingJob_.has_value()) {
+            // Requested listings always go before prefetch
+            const ListJob job = *pendingJob_;
+            pendingJob_.reset();
+            lk.unlock();
+            runJob(job);
+            lk.lock();
+            continue;
+        }
+        const std::string dir = prefetchQueue_.front();
+        prefetchQueue_.pop_front();
+        const quint64 gen = prefetchGen_;
+        lk.unlock();
+        prefetchOne(dir, gen);
+        lk.lock();
+    }
+    lk.unlock();
+    listSession_.reset();
+}
+
+bool RemoteModel::ensureListSession(std::string& err) {
+    if (listSession_) return true;
+    listSession_ = client_ ? client_->newConnectionLike(*asyncOpt_, err) : nullptr;
+    return (bool)listSession_;
+}
+
+void RemoteModel::runJob(const ListJob& job) {
+    auto stale = [this, &job] { return generation_.load() != job.gen; };
+    if (stale()) return;
+    std::string cerr;
+    if (!ensureListSession(cerr)) {
+        // No side session available: list synchronously on the GUI thread instead
+        qWarning(ocEnum) << "async listing session unavailable:" << QString::fromStdString(cerr);
+        const QString path = job.path;
+        const quint64 gen = job.gen;
+        QMetaObject::invokeMethod(this, [this, path, gen] {
+            if (gen != generation_.load()) return;
+            asyncOpt_.reset();
+            loading_ = false;
+            QString e;
+            const bool ok = setRootPath(path, &e);
+            emit listingFinished(path, ok, e);
+        }, Qt::QueuedConnection);
+        return;
+    }
+    std::string err;
+    if (job.revalidate) {
+        // Rows are already shown from the cache; the cache revalidates with one stat
+        auto fresh = std::make_shared<openscp::DirListing>();
+        const bool ok = listSession_->listCompact(job.path.toStdString(), *fresh, err);
+        if (!listSession_->isConnected() || listSession_->transportLost()) listSession_.reset();
+        const quint64 gen = job.gen;
+        const bool quiet = job.quiet;
+        const QString error = QString::fromStdString(err);
+        QMetaObject::invokeMethod(this, [this, gen, ok, quiet, fresh, error] { finishRevalidate(gen, ok, quiet, fresh, error); }, Qt::QueuedConnection);
+        return;
+    }
+    const bool ok = listSession_->listStream(job.path.toStdString(), [&](std::vector<openscp::FileInfo>& batch) {
+        if (stale()) return false;
+        auto chunk = std::make_shared<openscp::DirListing>();
+        chunk->reserve(batch.size());
+        for (const auto& fi : batch) chunk->push(fi);
+        const quint64 gen = job.gen;
+        QMetaObject::invokeMethod(this, [this, gen, chunk] { appendChunk(gen, *chunk); }, Qt::QueuedConnection);
+        return true;
+    }, err, 2000);
+    if (!listSession_->isConnected() || listSession_->transportLost()) listSession_.reset(); // reopened on the next request
+    const quint64 gen = job.gen;
+    const QString error = QString::fromStdString(err);
+    QMetaObject::invokeMethod(this, [this, gen, ok, error] { finishAsync(gen, ok, error); }, Qt::QueuedConnection);
+}
+
+void RemoteModel::finishRevalidate(quint64 gen, bool ok, bool quiet, std::shared_ptr<openscp::DirListing> fresh, const QString& error) {
+    if (gen != generation_.load()) return;
+    if (ok && !matchesListing(*fresh)) {
+        beginResetModel();
+        adoptListing(std::move(*fresh));
+        endResetModel();
+    }
+    if (quiet) {
+        if (!ok) qWarning(ocEnum) << "background revalidation failed:" << error;
+        return;
+    }
+    loading_ = false;
+    emit listingFinished(currentPath_, ok, error);
+    if (ok) schedulePrefetch();
+}
+
+bool RemoteModel::matchesListing(const openscp::DirListing& fresh) const {
+    // Compare as name-sorted sets: the view order follows the active sort
+    using Key = std::tuple<std::string_view, bool, quint64, quint64, quint32, quint32, quint32>;
+    auto key = [](const openscp::DirListing& l, std::size_t i) {
+        return Key{ l.name(i), l.isDir(i), l.fileSize(i), l.mtime(i), l.mode(i), l.uid(i), l.gid(i) };
+    };
+    std::vector<Key> live, now;
+    live.reserve(listing_.size());
+    for (std::size_t i = 0; i < listing_.size(); ++i)
+        if (!isDead((quint32)i)) live.push_back(key(listing_, i));
+    if (live.size() != fresh.size()) return false;
+    now.reserve(fresh.size());
+    for (std::size_t i = 0; i < fresh.size(); ++i) now.push_back(key(fresh, i));
+    std::sort(live.begin(), live.end());
+    std::sort(now.begin(), now.end());
+    return live == now;
+}
+
+void RemoteModel::indexNames() const {
+    if (byNameUpTo_ >= listing_.size()) return;
+    byName_.reserve(listing_.size());
+    for (std::size_t i = byNameUpTo_; i < listing_.size(); ++i)
+        if (!isDead((quint32)i)) byName_.emplace(std::hash<std::string_view>{}(listing_.name(i)), (quint32)i);
+    byNameUpTo_ = listing_.size();
+}
+
+long RemoteModel::findEntry(std::string_view name) const {
+    indexNames();
+    const auto [first, last] = byName_.equal_range(std::hash<std::string_view>{}(name));
+    for (auto it = first; it != last; ++it)
+        if (listing_.name(it->second) == name) return (long)it->second;
+    return -1;
+}
+
+long RemoteModel::findRow(quint32 e) const {
+    for (std::size_t r = 0; r < rows_.size(); ++r)
+        if (rows_[r] == e) return (long)r;
+    for (std::size_t i = pendingHead_; i < pendingRows_.size(); ++i)
+        if (pendingRows_[i] == e) return -2 - (long)i;
+    return -1;
+}
+
+void RemoteModel::markDead(quint32 e) {
+    if (dead_.size() <= e) dead_.resize(listing_.size(), 0);
+    dead_[e] = 1;
+    if (e >= byNameUpTo_) return; // not indexed yet; indexNames skips it
+    const auto [first, last] = byName_.equal_range(std::hash<std::string_view>{}(listing_.name(e)));
+    for (auto it = first; it != last; ++it) {
+        if (it->second == e) { byName_.erase(it); break; }
+    }
+}
+
+void RemoteModel::upsertEntry(const openscp::FileInfo& fi) {
+    if (fi.name.empty()) return;
+    const long old = findEntry(fi.name);
+    const long at = old >= 0 ? findRow((quint32)old) : -1;
+    const quint32 e = (quint32)listing_.size();
+    listing_.push(fi);
+    if (old >= 0) markDead((quint32)old);
+    if (!nameFilter_.empty()) buildNameKeys();
+    const bool shown = passesFilter(e);
+    if (at >= 0) {
+        // Replace in place when the row still sorts between its neighbours
+        ensureSortKeys();
+        const std::size_t r = (std::size_t)at;
+        const bool fits = shown && (sortColumn_ < 0 ||
+            ((r == 0 || !lessEntry(e, rows_[r - 1])) && (r + 1 == rows_.size() || !lessEntry(rows_[r + 1], e))));
+        if (fits) {
+            rows_[r] = e;
+            emit dataChanged(index((int)r, 0), index((int)r, columnCount() - 1));
+            return;
+        }
+        beginRemoveRows(QModelIndex(), (int)r, (int)r);
+        rows_.erase(rows_.begin() + (std::ptrdiff_t)r);
+        endRemoveRows();
+    } else if (at <= -2) {
+        pendingRows_.erase(pendingRows_.begin() + (std::ptrdiff_t)(-2 - at));
+    }
+    if (shown) addEntries({ e });
+}
+
+int RemoteModel::removeEntries(const QStringList& names) {
+    std::vector<char> gone(listing_.size(), 0);
+    bool any = false;
+    for (const QString& n : names) {
+        const QByteArray u = n.toUtf8();
+        const long e = findEntry(std::string_view(u.constData(), (std::size_t)u.size()));
+        if (e < 0) continue;
+        markDead((quint32)e);
+        gone[(std::size_t)e] = 1;
+        any = true;
+    }
+    if (!any) return 0;
+    // Pending rows are not in the view: compacted once, no signals
+    const auto kept = std::remove_if(pendingRows_.begin() + (std::ptrdiff_t)pendingHead_, pendingRows_.end(),
+                                     [&](quint32 e) { return gone[e] != 0; });
+    const std::size_t pending = (std::size_t)(pendingRows_.end() - kept);
+    pendingRows_.erase(kept, pendingRows_.end());
+    // Visible rows (ascending, one pass)
+    std::vector<std::size_t> visible;
+    for (std::size_t r = 0; r < rows_.size(); ++r)
+        if (gone[rows_[r]]) visible.push_back(r);
+    std::size_t runs = 0;
+    for (std::size_t i = 0; i < visible.size(); ++i)
+        if (i == 0 || visible[i - 1] + 1 != visible[i]) ++runs;
+    if (runs > kRemoveRunsMax) {
+        // Scattered rows: one compaction beats a signal and a tail move per run
+        beginResetModel();
+        rows_.erase(std::remove_if(rows_.begin(), rows_.end(), [&](quint32 e) { return gone[e] != 0; }), rows_.end());
+        endResetModel();
+        if (rows_.size() < kFetchPage && canFetchMore(QModelIndex())) fetchMore(QModelIndex());
+        return (int)(visible.size() + pending);
+    }
+    // Otherwise one beginRemoveRows per contiguous run, from the back
+    std::size_t end = visible.size();
+    while (end > 0) {
+        std::size_t begin = end - 1;
+        while (begin > 0 && visible[begin - 1] + 1 == visible[begin]) --begin;
+        const int first = (int)visible[begin], last = (int)visible[end - 1];
+        beginRemoveRows(QModelIndex(), first, last);
+        rows_.erase(rows_.begin() + first, rows_.begin() + last + 1);
+        endRemoveRows();
+        end = begin;
+    }
+    if (rows_.size() < kFetchPage && canFetchMore(QModelIndex())) fetchMore(QModelIndex());
+    return (int)(visible.size() + pending);
+}
+
+void RemoteModel::revalidate() {
+    if (!asyncOpt_.has_value() || loading_ || currentPath_.isEmpty()) return;
+    const quint64 gen = generation_.fetch_add(1) + 1;
+    {
+        std::lock_guard<std::mutex> lk(jobMtx_);
+        if (stopWorker_) return;
+        pendingJob_ = ListJob{ currentPath_, gen, true, true };
+        prefetchQueue_.clear();
+        if (!worker_.joinable()) worker_ = std::thread([this] { workerLoop(); });
+    }
+    jobCv_.notify_one();
+}
+
+openscp::CachingSftpClient* RemoteModel::listingCache() const {
+    return dynamic_cast<openscp::CachingSftpClient*>(client_);
+}
+
+void RemoteModel::noteVisited(const QString& path) {
+    recentDirs_.removeAll(path);
+    recentDirs_.prepend(path);
+    while (recentDirs_.size() > kRecentDirs) recentDirs_.removeLast();
+}
+
+void RemoteModel::schedulePrefetch() {
+    auto* cache = listingCache();
+    if (!cache || !asyncOpt_.has_value()) return;
+    // Memory budget: leave the other half of the cache to directories actually visited
+    if (cache->cachedBytes() >= cache->options().maxBytes / 2) return;
+    const QString base = currentPath_.endsWith('/') ? currentPath_ : currentPath_ + '/';
+    std::vector<std::string> dirs;
+    auto consider = [&](const QString& p) {
+        if (dirs.size() >= kPrefetchDirs) return;
+        const std::string sp = p.toStdString();
+        if (std::find(dirs.begin(), dirs.end(), sp) != dirs.end() || cache->hasListing(sp)) return;
+        dirs.push_back(sp);
+    };
+    // Children visited recently first, then the first folders in view order
+    for (const QString& r : recentDirs_) {
+        if (r.startsWith(base) && r.size() > base.size() && !r.mid(base.size()).contains('/')) consider(r);
+    }
+    for (std::size_t i = 0; i < rows_.size() && dirs.size() < kPrefetchDirs; ++i) {
+        const quint32 e = rows_[i];
+        if (listing_.isDir(e) && !listing_.isSymlink(e)) consider(base + nameOf(e));
+    }
+    if (dirs.empty()) return;
+    {
+        std::lock_guard<std::mutex> lk(jobMtx_);
+        if (stopWorker_) return;
+        prefetchQueue_.assign(dirs.begin(), dirs.end());
+        prefetchGen_ = generation_.load();
+        if (!worker_.joinable()) worker_ = std::thread([this] { workerLoop(); });
+    }
+    jobCv_.notify_one();
+}
+
+void RemoteModel::prefetchOne(const std::string& path, quint64 gen) {
+    if (gen != generation_.load()) return; // user moved on; the queue is rebuilt
+    auto* cache = listingCache();
+    if (!cache || cache->cachedBytes() >= cache->options().maxBytes / 2) return;
+    std::string err;
+    if (!ensureListSession(err)) return;
+    // Listing through the (caching) side session stores the result in the shared cache
+    openscp::DirListing tmp;
+    if (!listSession_->listCompact(path, tmp, err) && (!listSession_->isConnected() || listSession_->transportLost()))
+        listSession_.reset();
+}
+
+void RemoteModel::appendChunk(quint64 gen, const openscp::DirListing& chunk) {
+    if (gen != generation_.load()) return;
+    // Everything is kept; filters only decide which entries become rows
+    const quint32 base = (quint32)listing_.size();
+    for (std::size_t i = 0; i < chunk.size(); ++i)
+        listing_.push(chunk.name(i), chunk.isDir(i), chunk.hasSize(i), chunk.fileSize(i),
+                      chunk.mtime(i), chunk.mode(i), chunk.uid(i), chunk.gid(i));
+    if (!nameFilter_.empty()) buildNameKeys();
+    std::vector<quint32> added;
+    added.reserve(chunk.size());
+    for (quint32 e = base; e < (quint32)listing_.size(); ++e)
+        if (passesFilter(e)) added.push_back(e);
+    if (!added.empty()) addEntries(std::move(added));
+}
+
+void RemoteModel::finishAsync(quint64 gen, bool ok, const QString& error) {
+    if (gen != generation_.load()) return;
+    loading_ = false;
+    emit listingFinished(currentPath_, ok, error);
+    if (ok) schedulePrefetch();
+}
+
+// Stable sort split across threads: chunks are sorted concurrently, then adjacent
+// runs are merged pairwise (also concurrently) until one run is left.
+template <typename T, typename Less>
+static void parallelStableSort(std::vector<T>& v, Less less) {
+    static constexpr std::size_t kMinPerThread = 16384;
+    const std::size_t n = v.size();
+    const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t parts = std::min(hw, n / kMinPerThread);
+    if (parts < 2) {
+        std::stable_sort(v.begin(), v.end(), less);
+        return;
+    }
+    std::vector<std::size_t> bounds(parts + 1);
+    for (std::size_t i = 0; i <= parts; ++i) bounds[i] = n * i / parts;
+    {
+        std::vector<std::thread> th;
+        for (std::size_t i = 0; i < parts; ++i)
+            th.emplace_back([&v, &less, lo = bounds[i], hi = bounds[i + 1]] {
+                std::stable_sort(v.begin() + lo, v.begin() + hi, less);
+            });
+        for (auto& t : th) t.join();
+    }
+    while (bounds.size() > 2) {
+        std::vector<std::size_t> next{ 0 };
+        std::vector<std::thread> th;
+        std::size_t i = 0;
+        for (; i + 2 < bounds.size(); i += 2) {
+            th.emplace_back([&v, &less, lo = bounds[i], mid = bounds[i + 1], hi = bounds[i + 2]] {
+                std::inplace_merge(v.begin() + lo, v.begin() + mid, v.begin() + hi, less);
+            });
+            next.push_back(bounds[i + 2]);
+        }
+        if (i + 1 < bounds.size()) next.push_back(bounds[i + 1]); // odd run carried over
+        for (auto& t : th) t.join();
+        bounds.swap(next);
+    }
+}
+
+void RemoteModel::buildNameKeys() {
+    nameKeys_.off.reserve(listing_.size());
+    nameKeys_.len.reserve(listing_.size());
+    for (std::size_t i = nameKeys_.off.size(); i < listing_.size(); ++i) {
+        const std::string_view n = listing_.name(i);
+        nameKeys_.off.push_back(nameKeys_.arena.size());
+        const bool ascii = std::all_of(n.begin(), n.end(), [](char c) { return (unsigned char)c < 0x80; });
+        if (ascii) {
+            for (char c : n) nameKeys_.arena.push_back((c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c);
+            nameKeys_.len.push_back((quint32)n.size());
+        } else {
+            const QByteArray folded = QString::fromUtf8(n.data(), (qsizetype)n.size()).toCaseFolded().toUtf8();
+            nameKeys_.arena.append(folded.constData(), (std::size_t)folded.size());
+            nameKeys_.len.push_back((quint32)folded.size());
+        }
+    }
+}
+
+bool RemoteModel::lessEntry(quint32 a, quint32 b) const {
+    // Directories first, then criterion
+    const bool da = listing_.isDir(a), db = listing_.isDir(b);
+    if (da != db) return da && !db;
+    const bool asc = (sortOrder_ == Qt::AscendingOrder);
+    switch (sortColumn_) {
+        case 1: return asc ? (listing_.fileSize(a) < listing_.fileSize(b)) : (listing_.fileSize(a) > listing_.fileSize(b));
+        case 2: return asc ? (listing_.mtime(a) < listing_.mtime(b)) : (listing_.mtime(a) > listing_.mtime(b));
+        case 3: return asc ? (listing_.mode(a) < listing_.mode(b)) : (listing_.mode(a) > listing_.mode(b));
+    }
+    const int cmp = nameKeys_.at(a).compare(nameKeys_.at(b));
+    return asc ? (cmp < 0) : (cmp > 0);
+}
+
+void RemoteModel::resetRows(std::vector<quint32> entries, bool alreadySorted) {
+    if (sortColumn_ >= 0 && !alreadySorted) {
+        ensureSortKeys();
+        parallelStableSort(entries, [this](quint32 a, quint32 b) { return lessEntry(a, b); });
+    }
+    const std::size_t first = std::min(kFetchPage, entries.size());
+    rows_.assign(entries.begin(), entries.begin() + first);
+    entries.erase(entries.begin(), entries.begin() + first);
+    pendingRows_ = std::move(entries);
+    pendingHead_ = 0;
+}
+
+void RemoteModel::addEntries(std::vector<quint32> entries) {
+    if (sortColumn_ < 0) {
+        pendingRows_.insert(pendingRows_.end(), entries.begin(), entries.end());
+    } else {
+        ensureSortKeys();
+        std::stable_sort(entries.begin(), entries.end(), [this](quint32 a, quint32 b) { return lessEntry(a, b); });
+        // Entries that sort before the last visible row join the visible rows in place;
+        // the rest merge into the (sorted) pending run
+        auto split = entries.begin();
+        if (!rows_.empty()) {
+            const quint32 last = rows_.back();
+            split = std::partition_point(entries.begin(), entries.end(), [&](quint32 e) { return lessEntry(e, last); });
+        }
+        insertSortedRuns(std::vector<quint32>(entries.begin(), split));
+        std::vector<quint32> merged;
+        merged.reserve(pendingRows_.size() - pendingHead_ + (std::size_t)(entries.end() - split));
+        std::merge(pendingRows_.begin() + pendingHead_, pendingRows_.end(), split, entries.end(),
+                   std::back_inserter(merged), [this](quint32 a, quint32 b) { return lessEntry(a, b); });
+        pendingRows_ = std::move(merged);
+        pendingHead_ = 0;
+    }
+    // Keep the first screenful filled while the listing streams in
+    if (rows_.size() < kFetchPage) fetchMore(QModelIndex());
+}
+
+void RemoteModel::insertSortedRuns(const std::vector<quint32>& sorted) {
+    if (sorted.empty()) return;
+    // Insertion positions for each new entry (non-decreasing), then insert runs from the
+    // back so earlier positions stay valid
+    std::vector<std::size_t> pos(sorted.size());
+    auto from = rows_.begin();
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        from = std::upper_bound(from, rows_.end(), sorted[i], [this](quint32 a, quint32 b) { return lessEntry(a, b); });
+        pos[i] = (std::size_t)(from - rows_.begin());
+    }
+    std::size_t end = sorted.size();
+    while (end > 0) {
+        std::size_t begin = end - 1;
+        while (begin > 0 && pos[begin - 1] == pos[end - 1]) --begin;
+        const std::size_t at = pos[end - 1];
+        beginInsertRows(QModelIndex(), (int)at, (int)(at + (end - begin) - 1));
+        rows_.insert(rows_.begin() + at, sorted.begin() + begin, sorted.begin() + end);
+        endInsertRows();
+        end = begin;
+    }
+}
+
+bool RemoteModel::canFetchMore(const QModelIndex& parent) const {
+    if (parent.isValid()) return false;
+    return pendingHead_ < pendingRows_.size();
+}
+
+void RemoteModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid() || pendingHead_ >= pendingRows_.size()) return;
+    const std::size_t n = std::min(kFetchPage, pendingRows_.size() - pendingHead_);
+    const int first = (int)rows_.size();
+    beginInsertRows(QModelIndex(), first, first + (int)n - 1);
+    rows_.insert(rows_.end(), pendingRows_.begin() + pendingHead_, pendingRows_.begin() + pendingHead_ + n);
+    pendingHead_ += n;
+    endInsertRows();
+    if (pendingHead_ == pendingRows_.size()) {
+        pendingRows_.clear();
+        pendingHead_ = 0;
+    }
+}
+
 int RemoteModel::rowCount(const QModelIndex& parent) const {
     if (parent.isValid()) return 0;
-    return static_cast<int>(items_.size());
+    return static_cast<int>(rows_.size());
+}
+
+QString RemoteModel::nameOf(std::size_t entry) const {
+    const std::string_view n = listing_.name(entry);
+    return QString::fromUtf8(n.data(), (qsizetype)n.size());
+}
+
+void RemoteModel::invalidateDisplayCache() {
+    locale_ = QLocale();
+    displayCache_.clear();
+    if (!rows_.empty())
+        emit dataChanged(index(0, 1), index((int)rows_.size() - 1, 2), { Qt::DisplayRole, Qt::ToolTipRole });
+}
+
+const RemoteModel::DisplayText& RemoteModel::displayText(quint32 entry) const {
+    auto it = displayCache_.find(entry);
+    if (it != displayCache_.end()) return *it;
+    if (displayCache_.size() >= kDisplayCacheMax) displayCache_.clear();
+    DisplayText t;
+    if (!listing_.isDir(entry) && listing_.hasSize(entry))
+        t.size = locale_.formattedDataSize((qint64)listing_.fileSize(entry), 1, QLocale::DataSizeIecFormat);
+    if (const quint64 mtime = listing_.mtime(entry); mtime > 0)
+        t.time = openscpui::localShortTime(mtime);
+    return *displayCache_.insert(entry, std::move(t));
 }
 
 QVariant RemoteModel::data(const QModelIndex& index, int role) const {
-    if (!index.isValid() || index.row() < 0 || index.row() >= (int)items_.size())
+    if (!index.isValid() || index.row() < 0 || index.row() >= (int)rows_.size())
         return {};
-    const auto& it = items_[index.row()];
+    const quint32 e = rows_[index.row()];
+    const bool isDir = listing_.isDir(e);
+    const bool hasSize = listing_.hasSize(e);
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
             case 0: {
-                bool isLnk = (it.mode & 0120000u) == 0120000u; // S_IFLNK
+                bool isLnk = listing_.isSymlink(e);
                 QString suffix;
-                if (isLnk) suffix = "@"; else if (it.isDir) suffix = "/";
-                return it.name + suffix;
+                if (isLnk) suffix = "@"; else if (isDir) suffix = "/";
+                return nameOf(e) + suffix;
             }
             case 1:
-                if (it.isDir) return QVariant();
-                if (!it.hasSize) return QStringLiteral("—");
-                return QLocale().formattedDataSize((qint64)it.size, 1, QLocale::DataSizeIecFormat);
-            case 2:
-                if (it.mtime > 0)
-                    return openscpui::localShortTime(it.mtime);
-                else
-                    return QVariant();
-            case 3: {
-                // Permissions in rwxr-xr-x style
-                QString s(10, '-');
-                const quint32 m = it.mode;
-                // file type
-                bool isLnk = (m & 0120000u) == 0120000u;
-                s[0] = isLnk ? 'l' : (it.isDir ? 'd' : '-');
-                auto bit = [&](int pos, quint32 mask, QChar ch) { if (m & mask) s[pos] = ch; };
-                bit(1, 0400, 'r'); bit(2, 0200, 'w'); bit(3, 0100, 'x');
-                bit(4, 0040, 'r'); bit(5, 0020, 'w'); bit(6, 0010, 'x');
-                bit(7, 0004, 'r'); bit(8, 0002, 'w'); bit(9, 0001, 'x');
-                return s;
+                if (isDir) return QVariant();
+                if (!hasSize) return QStringLiteral("—");
+                return displayText(e).size;
+            case 2: {
+                const QString& t = displayText(e).time;
+                return t.isEmpty() ? QVariant() : QVariant(t);
             }
+            case 3:
+                // Permissions in rwxr-xr-x style
+                return permissionText(listing_.mode(e), isDir);
         }
     }
     if (role == Qt::ToolTipRole) {
-        const auto& it = items_[index.row()];
-        if (it.isDir) return tr("Carpeta");
-        if (!it.hasSize) {
+        if (isDir) return tr("Carpeta");
+        if (!hasSize) {
             return tr("Tamaño: desconocido (no informado por el servidor)");
         }
+        const DisplayText& d = displayText(e);
         QString tip = tr("Archivo");
-        const QString human = QLocale().formattedDataSize((qint64)it.size, 1, QLocale::DataSizeIecFormat);
-        const QString bytes = QLocale().toString((qulonglong)it.size);
-        tip += QString(" • %1 (%2 bytes)").arg(human, bytes);
-        if (it.mtime > 0) tip += " • " + openscpui::localShortTime(it.mtime);
+        const QString bytes = locale_.toString((qulonglong)listing_.fileSize(e));
+        tip += QString(" • %1 (%2 bytes)").arg(d.size, bytes);
+        if (!d.time.isEmpty()) tip += " • " + d.time;
         return tip;
     }
     return {};
@@ -86,44 +664,108 @@ bool RemoteModel::setRootPath(const QString& path, QString* errorOut) {
         if (errorOut) *errorOut = "Sin cliente SFTP";
         return false;
     }
-    std::vector<openscp::FileInfo> out;
+    generation_.fetch_add(1); // supersedes any async request in flight
+    loading_ = false;
+    openscp::DirListing listing;
     std::string err;
-    if (!client_->list(path.toStdString(), out, err)) {
+    if (!client_->listCompact(path.toStdString(), listing, err)) {
         if (errorOut) *errorOut = QString::fromStdString(err);
         return false;
     }
 
     beginResetModel();
-    items_.clear();
-    items_.reserve(out.size());
-    for (const auto& f : out) {
-        const QString name = QString::fromStdString(f.name);
-        if (!showHidden_ && name.startsWith('.')) continue;
-        items_.push_back({ name, f.is_dir, f.size, f.has_size, f.mtime, f.mode, f.uid, f.gid });
-    }
+    adoptListing(std::move(listing));
     currentPath_ = path;
     endResetModel();
+    noteVisited(path);
+    schedulePrefetch();
     return true;
 }
 
+void RemoteModel::adoptListing(openscp::DirListing listing) {
+    listing_ = std::move(listing);
+    nameKeys_.clear();
+    dead_.clear();
+    byName_.clear();
+    byNameUpTo_ = 0;
+    displayCache_.clear();
+    if (!nameFilter_.empty()) buildNameKeys();
+    std::vector<quint32> entries;
+    entries.reserve(listing_.size());
+    for (std::size_t i = 0; i < listing_.size(); ++i)
+        if (passesFilter((quint32)i)) entries.push_back((quint32)i);
+    resetRows(std::move(entries));
+}
+
+bool RemoteModel::passesFilter(quint32 e) const {
+    if (isDead(e)) return false;
+    if (!showHidden_ && listing_.name(e).substr(0, 1) == ".") return false;
+    if (typeFilter_ == TypeFilter::Files && listing_.isDir(e)) return false;
+    if (typeFilter_ == TypeFilter::Dirs && !listing_.isDir(e)) return false;
+    return nameFilter_.empty() || nameFilter_.matches(nameKeys_.at(e));
+}
+
+void RemoteModel::refilter(bool narrowing) {
+    if (!nameFilter_.empty()) buildNameKeys();
+    beginResetModel();
+    std::vector<quint32> entries;
+    if (narrowing) {
+        entries.reserve(rows_.size() + pendingRows_.size() - pendingHead_);
+        for (quint32 e : rows_)
+            if (passesFilter(e)) entries.push_back(e);
+        for (std::size_t i = pendingHead_; i < pendingRows_.size(); ++i)
+            if (passesFilter(pendingRows_[i])) entries.push_back(pendingRows_[i]);
+        resetRows(std::move(entries), true);
+    } else {
+        entries.reserve(listing_.size());
+        for (std::size_t i = 0; i < listing_.size(); ++i)
+            if (passesFilter((quint32)i)) entries.push_back((quint32)i);
+        resetRows(std::move(entries));
+    }
+    endResetModel();
+}
+
+void RemoteModel::setShowHidden(bool v) {
+    if (v == showHidden_) return;
+    showHidden_ = v;
+    refilter(!v); // hiding only removes rows
+}
+
+void RemoteModel::setTypeFilter(TypeFilter t) {
+    if (t == typeFilter_) return;
+    const bool narrowing = (typeFilter_ == TypeFilter::All);
+    typeFilter_ = t;
+    refilter(narrowing);
+}
+
+void RemoteModel::setNameFilter(const QString& text) {
+    if (text == nameFilterText_) return;
+    // Fold like the name keys so matching is case-insensitive (also beyond ASCII)
+    const openscp::NameFilter f(text.toCaseFolded().toStdString());
+    const bool narrowing = f.narrows(nameFilter_);
+    nameFilter_ = f;
+    nameFilterText_ = text;
+    refilter(narrowing);
+}
+
 bool RemoteModel::isDir(const QModelIndex& idx) const {
     if (!idx.isValid()) return false;
-    return items_[idx.row()].isDir;
+    return listing_.isDir(rows_[idx.row()]);
 }
 
 QString RemoteModel::nameAt(const QModelIndex& idx) const {
     if (!idx.isValid()) return {};
-    return items_[idx.row()].name;
+    return nameOf(rows_[idx.row()]);
 }
 
 bool RemoteModel::hasSize(const QModelIndex& idx) const {
     if (!idx.isValid()) return false;
-    return items_[idx.row()].hasSize;
+    return listing_.hasSize(rows_[idx.row()]);
 }
 
 quint64 RemoteModel::sizeAt(const QModelIndex& idx) const {
     if (!idx.isValid()) return 0;
-    return items_[idx.row()].size;
+    return listing_.fileSize(rows_[idx.row()]);
 }
 
 QVariant RemoteModel::headerData(int section, Qt::Orientation orientation, int role) const {
@@ -184,7 +826,7 @@ static QString sanitizeRelative(const QString& rel) {
 }
 
 bool RemoteModel::enumerateFilesUnderEx(const QString& baseRemote,
-                                        std::vector<EnumeratedFile>& out,
+                                        EnumeratedFiles& out,
                                         const EnumOptions& opt,
                                         bool* partialErrorOut,
                                         bool* someSizeUnknownOut,
@@ -196,12 +838,7 @@ bool RemoteModel::enumerateFilesUnderEx(const QString& baseRemote,
     if (someSizeUnknownOut) *someSizeUnknownOut = false;
     if (!client_) { return false; }
 
-    auto joinRemote = [](const QString& base, const QString& name) {
-        if (base == "/") return QStringLiteral("/") + name;
-        return base.endsWith('/') ? base + name : base + "/" + name;
-    };
     const QString base = normalizeRemotePath(baseRemote);
-    QSet<QString> visited;
     // Resolve max depth from settings if not provided or invalid
     int configuredMaxDepth = opt.maxDepth;
     if (configuredMaxDepth <= 0) {
@@ -209,53 +846,109 @@ bool RemoteModel::enumerateFilesUnderEx(const QString& baseRemote,
         configuredMaxDepth = s.value("Advanced/maxFolderDepth", 32).toInt();
         if (configuredMaxDepth < 1) configuredMaxDepth = 32;
     }
+    // Same server, extra sessions: only when async listing says how to open them
+    if (!enumPool_ && asyncOpt_.has_value())
+        enumPool_ = std::make_unique<openscp::SessionPool>(*client_, *asyncOpt_, kEnumSessions);
 
-    std::function<void(const QString&, const QString&, int)> walk;
-    walk = [&](const QString& cur, const QString& rel, int depth) {
-        if (opt.cancel && opt.cancel->load(std::memory_order_relaxed)) return;
-        if (depth > configuredMaxDepth) { qWarning(ocEnum) << "max depth reached at" << cur; return; }
-        const QString normCur = normalizeRemotePath(cur);
-        if (visited.contains(normCur)) return; // prevent cycles
-        visited.insert(normCur);
-        if (dirCountOut) (*dirCountOut)++;
-
-        std::vector<openscp::FileInfo> children;
-        std::string err;
-        if (!client_->list(normCur.toStdString(), children, err)) {
-            qWarning(ocEnum) << "enumeration error at" << normCur << ":" << QString::fromStdString(err);
-            if (partialErrorOut) *partialErrorOut = true;
-            if (deniedCountOut) (*deniedCountOut)++;
-            return;
+    openscp::TreeEnumOptions topt;
+    topt.maxDepth = configuredMaxDepth;
+    topt.skipSymlinks = opt.skipSymlinks;
+    topt.cancel = opt.cancel;
+    topt.pool = enumPool_.get();
+    topt.rules = opt.rules;
+    topt.cursor = opt.cursor;
+    openscp::TreeEnumStats stats;
+    std::string err;
+    if (!out.paths) out.paths = std::make_shared<openscp::PathStore>();
+    const std::string baseStd = base.toStdString();
+    out.base = out.paths->dir(baseStd);
+    // Runs one entry at a time (enumerateTree serializes the callback)
+    auto onEntry = [&](const openscp::TreeEntry& e) {
+        const QString name = QString::fromStdString(e.info.name);
+        if (!opt.includeHidden && !showHidden_ && name.startsWith('.')) return false;
+        if (opt.accept && !opt.accept(name, e.info.is_dir)) return false;
+        const QString childRel = sanitizeRelative(QString::fromStdString(e.rel));
+        if (childRel.isEmpty()) return false;
+        if (e.info.is_dir) {
+            if (opt.dirsOut) opt.dirsOut->push_back(childRel);
+            return true;
         }
-        for (const auto& e : children) {
-            if (opt.cancel && opt.cancel->load(std::memory_order_relaxed)) return;
-            const QString name = QString::fromStdString(e.name);
-            if (!showHidden_ && name.startsWith('.')) continue;
-            bool isSymlink = (e.mode & 0120000u) == 0120000u;
-            if (isSymlink && opt.skipSymlinks) { if (symlinkSkippedOut) (*symlinkSkippedOut)++; continue; }
-            const QString childRemote = joinRemote(normCur, name);
-            const QString childRel0 = rel.isEmpty() ? name : (rel + "/" + name);
-            const QString childRel = sanitizeRelative(childRel0);
-            if (childRel.isEmpty()) continue;
-            if (e.is_dir) {
-                walk(childRemote, childRel, depth + 1);
-                if (opt.cancel && opt.cancel->load(std::memory_order_relaxed)) return;
-            } else {
-                quint64 sz = (quint64)e.size;
-                const bool hsz = e.has_size;
-                if (!hsz) {
-                    if (someSizeUnknownOut) *someSizeUnknownOut = true;
-                    if (unknownSizeCountOut) (*unknownSizeCountOut)++;
-                }
-                out.push_back(EnumeratedFile{ childRemote, childRel, sz, hsz });
-            }
+        if (!e.info.has_size) {
+            if (someSizeUnknownOut) *someSizeUnknownOut = true;
+            if (unknownSizeCountOut) (*unknownSizeCountOut)++;
         }
+        out.add(EnumeratedFile{ out.paths->file(e.rel, out.base), (quint64)e.info.size, e.info.has_size,
+                                childRel.toStdString() != e.rel });
+        return true;
     };
-    walk(base, QString(), 0);
+    // client_ is shared with the view and the transfer queue: the walk never reconnects
+    // it. An interrupted walk resumes on a pooled session of its own.
+    openscp::SftpClient* walker = client_;
+    std::unique_ptr<openscp::SftpClient> own;
+    if (opt.cursor && !opt.cursor->empty() && enumPool_) {
+        own = enumPool_->acquire(err);
+        if (own) {
+            walker = own.get();
+            topt.ownsClient = true;
+        }
+    }
+    if (!openscp::enumerateTree(*walker, baseStd, topt, onEntry, stats, err)) {
+        // Cut short (cancel or a dead session): whatever was not listed is missing
+        qWarning(ocEnum) << "enumeration of" << base << "interrupted:" << QString::fromStdString(err);
+        if (partialErrorOut) *partialErrorOut = true;
+    }
+    if (own) enumPool_->release(std::move(own));
+    if (stats.reconnects) qInfo(ocEnum) << "enumeration of" << base << "reconnected" << stats.reconnects << "times";
+    if (stats.listFailures) {
+        qWarning(ocEnum) << "enumeration of" << base << ":" << stats.listFailures << "folders could not be listed";
+        if (partialErrorOut) *partialErrorOut = true;
+    }
+    if (stats.depthLimited) qWarning(ocEnum) << "max depth reached under" << base;
+    if (dirCountOut) *dirCountOut += stats.dirs;
+    if (symlinkSkippedOut) *symlinkSkippedOut += stats.symlinksSkipped;
+    if (deniedCountOut) *deniedCountOut += stats.listFailures;
     return true;
 }
 
-bool RemoteModel::enumerateFilesUnder(const QString& baseRemote, std::vector<EnumeratedFile>& out, QString* errorOut) const {
+// Spilled entries are stored as their raw bytes
+static_assert(std::is_trivially_copyable_v<RemoteModel::EnumeratedFile>);
+
+void RemoteModel::EnumeratedFiles::add(const EnumeratedFile& f) {
+    if (spillAfter > 0 && (files.size() >= spillAfter || (spill && !spill->empty()))) {
+        if (!spill) spill = std::make_unique<openscp::SpillQueue>(QFile::encodeName(spillDir).toStdString());
+        std::string err;
+        if (spill->push(std::string_view(reinterpret_cast<const char*>(&f), sizeof(f)), err)) return;
+        qWarning(ocEnum) << "enumeration spill failed, keeping results in memory:" << QString::fromStdString(err);
+    }
+    files.push_back(f);
+}
+
+void RemoteModel::EnumeratedFiles::drain(const std::function<void(const EnumeratedFile&)>& fn) {
+    for (const auto& f : files) fn(f);
+    files.clear();
+    files.shrink_to_fit();
+    if (!spill) return;
+    std::string rec;
+    EnumeratedFile f;
+    while (spill->pop(rec)) {
+        if (rec.size() != sizeof(f)) continue;
+        std::memcpy(&f, rec.data(), sizeof(f));
+        fn(f);
+    }
+    spill.reset();
+}
+
+QString RemoteModel::EnumeratedFiles::relativePath(const EnumeratedFile& f) const {
+    const QString rel = QString::fromStdString(paths->str(paths->rebase(f.path, base, openscp::PathStore::kTop)));
+    return f.renamed ? sanitizeRelative(rel) : rel;
+}
+
+openscp::PathRef RemoteModel::EnumeratedFiles::localPath(const EnumeratedFile& f, openscp::PathStore::Id localRoot) const {
+    if (f.renamed) return paths->file(relativePath(f).toStdString(), localRoot);
+    return paths->rebase(f.path, base, localRoot);
+}
+
+bool RemoteModel::enumerateFilesUnder(const QString& baseRemote, EnumeratedFiles& out, QString* errorOut) const {
     bool partial = false, unk = false;
     EnumOptions opt; // defaults
     bool ok = enumerateFilesUnderEx(baseRemote, out, opt, &partial, &unk);
@@ -265,24 +958,34 @@ bool RemoteModel::enumerateFilesUnder(const QString& baseRemote, std::vector<Enu
 }
 
 void RemoteModel::sort(int column, Qt::SortOrder order) {
-    if (items_.empty()) return;
-    beginResetModel();
-    const bool asc = (order == Qt::AscendingOrder);
-    auto lessStr = [&](const QString& a, const QString& b) {
-        int cmp = QString::compare(a, b, Qt::CaseInsensitive);
-        return asc ? (cmp < 0) : (cmp > 0);
-    };
-    auto less = [&](const Item& a, const Item& b) {
-        // Directories first, then criterion
-        if (a.isDir != b.isDir) return a.isDir && !b.isDir;
-        switch (column) {
-            case 0: return lessStr(a.name, b.name);
-            case 1: return asc ? (a.size < b.size) : (a.size > b.size);
-            case 2: return asc ? (a.mtime < b.mtime) : (a.mtime > b.mtime);
-            case 3: return asc ? (a.mode < b.mode) : (a.mode > b.mode);
-        }
-        return lessStr(a.name, b.name);
-    };
-    std::sort(items_.begin(), items_.end(), less);
-    endResetModel();
+    sortColumn_ = column;
+    sortOrder_ = order;
+    if (rows_.empty()) return;
+    ensureSortKeys();
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    // Remember which entry each persistent index (selection, current) points at
+    const QModelIndexList before = persistentIndexList();
+    std::vector<quint32> beforeEntries;
+    beforeEntries.reserve(before.size());
+    for (const QModelIndex& i : before) beforeEntries.push_back(rows_[i.row()]);
+
+    // Sort everything (exposed + pending); the same number of rows stays exposed
+    const std::size_t shown = rows_.size();
+    std::vector<quint32> all(rows_);
+    all.insert(all.end(), pendingRows_.begin() + pendingHead_, pendingRows_.end());
+    parallelStableSort(all, [this](quint32 a, quint32 b) { return lessEntry(a, b); });
+    rows_.assign(all.begin(), all.begin() + shown);
+    pendingRows_.assign(all.begin() + shown, all.end());
+    pendingHead_ = 0;
+
+    std::vector<int> rowOf(listing_.size(), -1);
+    for (std::size_t r = 0; r < rows_.size(); ++r) rowOf[rows_[r]] = (int)r;
+    QModelIndexList after;
+    after.reserve(before.size());
+    for (int k = 0; k < before.size(); ++k) {
+        const int r = rowOf[beforeEntries[(std::size_t)k]];
+        after.push_back(r >= 0 ? index(r, before[k].column()) : QModelIndex()); // now beyond the fetched rows
+    }
+    changePersistentIndexList(before, after);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
 }
@@ -1,16 +1,37 @@
 // Read-only model to list remote entries via SftpClient.
 #pragma once
 #include <QAbstractTableModel>
+#include <QHash>
+#include <QLocale>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 #include "openscp/SftpClient.hpp"
+#include "openscp/DirListing.hpp"
+#include "openscp/NameFilter.hpp"
+#include "openscp/TreeEnumerator.hpp"
+#include "openscp/PathStore.hpp"
+#include "openscp/SpillQueue.hpp"
+
+namespace openscp { class CachingSftpClient; }
 
 class RemoteModel : public QAbstractTableModel {
     Q_OBJECT
 public:
     explicit RemoteModel(openscp::SftpClient* client, QObject* parent = nullptr);
+    ~RemoteModel() override;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    // Paging: rows are exposed a page at a time as the view scrolls
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override { Q_UNUSED(parent); return 4; }
     QVariant data(const QModelIndex& index, int role) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
@@ -24,29 +45,93 @@ public:
     bool setRootPath(const QString& path, QString* errorOut = nullptr);
     QString rootPath() const { return currentPath_; }
 
+    // Asynchronous listing: a dedicated session (opened lazily with these options via
+    // newConnectionLike) lists on a worker thread; rows are inserted in batches as they
+    // arrive. A new request (or setRootPath) supersedes the one in flight.
+    // With a CachingSftpClient, a cached directory is shown at once and revalidated in the
+    // background, and the worker prefetches a few subdirectories while otherwise idle.
+    void enableAsyncListing(const openscp::SessionOptions& opt);
+    bool asyncListing() const { return asyncOpt_.has_value(); }
+    void requestRootPath(const QString& path);
+    // Stop the worker and close the side session (before the main client goes away)
+    void stopAsyncListing();
+    bool isLoading() const { return loading_; }
+    // Directory shown before the last request (to go back if it fails)
+    QString previousRootPath() const { return previousPath_; }
+
+    // Row-level updates after a successful remote mutation (no re-list). Entries are
+    // matched by name within the current directory; rows keep the active sort order.
+    // Insert or replace one entry (e.g. after mkdir, upload, chmod: pass a fresh stat)
+    void upsertEntry(const openscp::FileInfo& fi);
+    // Remove entries by name (after delete). Returns how many rows went away.
+    int removeEntries(const QStringList& names);
+    // Re-list the current directory in the background and apply the result only if it
+    // differs from what is shown (quiet: no listingFinished, errors are only logged)
+    void revalidate();
+
     bool isDir(const QModelIndex& idx) const;
     QString nameAt(const QModelIndex& idx) const;
     bool hasSize(const QModelIndex& idx) const;
     quint64 sizeAt(const QModelIndex& idx) const;
-    void setShowHidden(bool v) { showHidden_ = v; }
+    // View filters: applied over the full listing in memory (no re-list). Dot-files,
+    // a name filter (substring, or globs such as "*.log *.txt"; case-insensitive) and a type.
+    enum class TypeFilter { All, Files, Dirs };
+    void setShowHidden(bool v);
     bool showHidden() const { return showHidden_; }
+    void setNameFilter(const QString& text);
+    QString nameFilter() const { return nameFilterText_; }
+    void setTypeFilter(TypeFilter t);
+    TypeFilter typeFilter() const { return typeFilter_; }
+    // Drop cached size/date strings (locale or time zone changed)
+    void invalidateDisplayCache();
 
-    // Enumeration support for staging folders
+    // Enumeration support for staging folders. Paths are interned (shared folder
+    // prefixes stored once); pass the transfer queue's store to enqueue them as they are.
     struct EnumeratedFile {
-        QString remotePath;    // full remote path ("/base/sub/file")
-        QString relativePath;  // relative to the enumerated base ("sub/file")
+        openscp::PathRef path; // full remote path ("/base/sub/file")
         quint64 size = 0;      // bytes
         bool hasSize = false;  // true if size is known
+        bool renamed = false;  // the relative path needed sanitizing for local use
+    };
+    struct EnumeratedFiles {
+        std::shared_ptr<openscp::PathStore> paths; // created by the enumeration if null
+        openscp::PathStore::Id base = openscp::PathStore::kTop; // the enumerated folder
+        std::vector<EnumeratedFile> files;
+        // Out-of-core: past spillAfter files (0 = never) the rest wait in a spill file in
+        // spillDir; use drain() to visit them all
+        std::size_t spillAfter = 0;
+        QString spillDir;
+        std::unique_ptr<openscp::SpillQueue> spill;
+        void add(const EnumeratedFile& f);
+        std::size_t count() const { return files.size() + (spill ? (std::size_t)spill->size() : 0); }
+        // Visit every file in order; spilled ones are read back and released on the way
+        void drain(const std::function<void(const EnumeratedFile&)>& fn);
+        QString remotePath(const EnumeratedFile& f) const { return QString::fromStdString(paths->str(f.path)); }
+        // Relative to the enumerated base ("sub/file"), safe as a local path
+        QString relativePath(const EnumeratedFile& f) const;
+        // The same file below the interned local folder "localRoot"
+        openscp::PathRef localPath(const EnumeratedFile& f, openscp::PathStore::Id localRoot) const;
     };
     struct EnumOptions {
         bool skipSymlinks = true;             // skip symlinks by default
         std::atomic_bool* cancel = nullptr;   // cooperative cancel flag
         int maxDepth = 32;                    // maximum recursion depth
+        bool includeHidden = false;           // ignore the hidden-file setting of the view
+        // Optional veto per entry (false skips the file, or the whole folder)
+        std::function<bool(const QString& name, bool isDir)> accept;
+        // Optional: relative paths of the folders found (parents before children)
+        std::vector<QString>* dirsOut = nullptr;
+        // Optional exclusion rules (relative to baseRemote); excluded folders are not listed
+        const openscp::PathRules* rules = nullptr;
+        // Optional resume point: an interrupted walk leaves its frontier here and the
+        // next call with the same base continues from it (see TreeEnumOptions::cursor)
+        openscp::EnumCursor* cursor = nullptr;
     };
-    // Recursively enumerate files under `baseRemote` (directories only).
+    // Recursively enumerate files under `baseRemote` (directories only). Folders are
+    // listed in parallel on pooled sessions when async listing is enabled.
     // Returns true if finished without fatal error. partialErrorOut is set to true if some branches failed.
     bool enumerateFilesUnderEx(const QString& baseRemote,
-                               std::vector<EnumeratedFile>& out,
+                               EnumeratedFiles& out,
                                const EnumOptions& opt,
                                bool* partialErrorOut,
                                bool* someSizeUnknownOut,
@@ -55,21 +140,105 @@ public:
                                quint64* deniedCountOut = nullptr,
                                quint64* unknownSizeCountOut = nullptr) const;
     // Backward-compatible simple enumeration (no cancel/skip control)
-    bool enumerateFilesUnder(const QString& baseRemote, std::vector<EnumeratedFile>& out, QString* errorOut = nullptr) const;
+    bool enumerateFilesUnder(const QString& baseRemote, EnumeratedFiles& out, QString* errorOut = nullptr) const;
+
+signals:
+    // Emitted when an asynchronous listing completes (ok=false: error holds the reason)
+    void listingFinished(const QString& path, bool ok, const QString& error);
 
 private:
     openscp::SftpClient* client_ = nullptr; // no owned
     QString currentPath_;
-    struct Item {
-        QString name;
-        bool isDir;
-        quint64 size;
-        bool hasSize;
-        quint64 mtime;
-        quint32 mode;
-        quint32 uid;
-        quint32 gid;
+    // Current directory in compact form; rows_ maps view rows to listing entries
+    // (hidden-file filter and sort order applied). Names become QStrings only when shown.
+    openscp::DirListing listing_;
+    std::vector<quint32> rows_;
+    // Entries not exposed yet (fetchMore), from pendingHead_ on; kept in sort order
+    std::vector<quint32> pendingRows_;
+    std::size_t pendingHead_ = 0;
+    QString nameOf(std::size_t entry) const;
+    int sortColumn_ = -1;
+    Qt::SortOrder sortOrder_ = Qt::AscendingOrder;
+    // Formatted size/date per listing entry, filled on first paint. Bounded: only
+    // rows actually shown are formatted, and the cache is dropped when it grows too much.
+    struct DisplayText { QString size; QString time; };
+    mutable QHash<quint32, DisplayText> displayCache_;
+    QLocale locale_;
+    const DisplayText& displayText(quint32 entry) const;
+    // Name sort keys (case-folded UTF-8), one per listing entry, in a single arena.
+    // Built once per listing and extended as entries stream in.
+    struct NameKeys {
+        std::string arena;
+        std::vector<quint64> off;
+        std::vector<quint32> len;
+        std::string_view at(std::size_t i) const { return std::string_view(arena.data() + off[i], len[i]); }
+        void clear() { arena.clear(); off.clear(); len.clear(); }
     };
-    std::vector<Item> items_;
-    bool showHidden_ = false; // hide names starting with '.' if false
+    NameKeys nameKeys_;
+    bool sortsByName() const { return sortColumn_ < 1 || sortColumn_ > 3; }
+    // Extend nameKeys_ to every listing entry (needed for name sorting and name filters)
+    void buildNameKeys();
+    void ensureSortKeys() { if (sortsByName()) buildNameKeys(); }
+    // Read-only comparator (safe to call from several threads once keys are built)
+    bool lessEntry(quint32 a, quint32 b) const;
+    // Replace all rows (inside a model reset) and expose the first page
+    void resetRows(std::vector<quint32> entries, bool alreadySorted = false);
+    // Add new listing entries: merged into sorted position when a sort is active
+    void addEntries(std::vector<quint32> entries);
+    void insertSortedRuns(const std::vector<quint32>& sorted);
+
+    // Async listing state. generation_ identifies the current request; stale results are dropped.
+    struct ListJob { QString path; quint64 gen; bool revalidate = false; bool quiet = false; };
+    std::optional<openscp::SessionOptions> asyncOpt_;
+    std::unique_ptr<openscp::SftpClient> listSession_; // used by the worker thread only
+    // Extra sessions for recursive enumeration (GUI thread; created on first use)
+    mutable std::unique_ptr<openscp::SessionPool> enumPool_;
+    std::thread worker_;
+    std::mutex jobMtx_;
+    std::condition_variable jobCv_;
+    std::optional<ListJob> pendingJob_;
+    bool stopWorker_ = false;
+    std::atomic<quint64> generation_{0};
+    bool loading_ = false;
+    QString previousPath_;
+    void workerLoop();
+    bool ensureListSession(std::string& err);
+    void runJob(const ListJob& job);
+    void finishRevalidate(quint64 gen, bool ok, bool quiet, std::shared_ptr<openscp::DirListing> fresh, const QString& error);
+    // Live entry named "name" (UTF-8), or -1
+    long findEntry(std::string_view name) const;
+    // Name hash -> live entry (names are compared on a hit), for row edits. Extended
+    // lazily to the entries appended since the last lookup; dead entries are dropped.
+    mutable std::unordered_multimap<std::size_t, quint32> byName_;
+    mutable std::size_t byNameUpTo_ = 0;
+    void indexNames() const;
+    // Row of entry e: >= 0 visible row, -2 - i pending slot i, -1 not shown (filtered out)
+    long findRow(quint32 e) const;
+    // Same live entries as "fresh" (order ignored)
+    bool matchesListing(const openscp::DirListing& fresh) const;
+    // Entries replaced or removed by row edits stay in listing_ until the next listing
+    std::vector<char> dead_;
+    bool isDead(quint32 e) const { return e < dead_.size() && dead_[e]; }
+    void markDead(quint32 e);
+    // Current view filters
+    openscp::NameFilter nameFilter_;
+    QString nameFilterText_;
+    TypeFilter typeFilter_ = TypeFilter::All;
+    bool passesFilter(quint32 e) const;
+    // Rebuild rows from the listing. narrowing: the new filter only removes rows, so the
+    // current (already sorted) rows are filtered again instead of re-sorting everything.
+    void refilter(bool narrowing);
+    // Speculative prefetch of child listings into the shared cache (worker thread, idle time)
+    std::deque<std::string> prefetchQueue_; // guarded by jobMtx_
+    quint64 prefetchGen_ = 0;               // generation the queue was built for
+    QStringList recentDirs_;                // navigation history, most recent first
+    openscp::CachingSftpClient* listingCache() const;
+    void noteVisited(const QString& path);
+    void schedulePrefetch();
+    void prefetchOne(const std::string& path, quint64 gen);
+    // Install a complete listing as the current rows (inside a model reset)
+    void adoptListing(openscp::DirListing listing);
+    void appendChunk(quint64 gen, const openscp::DirListing& chunk);
+    void finishAsync(quint64 gen, bool ok, const QString& error);
+    bool showHidden_ = false; // hide names starting with '.' if false (filtered, still listed)
 };
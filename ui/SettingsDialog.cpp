@@ -13,6 +13,7 @@
 #include <QFileDialog>
 #include <QLineEdit>
 #include <QSpinBox>
+#include <QPlainTextEdit>
 
 SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
     setWindowTitle(tr("Ajustes"));
@@ -200,6 +201,51 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
         adv->addLayout(row);
     }
 
+    // Memory budget of the transfer queue (Advanced/queueMemoryMB)
+    {
+        auto* row = new QHBoxLayout();
+        row->setContentsMargins(0,0,0,0);
+        auto* lbl = new QLabel(tr("Memoria máxima de la cola de transferencias (MB, 0 = sin límite)"), advPanel);
+        lbl->setToolTip(tr("Con colas enormes, las tareas que no caben esperan en un archivo temporal en disco."));
+        queueMemorySpin_ = new QSpinBox(advPanel);
+        queueMemorySpin_->setRange(0, 65536);
+        queueMemorySpin_->setSingleStep(128);
+        queueMemorySpin_->setValue(512);
+        queueMemorySpin_->setToolTip(lbl->toolTip());
+        row->addWidget(lbl);
+        row->addWidget(queueMemorySpin_);
+        row->addStretch();
+        adv->addLayout(row);
+    }
+
+    // Folder transfers as a single tar stream (Advanced/tarFolderTransfers)
+    tarFolders_ = new QCheckBox(tr("Transferir carpetas como flujo tar por exec (si el servidor lo permite)"), advPanel);
+    tarFolders_->setToolTip(tr("Mucho más rápido con miles de archivos pequeños. Requiere acceso exec y tar en el servidor."));
+    {
+        auto* row = new QHBoxLayout();
+        row->addWidget(tarFolders_);
+        row->addStretch();
+        adv->addLayout(row);
+    }
+
+    // Background check of the remote folder after create/rename/delete (Advanced/revalidateAfterEdits)
+    revalidateEdits_ = new QCheckBox(tr("Verificar en segundo plano la carpeta remota tras crear, renombrar o borrar"), advPanel);
+    revalidateEdits_->setToolTip(tr("Los cambios se muestran al instante; esta opción vuelve a listar la carpeta sin bloquear para detectar cambios de otros."));
+    {
+        auto* row = new QHBoxLayout();
+        row->addWidget(revalidateEdits_);
+        row->addStretch();
+        adv->addLayout(row);
+    }
+
+    // Folder transfer exclusions for every site (Transfer/excludeRules); sites can add their own
+    excludeRules_ = new QPlainTextEdit(advPanel);
+    excludeRules_->setPlaceholderText(QStringLiteral("node_modules/\n.git/\n*.o"));
+    excludeRules_->setToolTip(tr("Una regla por línea, sintaxis .gitignore ('!' vuelve a incluir, '/' final solo carpetas). Las carpetas excluidas no se recorren."));
+    excludeRules_->setFixedHeight(excludeRules_->fontMetrics().lineSpacing() * 5);
+    adv->addWidget(new QLabel(tr("Excluir al transferir carpetas:"), advPanel));
+    adv->addWidget(excludeRules_);
+
     const bool knownHashed = s.value("Security/knownHostsHashed", true).toBool();
     if (knownHostsHashed_) knownHostsHashed_->setChecked(knownHashed);
     const bool fpHex = s.value("Security/fpHex", false).toBool();
@@ -213,6 +259,10 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
     stagingRootEdit_->setText(s.value("Advanced/stagingRoot", QDir::homePath() + "/Downloads/OpenSCP-Dragged").toString());
     autoCleanStaging_->setChecked(s.value("Advanced/autoCleanStaging", true).toBool());
     if (maxDepthSpin_) maxDepthSpin_->setValue(s.value("Advanced/maxFolderDepth", 32).toInt());
+    if (queueMemorySpin_) queueMemorySpin_->setValue(s.value("Advanced/queueMemoryMB", 512).toInt());
+    if (tarFolders_) tarFolders_->setChecked(s.value("Advanced/tarFolderTransfers", false).toBool());
+    if (revalidateEdits_) revalidateEdits_->setChecked(s.value("Advanced/revalidateAfterEdits", true).toBool());
+    if (excludeRules_) excludeRules_->setPlainText(s.value("Transfer/excludeRules").toString());
 #if defined(Q_OS_MAC) || defined(Q_OS_MACOS) || defined(__APPLE__)
     const bool macRestrictiveLoad = s.value("Security/macKeychainRestrictive", false).toBool();
     if (macKeychainRestrictive_) macKeychainRestrictive_->setChecked(macRestrictiveLoad);
@@ -256,6 +306,10 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
     if (stagingRootEdit_) connect(stagingRootEdit_, &QLineEdit::textChanged, this, &SettingsDialog::updateApplyFromControls);
     if (autoCleanStaging_) connect(autoCleanStaging_, &QCheckBox::toggled, this, &SettingsDialog::updateApplyFromControls);
     if (maxDepthSpin_) connect(maxDepthSpin_, qOverload<int>(&QSpinBox::valueChanged), this, &SettingsDialog::updateApplyFromControls);
+    if (queueMemorySpin_) connect(queueMemorySpin_, qOverload<int>(&QSpinBox::valueChanged), this, &SettingsDialog::updateApplyFromControls);
+    if (tarFolders_) connect(tarFolders_, &QCheckBox::toggled, this, &SettingsDialog::updateApplyFromControls);
+    if (revalidateEdits_) connect(revalidateEdits_, &QCheckBox::toggled, this, &SettingsDialog::updateApplyFromControls);
+    if (excludeRules_) connect(excludeRules_, &QPlainTextEdit::textChanged, this, &SettingsDialog::updateApplyFromControls);
 #if defined(Q_OS_MAC) || defined(Q_OS_MACOS) || defined(__APPLE__)
     if (macKeychainRestrictive_) connect(macKeychainRestrictive_, &QCheckBox::toggled, this, &SettingsDialog::updateApplyFromControls);
 #endif
@@ -316,6 +370,10 @@ void SettingsDialog::onApply() {
     if (stagingRootEdit_) s.setValue("Advanced/stagingRoot", stagingRootEdit_->text());
     if (autoCleanStaging_) s.setValue("Advanced/autoCleanStaging", autoCleanStaging_->isChecked());
     if (maxDepthSpin_) s.setValue("Advanced/maxFolderDepth", maxDepthSpin_->value());
+    if (queueMemorySpin_) s.setValue("Advanced/queueMemoryMB", queueMemorySpin_->value());
+    if (tarFolders_) s.setValue("Advanced/tarFolderTransfers", tarFolders_->isChecked());
+    if (revalidateEdits_) s.setValue("Advanced/revalidateAfterEdits", revalidateEdits_->isChecked());
+    if (excludeRules_) s.setValue("Transfer/excludeRules", excludeRules_->toPlainText());
     s.sync();
 
     // Only notify if language actually changed
@@ -343,6 +401,10 @@ void SettingsDialog::updateApplyFromControls() {
     const QString stagingRoot = s.value("Advanced/stagingRoot", QDir::homePath() + "/Downloads/OpenSCP-Dragged").toString();
     const bool autoCleanSt = s.value("Advanced/autoCleanStaging", true).toBool();
     const int  maxDepthPrev = s.value("Advanced/maxFolderDepth", 32).toInt();
+    const int  queueMemPrev = s.value("Advanced/queueMemoryMB", 512).toInt();
+    const bool tarFoldersPrev = s.value("Advanced/tarFolderTransfers", false).toBool();
+    const bool revalidatePrev = s.value("Advanced/revalidateAfterEdits", true).toBool();
+    const QString excludesPrev = s.value("Transfer/excludeRules").toString();
 
     const QString curLang = langCombo_ ? langCombo_->currentData().toString() : prevLang;
     const bool curShowHidden = showHidden_ && showHidden_->isChecked();
@@ -360,6 +422,10 @@ void SettingsDialog::updateApplyFromControls() {
     const QString curStagingRoot = stagingRootEdit_ ? stagingRootEdit_->text() : stagingRoot;
     const bool curAutoCleanSt = autoCleanStaging_ && autoCleanStaging_->isChecked();
     const int  curMaxDepth   = maxDepthSpin_ ? maxDepthSpin_->value() : maxDepthPrev;
+    const int  curQueueMem   = queueMemorySpin_ ? queueMemorySpin_->value() : queueMemPrev;
+    const bool curTarFolders = tarFolders_ ? tarFolders_->isChecked() : tarFoldersPrev;
+    const bool curRevalidate = revalidateEdits_ ? revalidateEdits_->isChecked() : revalidatePrev;
+    const QString curExcludes = excludeRules_ ? excludeRules_->toPlainText() : excludesPrev;
 
     const bool modified = (curLang != prevLang) ||
                           (curShowHidden != showHidden) ||
@@ -375,6 +441,10 @@ void SettingsDialog::updateApplyFromControls() {
                           || (curStagingRoot != stagingRoot)
                           || (curAutoCleanSt != autoCleanSt)
                           || (curMaxDepth != maxDepthPrev)
+                          || (curQueueMem != queueMemPrev)
+                          || (curTarFolders != tarFoldersPrev)
+                          || (curRevalidate != revalidatePrev)
+                          || (curExcludes != excludesPrev)
                           ;
     if (applyBtn_) {
         applyBtn_->setEnabled(modified);
@@ -33,6 +33,10 @@ private:
     class QPushButton* stagingBrowseBtn_ = nullptr;
     QCheckBox* autoCleanStaging_ = nullptr; // Auto-clean staging after successful drag-out
     class QSpinBox* maxDepthSpin_ = nullptr; // Advanced/maxFolderDepth
+    class QSpinBox* queueMemorySpin_ = nullptr; // Advanced/queueMemoryMB: queue memory budget (spill to disk past it)
+    QCheckBox* tarFolders_ = nullptr; // Advanced/tarFolderTransfers: folders as tar stream over exec
+    QCheckBox* revalidateEdits_ = nullptr; // Advanced/revalidateAfterEdits: background re-list after remote edits
+    class QPlainTextEdit* excludeRules_ = nullptr; // Transfer/excludeRules: .gitignore-style rules for every site
     QPushButton* applyBtn_ = nullptr;   // Apply button (enabled only when modified)
     QPushButton* closeBtn_ = nullptr;   // Close button (never primary/default)
 };
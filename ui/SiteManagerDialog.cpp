@@ -45,6 +45,7 @@ SiteManagerDialog::SiteManagerDialog(QWidget* parent) : QDialog(parent) {
     auto* bb = new QDialogButtonBox(this);
     btAdd_  = bb->addButton(tr("Añadir"),   QDialogButtonBox::ActionRole);
     btEdit_ = bb->addButton(tr("Editar"),   QDialogButtonBox::ActionRole);
+    btExcl_ = bb->addButton(tr("Exclusiones…"), QDialogButtonBox::ActionRole);
     btDel_  = bb->addButton(tr("Eliminar"), QDialogButtonBox::ActionRole);
     btConn_ = bb->addButton(tr("Conectar"), QDialogButtonBox::AcceptRole);
     btClose_= bb->addButton(QDialogButtonBox::Close);
@@ -52,6 +53,7 @@ SiteManagerDialog::SiteManagerDialog(QWidget* parent) : QDialog(parent) {
     lay->addWidget(bb);
     connect(btAdd_,  &QPushButton::clicked, this, &SiteManagerDialog::onAdd);
     connect(btEdit_, &QPushButton::clicked, this, &SiteManagerDialog::onEdit);
+    connect(btExcl_, &QPushButton::clicked, this, &SiteManagerDialog::onEditExcludes);
     connect(btDel_,  &QPushButton::clicked, this, &SiteManagerDialog::onRemove);
     connect(btConn_, &QPushButton::clicked, this, &SiteManagerDialog::onConnect);
     connect(bb, &QDialogButtonBox::rejected, this, &QDialog::reject);
@@ -90,6 +92,9 @@ void SiteManagerDialog::loadSites() {
         const QString kh = s.value("knownHosts").toString();
         if (!kh.isEmpty()) e.opt.known_hosts_path = kh.toStdString();
         e.opt.known_hosts_policy = (openscp::KnownHostsPolicy)s.value("khPolicy", (int)openscp::KnownHostsPolicy::Strict).toInt();
+        e.opt.compression = (openscp::CompressionMode)s.value("compression", (int)openscp::CompressionMode::Off).toInt();
+        e.opt.transfer_engine = (openscp::TransferEngine)s.value("engine", (int)openscp::TransferEngine::Sftp).toInt();
+        e.excludes = s.value("excludes").toString();
         sites_.push_back(e);
     }
     s.endArray();
@@ -112,6 +117,9 @@ void SiteManagerDialog::saveSites() {
         s.setValue("keyPath", e.opt.private_key_path ? QString::fromStdString(*e.opt.private_key_path) : QString());
         s.setValue("knownHosts", e.opt.known_hosts_path ? QString::fromStdString(*e.opt.known_hosts_path) : QString());
         s.setValue("khPolicy", (int)e.opt.known_hosts_policy);
+        s.setValue("compression", (int)e.opt.compression);
+        s.setValue("engine", (int)e.opt.transfer_engine);
+        s.setValue("excludes", e.excludes);
     }
     s.endArray();
 }
@@ -317,6 +325,39 @@ bool SiteManagerDialog::selectedOptions(openscp::SessionOptions& out) const {
 void SiteManagerDialog::updateButtons() {
     bool hasSel = table_ && table_->selectionModel() && table_->selectionModel()->hasSelection();
     if (btEdit_) btEdit_->setEnabled(hasSel);
+    if (btExcl_) btExcl_->setEnabled(hasSel);
     if (btDel_)  btDel_->setEnabled(hasSel);
     if (btConn_) btConn_->setEnabled(hasSel);
 }
+
+void SiteManagerDialog::onEditExcludes() {
+    auto sel = table_->selectionModel();
+    if (!sel || !sel->hasSelection()) return;
+    int viewRow = sel->selectedRows().first().row();
+    int modelIndex = table_->item(viewRow, 0) ? table_->item(viewRow, 0)->data(Qt::UserRole).toInt() : viewRow;
+    if (modelIndex < 0 || modelIndex >= sites_.size()) return;
+    bool ok = false;
+    const QString rules = QInputDialog::getMultiLineText(this, tr("Exclusiones de «%1»").arg(sites_[modelIndex].name),
+                                                         tr("Reglas estilo .gitignore, una por línea (se suman a las de Ajustes):"),
+                                                         sites_[modelIndex].excludes, &ok);
+    if (!ok) return;
+    sites_[modelIndex].excludes = rules;
+    saveSites();
+}
+
+QString SiteManagerDialog::excludeRulesFor(const openscp::SessionOptions& opt) {
+    QSettings s("OpenSCP", "OpenSCP");
+    QString rules;
+    const int n = s.beginReadArray("sites");
+    for (int i = 0; i < n; ++i) {
+        s.setArrayIndex(i);
+        if (s.value("host").toString().toStdString() == opt.host &&
+            (std::uint16_t)s.value("port", 22).toUInt() == opt.port &&
+            s.value("user").toString().toStdString() == opt.username) {
+            rules = s.value("excludes").toString();
+            break;
+        }
+    }
+    s.endArray();
+    return rules;
+}
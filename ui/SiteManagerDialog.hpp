@@ -11,6 +11,7 @@ class QPushButton;
 struct SiteEntry {
     QString name;
     openscp::SessionOptions opt;
+    QString excludes; // .gitignore-style rules for folder transfers with this site
 };
 
 class SiteManagerDialog : public QDialog {
@@ -18,10 +19,13 @@ class SiteManagerDialog : public QDialog {
 public:
     explicit SiteManagerDialog(QWidget* parent = nullptr);
     bool selectedOptions(openscp::SessionOptions& out) const;
+    // Transfer exclusion rules of the saved site matching host/port/user (empty if none)
+    static QString excludeRulesFor(const openscp::SessionOptions& opt);
 
 private slots:
     void onAdd();
     void onEdit();
+    void onEditExcludes();
     void onRemove();
     void onConnect();
     void updateButtons();
@@ -36,6 +40,7 @@ private:
     int selectedRow_ = -1;
     QPushButton* btAdd_ = nullptr;
     QPushButton* btEdit_ = nullptr;
+    QPushButton* btExcl_ = nullptr;
     QPushButton* btDel_  = nullptr;
     QPushButton* btConn_ = nullptr;
     QPushButton* btClose_= nullptr;
@@ -1,7 +1,13 @@
 // Queue implementation: manages one task at a time with progress and collision handling.
 #include "TransferManager.hpp"
 #include "openscp/SftpClient.hpp"
+#include "openscp/Compressibility.hpp"
+#include "openscp/Journal.hpp"
+#include "openscp/LocalTreeScanner.hpp"
+#include "openscp/SpillQueue.hpp"
+#include "openscp/TreeEnumerator.hpp"
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QThread>
 #include <QMetaObject>
 #include <QMessageBox>
@@ -16,29 +22,91 @@
 #include "TimeUtils.hpp"
 #include <QTimeZone>
 #include <QDir>
+#include <QHash>
+#include <QSettings>
+#include <QRandomGenerator>
+#include <QStandardPaths>
 #include <chrono>
+#include <cstring>
 #include <thread>
 Q_LOGGING_CATEGORY(ocXfer, "openscp.transfer")
 
-TransferManager::TransferManager(QObject* parent) : QObject(parent) {}
+// Pipelined small-file groups: files up to this size, this many per group
+static constexpr qint64 kBatchMaxFileBytes = 256 * 1024;
+static constexpr std::size_t kBatchMaxFiles = 64;
+// Folder walks: files per hand-over (or whatever was found within kFeedFlushMs), queued
+// tasks at which the walk pauses, and extra sessions listing remote folders in parallel
+static constexpr std::size_t kFeedChunk = 256;
+static constexpr int kFeedFlushMs = 200;
+static constexpr int kFeedBacklog = 2048;
+static constexpr std::size_t kFeedExtraSessions = 2;
+// Out-of-core queue: estimated memory per queued task (struct plus both paths as
+// QStrings), and tasks brought back from disk per page
+static constexpr std::size_t kTaskCostBytes = sizeof(TransferTask) + 512;
+static constexpr int kSpillPageIn = 1024;
+// Queue journal: state changes are written at most this often, and the log is rewritten
+// once it holds more than kJournalStale records per live task (plus kJournalSlack)
+static constexpr int kJournalSyncMs = 500;
+static constexpr std::uint64_t kJournalStale = 4;
+static constexpr std::uint64_t kJournalSlack = 4096;
+
+TransferManager::TransferManager(QObject* parent) : QObject(parent) {
+    runId_ = QRandomGenerator::global()->generate64();
+    journalTimer_.setSingleShot(true);
+    journalTimer_.setInterval(kJournalSyncMs);
+    connect(&journalTimer_, &QTimer::timeout, this, &TransferManager::syncJournal);
+    // Workers emit from their threads: this runs queued on the GUI thread
+    connect(this, &TransferManager::tasksChanged, this, [this] {
+        if (journal_ && !journalTimer_.isActive()) journalTimer_.start();
+    });
+}
 
 TransferManager::~TransferManager() {
+    stopFeeds();
     paused_ = true;
     for (auto& kv : workers_) {
         if (kv.second.joinable()) kv.second.join();
     }
     workers_.clear();
+    zclient_.reset();
+    if (journal_) {
+        // Stopped by the shutdown, not by the user: journaled as running, so the next
+        // run resumes them
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            for (auto& t : tasks_) {
+                if (t.status == TransferTask::Status::Paused && !pausedTasks_.count(t.id))
+                    t.status = TransferTask::Status::Running;
+            }
+        }
+        syncJournal();
+        if (journal_) journal_->flush(true);
+    }
+}
+
+void TransferManager::setSessionOptions(const openscp::SessionOptions& opt) {
+    sessionOpt_ = opt;
+    openJournal(opt);
 }
 
 void TransferManager::clearClient() {
+    stopFeeds(); // walks use sessions derived from the client
     // Signal pause so workers cooperate and finish
     paused_ = true;
     for (auto& kv : workers_) {
         if (kv.second.joinable()) kv.second.join();
     }
     workers_.clear();
+    {
+        std::lock_guard<std::mutex> zlk(zclientMutex_);
+        zclient_.reset();
+    }
+    zclientFailed_ = false;
     client_ = nullptr;
     running_ = 0;
+    forgetRemoteDirs();
+    syncJournal();
+    if (journal_) journal_->flush(true);
 }
 
 void TransferManager::enqueueUpload(const QString& local, const QString& remote) {
@@ -51,25 +119,617 @@ void TransferManager::enqueueUpload(const QString& local, const QString& remote)
         // (other functions will access concurrently)
         // mtx_ protects tasks_
         std::lock_guard<std::mutex> lk(mtx_);
-        tasks_.push_back(t);
+        addTaskLocked(t);
     }
     emit tasksChanged();
     if (!paused_) schedule();
 }
 
-void TransferManager::enqueueDownload(const QString& remote, const QString& local) {
+quint64 TransferManager::enqueueDownload(const QString& remote, const QString& local, qint64 sizeHint) {
     TransferTask t{ TransferTask::Type::Download };
     t.id = nextId_++;
     t.src = remote;
     t.dst = local;
+    t.sizeHint = sizeHint;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        addTaskLocked(t);
+    }
+    emit tasksChanged();
+    if (!paused_) schedule();
+    return t.id;
+}
+
+quint64 TransferManager::enqueueDownload(const openscp::PathRef& remote, const openscp::PathRef& local, qint64 sizeHint) {
+    TransferTask t{ TransferTask::Type::Download };
+    t.id = nextId_++;
+    t.srcRef = remote;
+    t.dstRef = local;
+    t.sizeHint = sizeHint;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        addTaskLocked(t);
+    }
+    emit tasksChanged();
+    if (!paused_) schedule();
+    return t.id;
+}
+
+void TransferManager::setQueueMemoryBudgetMB(int mb) {
+    budgetBytes_ = mb > 0 ? (std::size_t)mb << 20 : 0;
+    spillAfter_ = budgetBytes_ / kTaskCostBytes;
+}
+
+// File named after "key" (hashed) in the application data folder "sub" (created on
+// demand); empty if there is no writable data location
+static QString appDataFile(const QString& sub, const QString& key) {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty()) return QString();
+    dir = QDir(dir).filePath(sub);
+    QDir().mkpath(dir);
+    return QDir(dir).filePath(QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()));
+}
+
+static QString accountKey(const openscp::SessionOptions& opt) {
+    return QStringLiteral("%1@%2:%3").arg(QString::fromStdString(opt.username), QString::fromStdString(opt.host)).arg(opt.port);
+}
+
+// Where an interrupted download walk keeps its frontier: one file per server account,
+// remote folder and destination
+static QString walkCursorFile(const openscp::SessionOptions& opt, const QString& remoteDir, const QString& localDir) {
+    return appDataFile(QStringLiteral("cursors"), accountKey(opt) + '\n' + remoteDir + '\n' + QDir::cleanPath(localDir));
+}
+
+QString TransferManager::spillDirectory() {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (dir.isEmpty()) dir = QDir::tempPath();
+    dir = QDir(dir).filePath(QStringLiteral("spill"));
+    QDir().mkpath(dir);
+    return dir;
+}
+
+// Task record (spill file and journal): type (1 byte: U/D, lowercase for tree tasks), id,
+// sizeHint, journal generation, source length (u32), source, then the destination (UTF-8)
+static std::string encodeTask(const TransferTask& t, const QString& src, const QString& dst) {
+    const QByteArray s = src.toUtf8(), d = dst.toUtf8();
+    const std::uint32_t slen = (std::uint32_t)s.size();
+    std::string rec;
+    rec.reserve(1 + 8 + 8 + 4 + 4 + s.size() + d.size());
+    const char type = t.type == TransferTask::Type::Upload ? 'U' : 'D';
+    rec.push_back(t.tree ? (char)(type + ('a' - 'A')) : type);
+    rec.append(reinterpret_cast<const char*>(&t.id), sizeof(t.id));
+    rec.append(reinterpret_cast<const char*>(&t.sizeHint), sizeof(t.sizeHint));
+    rec.append(reinterpret_cast<const char*>(&t.journalGen), sizeof(t.journalGen));
+    rec.append(reinterpret_cast<const char*>(&slen), sizeof(slen));
+    rec.append(s.constData(), (std::size_t)s.size());
+    rec.append(d.constData(), (std::size_t)d.size());
+    return rec;
+}
+
+static bool decodeTask(std::string_view rec, TransferTask& t) {
+    constexpr std::size_t head = 1 + sizeof(t.id) + sizeof(t.sizeHint) + sizeof(t.journalGen) + sizeof(std::uint32_t);
+    if (rec.size() < head) return false;
+    std::uint32_t slen = 0;
+    const char* p = rec.data();
+    t.type = (p[0] == 'U' || p[0] == 'u') ? TransferTask::Type::Upload : TransferTask::Type::Download;
+    t.tree = p[0] == 'u' || p[0] == 'd';
+    p += 1;
+    std::memcpy(&t.id, p, sizeof(t.id));
+    p += sizeof(t.id);
+    std::memcpy(&t.sizeHint, p, sizeof(t.sizeHint));
+    p += sizeof(t.sizeHint);
+    std::memcpy(&t.journalGen, p, sizeof(t.journalGen));
+    p += sizeof(t.journalGen);
+    std::memcpy(&slen, p, sizeof(slen));
+    if (rec.size() - head < slen) return false;
+    t.src = QString::fromUtf8(rec.data() + head, (qsizetype)slen);
+    t.dst = QString::fromUtf8(rec.data() + head + slen, (qsizetype)(rec.size() - head - slen));
+    return true;
+}
+
+// Journal records: 'A' + task record (created), 'S' + id, status, progress, attempts and
+// error (state change), 'R' + id (removed from the queue)
+static std::string journalState(const TransferTask& t) {
+    const QByteArray e = t.error.toUtf8();
+    std::string rec(1, 'S');
+    rec.append(reinterpret_cast<const char*>(&t.id), sizeof(t.id));
+    rec.push_back((char)t.status);
+    rec.push_back((char)t.progress);
+    const std::int32_t attempts = t.attempts;
+    rec.append(reinterpret_cast<const char*>(&attempts), sizeof(attempts));
+    rec.append(e.constData(), (std::size_t)e.size());
+    return rec;
+}
+
+// Rebuild the queue from journal records: tasks in creation order, removed ones with id 0
+static void replayJournal(std::string_view rec, std::vector<TransferTask>& tasks, std::unordered_map<quint64, std::size_t>& at) {
+    if (rec.empty()) return;
+    const char kind = rec.front();
+    rec.remove_prefix(1);
+    if (kind == 'A') {
+        TransferTask t{ TransferTask::Type::Download };
+        if (decodeTask(rec, t)) {
+            at[t.id] = tasks.size();
+            tasks.push_back(std::move(t));
+        }
+        return;
+    }
+    quint64 id = 0;
+    if (rec.size() < sizeof(id)) return;
+    std::memcpy(&id, rec.data(), sizeof(id));
+    rec.remove_prefix(sizeof(id));
+    auto it = at.find(id);
+    if (it == at.end()) return;
+    TransferTask& t = tasks[it->second];
+    if (kind == 'R') {
+        t.id = 0;
+        at.erase(it);
+    } else if (kind == 'S' && rec.size() >= 2 + sizeof(std::int32_t)) {
+        t.status = (TransferTask::Status)rec[0];
+        t.progress = (unsigned char)rec[1];
+        std::int32_t attempts = 0;
+        std::memcpy(&attempts, rec.data() + 2, sizeof(attempts));
+        t.attempts = attempts;
+        t.error = QString::fromUtf8(rec.data() + 2 + sizeof(attempts), (qsizetype)(rec.size() - 2 - sizeof(attempts)));
+    }
+}
+
+// A task as the first records of a compacted journal
+static bool emitJournalTask(const openscp::Journal::Emit& emit, const TransferTask& t, const QString& src, const QString& dst) {
+    if (!emit(std::string(1, 'A') + encodeTask(t, src, dst))) return false;
+    if (t.status == TransferTask::Status::Queued && t.progress == 0 && t.attempts == 0 && t.error.isEmpty()) return true;
+    return emit(journalState(t));
+}
+
+void TransferManager::addTaskLocked(TransferTask& t, bool journal) {
+    if (journal && journal_) {
+        std::string err;
+        t.journalGen = journalGen_;
+        if (!journal_->append(std::string(1, 'A') + encodeTask(t, srcOf(t), dstOf(t)), err)) {
+            qWarning(ocXfer) << "Transfer journal write failed, the queue is no longer saved:" << QString::fromStdString(err);
+            journal_.reset();
+            t.journalGen = 0;
+        }
+    }
+    // Once tasks are on disk, newer ones follow them there so the order is kept. The spill
+    // record holds fresh tasks only: one with progress to resume (restored from the
+    // journal) stays in memory and simply runs earlier.
+    const bool over = spillAfter_ > 0 && ((std::size_t)tasks_.size() >= spillAfter_ || spilled_.load() > 0);
+    const bool fresh = !t.resumeHint && t.progress == 0 && t.attempts == 0;
+    if (over && fresh && !t.tree && t.status == TransferTask::Status::Queued && spillTask(t)) return;
+    tasks_.push_back(t);
+}
+
+bool TransferManager::spillTask(const TransferTask& t) {
+    if (!spill_) spill_ = std::make_unique<openscp::SpillQueue>(QFile::encodeName(spillDirectory()).toStdString());
+    std::string err;
+    if (!spill_->push(encodeTask(t, srcOf(t), dstOf(t)), err)) {
+        qWarning(ocXfer) << "Queue spill failed, keeping the task in memory:" << QString::fromStdString(err);
+        return false;
+    }
+    ++spilled_;
+    return true;
+}
+
+void TransferManager::pageIn() {
+    if (spilled_.load() == 0) return;
+    // Enough queued work in memory for every slot and the next prefetch pass
+    if (queuedCount(kSpillPageIn / 2) >= kSpillPageIn / 2) return;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        std::string rec;
+        for (int i = 0; i < kSpillPageIn && spill_->pop(rec); ++i) {
+            --spilled_;
+            TransferTask t{ TransferTask::Type::Download };
+            if (decodeTask(rec, t)) tasks_.push_back(t);
+        }
+    }
+    emit tasksChanged();
+}
+
+void TransferManager::materialize(TransferTask& t) const {
+    if (!t.srcRef.empty()) { t.src = pathOf(t.srcRef); t.srcRef = {}; }
+    if (!t.dstRef.empty()) { t.dst = pathOf(t.dstRef); t.dstRef = {}; }
+}
+
+void TransferManager::openJournal(const openscp::SessionOptions& opt) {
+    const QString file = appDataFile(QStringLiteral("journal"), accountKey(opt));
+    if (file.isEmpty() || (journal_ && file == journalFile_)) return;
+    // Another account: its tasks stay in memory but are no longer journaled
+    syncJournal();
+    if (journal_) journal_->flush(true);
+    journal_.reset();
+
+    const auto started = std::chrono::steady_clock::now();
+    auto j = std::make_unique<openscp::Journal>();
+    std::vector<TransferTask> restored;
+    std::unordered_map<quint64, std::size_t> at;
+    auto replay = [&](std::string_view rec) { replayJournal(rec, restored, at); };
+    const std::string path = QFile::encodeName(file).toStdString();
+    std::string err;
+    if (!j->open(path, replay, err)) {
+        qWarning(ocXfer) << "Transfer journal unreadable, starting a new one:" << QString::fromStdString(err);
+        QFile::remove(file);
+        restored.clear();
+        if (!j->open(path, {}, err)) {
+            qWarning(ocXfer) << "Transfer journal disabled:" << QString::fromStdString(err);
+            return;
+        }
+    }
+    journal_ = std::move(j);
+    journalFile_ = file;
+    ++journalGen_;
+
+    int resumed = 0;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        // The same transfers may still be in memory (this account was used before)
+        QSet<QString> present;
+        for (const auto& t : tasks_) present.insert(srcOf(t) + '\n' + dstOf(t));
+        std::vector<TransferTask> live;
+        live.reserve(restored.size());
+        for (auto& t : restored) {
+            if (t.id == 0 || present.contains(t.src + '\n' + t.dst)) continue;
+            t.id = nextId_++;
+            t.journalGen = journalGen_;
+            // Interrupted mid-transfer: continue from what is already at the destination
+            if (t.status == TransferTask::Status::Running) t.status = TransferTask::Status::Queued;
+            if (t.status != TransferTask::Status::Done && (t.progress > 0 || t.attempts > 0)) {
+                t.resumeHint = true;
+                ++resumed;
+            }
+            t.journaledStatus = t.status;
+            t.journaledProgress = t.progress;
+            live.push_back(std::move(t));
+        }
+        // New ids, and nothing but the live tasks
+        if (!journal_->compact([&](const openscp::Journal::Emit& emit) {
+                for (const auto& t : live) if (!emitJournalTask(emit, t, t.src, t.dst)) return;
+            }, err)) {
+            qWarning(ocXfer) << "Transfer journal compaction failed:" << QString::fromStdString(err);
+            if (!journal_->isOpen()) journal_.reset();
+        }
+        for (auto& t : live) addTaskLocked(t, false);
+        restored.swap(live);
+    }
+    if (restored.empty()) return;
+    qInfo(ocXfer) << "Restored" << restored.size() << "tasks (" << resumed << "to resume) from the transfer journal in"
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count() << "ms";
+    emit tasksChanged();
+    if (!paused_) schedule();
+}
+
+void TransferManager::syncJournal() {
+    if (!journal_) return;
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::string err;
+    std::uint64_t live = spilled_.load();
+    for (auto& t : tasks_) {
+        if (t.journalGen != journalGen_) continue;
+        ++live;
+        if (t.status == t.journaledStatus && t.progress == t.journaledProgress) continue;
+        if (!journal_->append(journalState(t), err)) {
+            qWarning(ocXfer) << "Transfer journal write failed, the queue is no longer saved:" << QString::fromStdString(err);
+            journal_.reset();
+            return;
+        }
+        t.journaledStatus = t.status;
+        t.journaledProgress = t.progress;
+    }
+    // Tasks on disk cannot be listed for the rewrite: compact once they are back
+    if (spilled_.load() == 0 && journal_->records() > kJournalStale * live + kJournalSlack) compactJournalLocked();
+    if (journal_) journal_->flush();
+}
+
+void TransferManager::compactJournalLocked() {
+    std::string err;
+    const bool ok = journal_->compact([&](const openscp::Journal::Emit& emit) {
+        for (const auto& t : tasks_) {
+            if (t.journalGen != journalGen_) continue;
+            if (!emitJournalTask(emit, t, srcOf(t), dstOf(t))) return;
+        }
+    }, err);
+    if (ok) return;
+    qWarning(ocXfer) << "Transfer journal compaction failed:" << QString::fromStdString(err);
+    if (!journal_->isOpen()) journal_.reset();
+}
+
+void TransferManager::journalRemoveLocked(quint64 id) {
+    if (!journal_) return;
+    std::string rec(1, 'R');
+    rec.append(reinterpret_cast<const char*>(&id), sizeof(id));
+    std::string err;
+    if (!journal_->append(rec, err)) {
+        qWarning(ocXfer) << "Transfer journal write failed, the queue is no longer saved:" << QString::fromStdString(err);
+        journal_.reset();
+    }
+}
+
+void TransferManager::enqueueTreeUpload(const QString& localDir, const QString& remoteDir) {
+    TransferTask t{ TransferTask::Type::Upload };
+    t.id = nextId_++;
+    t.src = localDir;
+    t.dst = remoteDir;
+    t.tree = true;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        addTaskLocked(t);
+    }
+    emit tasksChanged();
+    if (!paused_) schedule();
+}
+
+void TransferManager::enqueueTreeDownload(const QString& remoteDir, const QString& localDir) {
+    TransferTask t{ TransferTask::Type::Download };
+    t.id = nextId_++;
+    t.src = remoteDir;
+    t.dst = localDir;
+    t.tree = true;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        addTaskLocked(t);
+    }
+    emit tasksChanged();
+    if (!paused_) schedule();
+}
+
+bool TransferManager::enqueueDownloadFeed(const QString& remoteDir, const QString& localDir, EntryFilter accept, Rules rules) {
+    if (!client_ || !sessionOpt_) return false;
+    openscp::SftpClient* origin = client_;
+    const openscp::SessionOptions opt = *sessionOpt_;
+    QSettings s("OpenSCP", "OpenSCP");
+    int maxDepth = s.value("Advanced/maxFolderDepth", 32).toInt();
+    if (maxDepth < 1) maxDepth = 32;
+    std::shared_ptr<openscp::PathStore> paths = paths_;
+    // A walk cut short by a lost connection resumes where it stopped: folders already
+    // listed are not listed again, files already queued are not queued twice. That is
+    // only right while those files are still in the queue; otherwise ask first.
+    const QString cursorFile = walkCursorFile(opt, remoteDir, localDir);
+    const std::string cursorPath = QFile::encodeName(cursorFile).toStdString();
+    quint64 firstId = nextId_; // every task of this walk gets an id from here on
+    bool resume = false;
+    if (!cursorFile.isEmpty() && QFile::exists(cursorFile)) {
+        std::string tag;
+        const QStringList parts = openscp::EnumCursor::readTag(cursorPath, tag)
+                                      ? QString::fromStdString(tag).split(':') : QStringList();
+        if (parts.size() == 2 && parts[0].toULongLong() == runId_ && walkTasksIntact(parts[1].toULongLong(), localDir)) {
+            resume = true;
+            firstId = parts[1].toULongLong();
+        } else {
+            resume = QMessageBox::question(nullptr, tr("Reanudar descarga"),
+                                           tr("Una descarga anterior de «%1» quedó interrumpida.\n"
+                                              "¿Continuar donde se quedó? Los archivos que ya se habían encontrado "
+                                              "no se volverán a poner en cola.").arg(remoteDir))
+                     == QMessageBox::Yes;
+        }
+        if (!resume) QFile::remove(cursorFile);
+    }
+    startFeed([=, this](const std::shared_ptr<Feed>& f) {
+        // Own sessions: the queue keeps using client_ meanwhile
+        std::string err;
+        std::unique_ptr<openscp::SftpClient> session = origin->newConnectionLike(opt, err);
+        if (!session) {
+            postFeedError(TransferTask::Type::Download, remoteDir, localDir,
+                          tr("No se pudo enumerar la carpeta: %1").arg(QString::fromStdString(err)));
+            return;
+        }
+        openscp::SessionPool pool(*session, opt, kFeedExtraSessions);
+        openscp::TreeEnumOptions topt;
+        topt.maxDepth = maxDepth;
+        topt.skipSymlinks = false; // links are transferred as entries, never followed
+        topt.cancel = &f->cancel;
+        topt.pool = &pool;
+        topt.ownsClient = true; // the walk's own session
+        topt.rules = rules.get();
+        const QDir root(localDir);
+        QDir().mkpath(localDir);
+        // Files are interned below both roots: the remote and local paths share folder
+        // nodes with their siblings and one copy of the file name
+        const std::string remoteRoot = remoteDir.toStdString();
+        const auto remoteId = paths->dir(remoteRoot);
+        const auto localId = paths->dir(localDir.toStdString());
+        std::vector<FeedItem> chunk;
+        auto lastPost = std::chrono::steady_clock::now();
+        auto onEntry = [&](const openscp::TreeEntry& e) {
+            if (accept && !accept(QString::fromStdString(e.info.name))) { ++feedSkipped_; return false; }
+            if (e.info.is_dir) { QDir().mkpath(root.filePath(QString::fromStdString(e.rel))); return true; } // empty folders too
+            const openscp::PathRef src = paths->file(e.rel, remoteId);
+            chunk.push_back({ src, paths->rebase(src, remoteId, localId), e.info.has_size ? (qint64)e.info.size : -1 });
+            ++feedFiles_;
+            if (e.info.has_size) feedBytes_ += e.info.size;
+            // The first files leave quickly so the link is busy while the walk goes on
+            const auto now = std::chrono::steady_clock::now();
+            if (chunk.size() >= kFeedChunk || now - lastPost >= std::chrono::milliseconds(kFeedFlushMs)) {
+                lastPost = now;
+                return postFeedItems(f, TransferTask::Type::Download, chunk, true);
+            }
+            return true;
+        };
+        openscp::EnumCursor cursor;
+        if (resume) {
+            if (cursor.load(cursorPath, err))
+                qInfo(ocXfer) << "resuming download walk of" << remoteDir << ":" << cursor.pending.size() << "folders pending";
+            else
+                qWarning(ocXfer) << QString::fromStdString(err);
+        }
+        if (!cursorFile.isEmpty()) topt.cursor = &cursor;
+        openscp::TreeEnumStats stats;
+        const bool complete = openscp::enumerateTree(*session, remoteRoot, topt, onEntry, stats, err);
+        postFeedItems(f, TransferTask::Type::Download, chunk, false);
+        feedSkipped_ += stats.excluded;
+        if (stats.reconnects)
+            qInfo(ocXfer) << "download walk of" << remoteDir << "reconnected" << stats.reconnects << "times";
+        if (stats.listFailures) {
+            qWarning(ocXfer) << "download walk of" << remoteDir << ":" << stats.listFailures << "folders could not be listed";
+            postFeedError(TransferTask::Type::Download, remoteDir, localDir,
+                          tr("%1 carpeta(s) no se pudieron leer y se omitieron").arg(stats.listFailures));
+        }
+        if (complete || f->cancel.load() || cursor.empty()) {
+            if (!cursorFile.isEmpty()) QFile::remove(cursorFile);
+            return;
+        }
+        // Tagged with this run and the first task of the walk (see walkTasksIntact)
+        cursor.tag = QStringLiteral("%1:%2").arg(runId_).arg(firstId).toStdString();
+        std::string serr;
+        if (!cursor.save(cursorPath, serr)) qWarning(ocXfer) << QString::fromStdString(serr);
+        postFeedError(TransferTask::Type::Download, remoteDir, localDir,
+                      tr("Enumeración interrumpida (se reanudará al descargar de nuevo la carpeta): %1")
+                          .arg(QString::fromStdString(err)));
+    });
+    return true;
+}
+
+void TransferManager::enqueueUploadFeed(const QString& localDir, const QString& remoteDir, Rules rules) {
+    std::shared_ptr<openscp::PathStore> paths = paths_;
+    startFeed([=, this](const std::shared_ptr<Feed>& f) {
+        openscp::LocalScanOptions sopt;
+        sopt.skipHidden = true; // as the QDirIterator walks did
+        sopt.cancel = &f->cancel;
+        sopt.rules = rules.get();
+        const auto localId = paths->dir(localDir.toStdString());
+        const auto remoteId = paths->dir(remoteDir.toStdString());
+        std::vector<FeedItem> chunk;
+        auto lastPost = std::chrono::steady_clock::now();
+        auto onFile = [&](const openscp::LocalTreeFile& lf) {
+            // The store holds UTF-8; scanner paths are in the local 8-bit encoding
+            const QByteArray rel = QFile::decodeName(QByteArray::fromStdString(lf.rel)).toUtf8();
+            const openscp::PathRef src = paths->file(std::string_view(rel.constData(), (std::size_t)rel.size()), localId);
+            chunk.push_back({ src, paths->rebase(src, localId, remoteId), (qint64)lf.size });
+            ++feedFiles_;
+            feedBytes_ += lf.size;
+            const auto now = std::chrono::steady_clock::now();
+            if (chunk.size() >= kFeedChunk || now - lastPost >= std::chrono::milliseconds(kFeedFlushMs)) {
+                lastPost = now;
+                return postFeedItems(f, TransferTask::Type::Upload, chunk, true);
+            }
+            return true;
+        };
+        openscp::LocalScanStats stats;
+        std::string err;
+        if (!openscp::scanLocalTree(QFile::encodeName(localDir).toStdString(), sopt, onFile, stats, err)
+            && stats.dirs == 0 && !f->cancel.load()) {
+            postFeedError(TransferTask::Type::Upload, localDir, remoteDir, QString::fromStdString(err));
+            return;
+        }
+        postFeedItems(f, TransferTask::Type::Upload, chunk, false);
+        feedSkipped_ += stats.excluded;
+        if (stats.errors)
+            qWarning(ocXfer) << "upload walk of" << localDir << ":" << stats.errors << "entries could not be read";
+    });
+}
+
+TransferManager::FeedTotals TransferManager::feedTotals() const {
+    FeedTotals t;
+    for (const auto& f : feeds_) if (!f->finished.load()) ++t.active;
+    t.files = feedFiles_.load();
+    t.bytes = feedBytes_.load();
+    t.skipped = feedSkipped_.load();
+    return t;
+}
+
+void TransferManager::startFeed(std::function<void(const std::shared_ptr<Feed>&)> body) {
+    reapFeeds();
+    if (feeds_.empty()) { feedFiles_ = 0; feedBytes_ = 0; feedSkipped_ = 0; } // new totals
+    auto f = std::make_shared<Feed>();
+    f->thread = std::thread([this, f, body = std::move(body)] {
+        body(f);
+        f->finished = true;
+        QMetaObject::invokeMethod(this, [this] { reapFeeds(); emit tasksChanged(); }, Qt::QueuedConnection);
+    });
+    feeds_.push_back(std::move(f));
+    emit tasksChanged();
+}
+
+bool TransferManager::postFeedItems(const std::shared_ptr<Feed>& f, TransferTask::Type type, std::vector<FeedItem>& items, bool wait) {
+    if (!items.empty()) {
+        feedInFlight_ += (int)items.size();
+        QMetaObject::invokeMethod(this, [this, f, type, batch = std::move(items)] {
+            appendFeedItems(f, type, batch);
+        }, Qt::QueuedConnection);
+        items.clear();
+    }
+    // Back-pressure: enough queued work keeps every slot busy; let transfers catch up
+    while (wait && !f->cancel.load()) {
+        if (feedInFlight_.load() + (qint64)spilled_.load() + queuedCount(kFeedBacklog) < kFeedBacklog) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return !f->cancel.load();
+}
+
+void TransferManager::appendFeedItems(const std::shared_ptr<Feed>& f, TransferTask::Type type, const std::vector<FeedItem>& items) {
+    feedInFlight_ -= (int)items.size();
+    if (f->cancel.load()) return; // cancelled after the hand-over
     {
         std::lock_guard<std::mutex> lk(mtx_);
-        tasks_.push_back(t);
+        tasks_.reserve(tasks_.size() + (int)items.size());
+        for (const auto& it : items) {
+            TransferTask t{ type };
+            t.id = nextId_++;
+            t.srcRef = it.src;
+            t.dstRef = it.dst;
+            t.sizeHint = it.size;
+            addTaskLocked(t);
+        }
     }
     emit tasksChanged();
     if (!paused_) schedule();
 }
 
+void TransferManager::postFeedError(TransferTask::Type type, const QString& src, const QString& dst, const QString& error) {
+    QMetaObject::invokeMethod(this, [this, type, src, dst, error] {
+        TransferTask t{ type };
+        t.id = nextId_++;
+        t.src = src;
+        t.dst = dst;
+        t.notice = true;
+        t.status = TransferTask::Status::Error;
+        t.error = error;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            addTaskLocked(t, false);
+        }
+        emit tasksChanged();
+    }, Qt::QueuedConnection);
+}
+
+bool TransferManager::walkTasksIntact(quint64 firstId, const QString& localDir) const {
+    const QString prefix = QDir::cleanPath(localDir) + '/';
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (cancelAllBefore_ > firstId) return false; // spilled tasks may have been dropped unseen
+    for (const auto& t : tasks_) {
+        if (t.id < firstId) continue;
+        if (t.status != TransferTask::Status::Canceled && t.status != TransferTask::Status::Error) continue;
+        if (dstOf(t).startsWith(prefix)) return false;
+    }
+    return true;
+}
+
+int TransferManager::queuedCount(int limit) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    int n = 0;
+    for (const auto& t : tasks_) {
+        if (t.status == TransferTask::Status::Queued && ++n >= limit) break;
+    }
+    return n;
+}
+
+void TransferManager::reapFeeds() {
+    for (auto it = feeds_.begin(); it != feeds_.end();) {
+        if ((*it)->finished.load()) {
+            if ((*it)->thread.joinable()) (*it)->thread.join();
+            it = feeds_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TransferManager::stopFeeds() {
+    for (auto& f : feeds_) f->cancel = true;
+    for (auto& f : feeds_) if (f->thread.joinable()) f->thread.join();
+    feeds_.clear();
+}
+
 void TransferManager::pauseAll() {
     paused_ = true;
     emit tasksChanged();
@@ -94,9 +754,22 @@ void TransferManager::resumeAll() {
 }
 
 void TransferManager::cancelAll() {
+    // Stop the folder walks too, or they would keep queueing files
+    for (auto& f : feeds_) f->cancel = true;
     // Mark all tasks as stopped and request cooperative cancellation
     {
         std::lock_guard<std::mutex> lk(mtx_);
+        cancelAllBefore_ = nextId_;
+        // Tasks still on disk never started: drop them
+        if (spill_) {
+            std::string rec;
+            TransferTask s{ TransferTask::Type::Download };
+            while (journal_ && spill_->pop(rec)) {
+                if (decodeTask(rec, s) && s.journalGen == journalGen_) journalRemoveLocked(s.id);
+            }
+            spill_->clear();
+        }
+        spilled_ = 0;
         for (auto& t : tasks_) {
             canceledTasks_.insert(t.id);
             if (t.status == TransferTask::Status::Queued || t.status == TransferTask::Status::Running || t.status == TransferTask::Status::Paused) {
@@ -110,11 +783,13 @@ void TransferManager::cancelAll() {
 void TransferManager::retryFailed() {
     std::lock_guard<std::mutex> lk(mtx_);
     for (auto& t : tasks_) {
+        if (t.notice) continue; // the folder is queued again by downloading it again
         if (t.status == TransferTask::Status::Error || t.status == TransferTask::Status::Canceled) {
             t.status = TransferTask::Status::Queued;
             t.attempts = 0;
             t.progress = 0;
             t.error.clear();
+            t.fileErrors.clear();
             canceledTasks_.erase(t.id);
         }
     }
@@ -128,8 +803,13 @@ void TransferManager::clearCompleted() {
     next.reserve(tasks_.size());
     for (const auto& t : tasks_) {
         if (t.status != TransferTask::Status::Done) next.push_back(t);
+        else if (t.journalGen == journalGen_) journalRemoveLocked(t.id);
     }
     tasks_.swap(next);
+    // Nothing refers to the interned paths any more (no task, walk or other holder):
+    // start over with an empty store
+    if (tasks_.isEmpty() && feeds_.empty() && feedInFlight_.load() == 0 && paths_.use_count() == 1)
+        paths_ = std::make_shared<openscp::PathStore>();
     emit tasksChanged();
 }
 
@@ -140,6 +820,7 @@ void TransferManager::processNext() {
 
 void TransferManager::schedule() {
     if (paused_ || !client_) return;
+    pageIn();
 
     // Pre-resolve collisions and launch up to maxConcurrent_
     auto askOverwrite = [&](const QString& name, const QString& srcInfo, const QString& dstInfo) -> int {
@@ -156,6 +837,43 @@ void TransferManager::schedule() {
         return 0; // omitir
     };
 
+    // Pending group of small files for the pipelined engine (one worker for the whole group)
+    std::vector<TransferTask> batch;
+    auto flushBatch = [&]() {
+        if (batch.empty()) return;
+        launchBatch(std::move(batch));
+        batch.clear();
+    };
+
+    // Remote stat of queued upload destinations, fetched in one pipelined batch together
+    // with the creation of their missing parents. The stats are only valid for this
+    // scheduling pass so decisions never rest on stale data.
+    QHash<QString, openscp::SftpClient::StatResult> dstStats;
+    auto prefetchUploads = [&](const QString& current) {
+        const std::size_t limit = (std::size_t)qMax(1, maxConcurrent_) * kBatchMaxFiles;
+        std::vector<std::string> paths{ current.toStdString() };
+        QStringList keys{ current };
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            for (const auto& q : tasks_) {
+                if (paths.size() >= limit) break;
+                if (q.status != TransferTask::Status::Queued || q.type != TransferTask::Type::Upload || q.tree) continue;
+                const QString dst = dstOf(q);
+                if (dstStats.contains(dst) || keys.contains(dst)) continue;
+                keys << dst;
+                paths.push_back(dst.toStdString());
+            }
+        }
+        ensureRemoteParents(keys);
+        std::vector<openscp::SftpClient::StatResult> res;
+        std::string err;
+        {
+            std::lock_guard<std::mutex> slk(sftpMutex_);
+            if (!client_->statMany(paths, res, err)) return;
+        }
+        for (int i = 0; i < keys.size(); ++i) dstStats.insert(keys[i], res[(std::size_t)i]);
+    };
+
     while (running_.load() < maxConcurrent_) {
         // Locate next queued task
         TransferTask t;
@@ -165,6 +883,7 @@ void TransferManager::schedule() {
             for (int i = 0; i < tasks_.size(); ++i) {
                 if (tasks_[i].status == TransferTask::Status::Queued) {
                     idx = i;
+                    materialize(tasks_[i]);
                     t = tasks_[i];
                     break;
                 }
@@ -173,37 +892,40 @@ void TransferManager::schedule() {
                 tasks_[idx].status = TransferTask::Status::Running;
                 tasks_[idx].progress = 0;
                 tasks_[idx].error.clear();
+                tasks_[idx].fileErrors.clear();
             }
         }
         if (idx < 0) break;
         emit tasksChanged();
+        if (t.type == TransferTask::Type::Upload && t.sizeHint < 0 && !t.tree)
+            t.sizeHint = QFileInfo(t.src).size();
 
         bool resume = t.resumeHint;
 
         // Pre-resolution of collisions
-        if (t.type == TransferTask::Type::Upload) {
-            // Does remote exist?
-            bool isDir = false;
-            std::string sErr;
-            bool ex = false;
-            {
+        if (t.tree) {
+            // Tree tasks overwrite in place; the remote side runs mkdir -p itself
+            if (t.type == TransferTask::Type::Download) QDir().mkpath(t.dst);
+        } else if (t.type == TransferTask::Type::Upload) {
+            // Does remote exist? (answered from the batch prefetch when possible)
+            if (!dstStats.contains(t.dst)) prefetchUploads(t.dst);
+            openscp::SftpClient::StatResult dst;
+            if (dstStats.contains(t.dst)) {
+                dst = dstStats.take(t.dst);
+            } else {
                 std::lock_guard<std::mutex> slk(sftpMutex_);
-                ex = client_->exists(t.dst.toStdString(), isDir, sErr);
+                dst.exists = client_->stat(t.dst.toStdString(), dst.info, dst.err);
             }
-            if (!sErr.empty()) {
+            if (!dst.err.empty()) {
                 std::lock_guard<std::mutex> lk(mtx_);
                 tasks_[idx].status = TransferTask::Status::Error;
-                tasks_[idx].error = QString::fromStdString(sErr);
+                tasks_[idx].error = QString::fromStdString(dst.err);
                 emit tasksChanged();
                 continue;
             }
-            if (ex) {
-                openscp::FileInfo rinfo{};
-                std::string stErr;
-                {
-                    std::lock_guard<std::mutex> slk(sftpMutex_);
-                    client_->stat(t.dst.toStdString(), rinfo, stErr);
-                }
+            // A task resuming its own partial file does not ask
+            if (dst.exists && !resume) {
+                const openscp::FileInfo& rinfo = dst.info;
                 QString srcInfo = QString("%1 bytes, %2")
                     .arg(QFileInfo(t.src).size())
                     .arg(openscpui::localShortTime(QFileInfo(t.src).lastModified()));
@@ -220,34 +942,12 @@ void TransferManager::schedule() {
                 resume = (choice == 2);
             }
 
-                // Ensure remote parent directories exist
-            auto ensureRemoteDir = [&](const QString& dir) -> bool {
-                if (dir.isEmpty()) return true;
-                QString cur = "/";
-                const QStringList parts = dir.split('/', Qt::SkipEmptyParts);
-                for (const QString& part : parts) {
-                    QString next = (cur == "/") ? ("/" + part) : (cur + "/" + part);
-                    bool isD = false;
-                    std::string e;
-                    bool exs = false;
-                    {
-                        std::lock_guard<std::mutex> slk(sftpMutex_);
-                        exs = client_->exists(next.toStdString(), isD, e);
-                        if (!exs && e.empty()) {
-                            std::string me;
-                            if (!client_->mkdir(next.toStdString(), me, 0755)) return false;
-                        }
-                    }
-                    cur = next;
-                }
-                return true;
-            };
-            QString parentDir = QFileInfo(t.dst).path();
-            if (!parentDir.isEmpty()) ensureRemoteDir(parentDir);
+            // Parent directories: normally created by the prefetch pass above
+            ensureRemoteParents(QStringList{ t.dst });
         } else {
             // Download: local collision
             QFileInfo lfi(t.dst);
-            if (lfi.exists()) {
+            if (lfi.exists() && !resume) {
                 openscp::FileInfo rinfo{};
                 std::string stErr;
                 {
@@ -272,6 +972,21 @@ void TransferManager::schedule() {
             QDir().mkpath(QFileInfo(t.dst).dir().absolutePath());
         }
 
+        if (!resume && isBatchable(t)) {
+            if (!batch.empty() && batch.front().type != t.type) flushBatch();
+            batch.push_back(t);
+            if (batch.size() >= kBatchMaxFiles) flushBatch();
+            continue;
+        }
+        flushBatch();
+        if (running_.load() >= maxConcurrent_) {
+            // The flushed group took the last slot: leave this task for the next round
+            std::lock_guard<std::mutex> lk(mtx_);
+            int i = indexForId(t.id);
+            if (i >= 0 && tasks_[i].status == TransferTask::Status::Running) tasks_[i].status = TransferTask::Status::Queued;
+            break;
+        }
+
         // Launch worker to execute the transfer
         running_.fetch_add(1);
         const quint64 taskId = t.id;
@@ -359,13 +1074,59 @@ void TransferManager::schedule() {
                 }
             };
 
+            // Route compressible transfers through the compressed session (Auto mode)
+            openscp::SftpClient* xfer = client_;
+            std::mutex* xferMutex = &sftpMutex_;
+            std::shared_ptr<openscp::SftpClient> zc; // keeps the compressed session alive until the task ends
+            if (wantsCompression(t)) {
+                std::string zerr;
+                if ((zc = compressedClient(zerr))) {
+                    xfer = zc.get();
+                    xferMutex = &zclientMutex_;
+                } else {
+                    qWarning(ocXfer) << "Compressed session unavailable, using main session:" << QString::fromStdString(zerr);
+                }
+            }
+
             bool ok = false;
-            if (t.type == TransferTask::Type::Upload) {
+            if (t.tree) {
+                // Whole folder as one tar stream; per-file errors are collected on the task
+                auto fileError = [this, taskId](const std::string& path, const std::string& msg) {
+                    std::lock_guard<std::mutex> lk(mtx_);
+                    int i = indexForId(taskId);
+                    if (i >= 0) tasks_[i].fileErrors << QString::fromStdString(path.empty() ? msg : path + ": " + msg);
+                };
+                std::string terr;
+                {
+                    std::lock_guard<std::mutex> slk(sftpMutex_);
+                    ok = (t.type == TransferTask::Type::Upload)
+                        ? client_->putTree(t.src.toStdString(), t.dst.toStdString(), terr, progress, fileError, shouldCancel)
+                        : client_->getTree(t.src.toStdString(), t.dst.toStdString(), terr, progress, fileError, shouldCancel);
+                }
+                const bool stopped = !ok && shouldCancel();
+                std::lock_guard<std::mutex> lk(mtx_);
+                int i = indexForId(taskId);
+                if (i >= 0) {
+                    if (stopped) {
+                        tasks_[i].status = canceledTasks_.count(taskId) ? TransferTask::Status::Canceled : TransferTask::Status::Paused;
+                    } else if (!ok) {
+                        tasks_[i].status = TransferTask::Status::Error;
+                        tasks_[i].error = QString::fromStdString(terr);
+                    } else if (!tasks_[i].fileErrors.isEmpty()) {
+                        tasks_[i].progress = 100;
+                        tasks_[i].status = TransferTask::Status::Error;
+                        tasks_[i].error = tr("%1 archivo(s) con errores").arg(tasks_[i].fileErrors.size());
+                    } else {
+                        tasks_[i].progress = 100;
+                        tasks_[i].status = TransferTask::Status::Done;
+                    }
+                }
+            } else if (t.type == TransferTask::Type::Upload) {
                 // Upload local->remote
                 std::string perr;
                 {
-                    std::lock_guard<std::mutex> slk(sftpMutex_);
-                    ok = client_->put(t.src.toStdString(), t.dst.toStdString(), perr, progress, shouldCancel, resume);
+                    std::lock_guard<std::mutex> slk(*xferMutex);
+                    ok = xfer->put(t.src.toStdString(), t.dst.toStdString(), perr, progress, shouldCancel, resume);
                 }
                 if (!ok && shouldCancel()) {
                     // Paused or canceled
@@ -373,6 +1134,8 @@ void TransferManager::schedule() {
                     int i = indexForId(taskId);
                     if (i >= 0) tasks_[i].status = isCanceled() ? TransferTask::Status::Canceled : TransferTask::Status::Paused;
                 } else if (!ok) {
+                    // The parent may have vanished behind our back
+                    forgetRemoteDirs(QFileInfo(t.dst).path());
                     std::lock_guard<std::mutex> lk(mtx_);
                     int i = indexForId(taskId);
                     if (i >= 0) { tasks_[i].status = TransferTask::Status::Error; tasks_[i].error = QString::fromStdString(perr); }
@@ -385,8 +1148,8 @@ void TransferManager::schedule() {
                 // Download remote->local
                 std::string gerr;
                 {
-                    std::lock_guard<std::mutex> slk(sftpMutex_);
-                    ok = client_->get(t.src.toStdString(), t.dst.toStdString(), gerr, progress, shouldCancel, resume);
+                    std::lock_guard<std::mutex> slk(*xferMutex);
+                    ok = xfer->get(t.src.toStdString(), t.dst.toStdString(), gerr, progress, shouldCancel, resume);
                 }
                 if (!ok && shouldCancel()) {
                     std::lock_guard<std::mutex> lk(mtx_);
@@ -425,6 +1188,146 @@ void TransferManager::schedule() {
             QMetaObject::invokeMethod(this, "schedule", Qt::QueuedConnection);
         });
     }
+    flushBatch();
+}
+
+bool TransferManager::isBatchable(const TransferTask& t) const {
+    if (t.tree || t.sizeHint < 0 || t.sizeHint > kBatchMaxFileBytes) return false;
+    // The pipelined engine does not throttle; keep speed limits exact. Small files gain
+    // more from pipelining than from compression, so their content is not sampled here.
+    return globalSpeedKBps_.load() <= 0 && t.speedLimitKBps <= 0;
+}
+
+void TransferManager::launchBatch(std::vector<TransferTask> batch) {
+    running_.fetch_add(1);
+    const quint64 key = batch.front().id;
+    if (workers_.count(key) && workers_[key].joinable()) {
+        workers_[key].join();
+    }
+    workers_[key] = std::thread([this, batch]() {
+        auto markAll = [&](TransferTask::Status st, const QString& e) {
+            std::lock_guard<std::mutex> lk(mtx_);
+            for (const auto& bt : batch) {
+                int i = indexForId(bt.id);
+                if (i >= 0 && tasks_[i].status == TransferTask::Status::Running) { tasks_[i].status = st; tasks_[i].error = e; }
+            }
+        };
+        std::string err;
+        if (!ensureConnected(err)) {
+            markAll(TransferTask::Status::Error, QString::fromStdString(err));
+            emit tasksChanged();
+            running_.fetch_sub(1);
+            QMetaObject::invokeMethod(this, "schedule", Qt::QueuedConnection);
+            return;
+        }
+        std::vector<openscp::SftpClient::TransferPair> items;
+        items.reserve(batch.size());
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            for (const auto& bt : batch) {
+                items.push_back({ bt.src.toStdString(), bt.dst.toStdString() });
+                int i = indexForId(bt.id);
+                if (i >= 0) tasks_[i].attempts += 1;
+            }
+        }
+        emit tasksChanged();
+
+        auto onItemDone = [this, &batch](std::size_t k, bool ok, const std::string& e) {
+            const quint64 id = batch[k].id;
+            if (!ok && batch[k].type == TransferTask::Type::Upload) forgetRemoteDirs(QFileInfo(batch[k].dst).path());
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                int i = indexForId(id);
+                if (i < 0) return;
+                if (ok) { tasks_[i].progress = 100; tasks_[i].status = TransferTask::Status::Done; }
+                else if (canceledTasks_.count(id)) tasks_[i].status = TransferTask::Status::Canceled;
+                else if (paused_.load() || pausedTasks_.count(id)) tasks_[i].status = TransferTask::Status::Paused;
+                else { tasks_[i].status = TransferTask::Status::Error; tasks_[i].error = QString::fromStdString(e); }
+            }
+            emit tasksChanged();
+        };
+        auto progress = [this, &batch](std::size_t k, std::size_t done, std::size_t total) {
+            const int pct = (total > 0) ? int((done * 100) / total) : 0;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                int i = indexForId(batch[k].id);
+                if (i >= 0) tasks_[i].progress = pct;
+            }
+            emit tasksChanged();
+        };
+        auto shouldCancel = [this, &batch](std::size_t k) -> bool {
+            if (paused_.load()) return true;
+            std::lock_guard<std::mutex> lk(mtx_);
+            return canceledTasks_.count(batch[k].id) > 0 || pausedTasks_.count(batch[k].id) > 0;
+        };
+
+        bool ok = false;
+        std::string berr;
+        {
+            std::lock_guard<std::mutex> slk(sftpMutex_);
+            ok = (batch.front().type == TransferTask::Type::Upload)
+                ? client_->putMany(items, berr, onItemDone, progress, shouldCancel)
+                : client_->getMany(items, berr, onItemDone, progress, shouldCancel);
+        }
+        if (!ok) markAll(TransferTask::Status::Error, QString::fromStdString(berr));
+
+        emit tasksChanged();
+        running_.fetch_sub(1);
+        QMetaObject::invokeMethod(this, "schedule", Qt::QueuedConnection);
+    });
+}
+
+bool TransferManager::remoteDirKnown(const QString& dir) {
+    std::lock_guard<std::mutex> lk(dirCacheMutex_);
+    return knownRemoteDirs_.contains(dir);
+}
+
+void TransferManager::noteRemoteDir(const QString& dir) {
+    std::lock_guard<std::mutex> lk(dirCacheMutex_);
+    QString cur = dir;
+    while (!cur.isEmpty() && cur != "/" && !knownRemoteDirs_.contains(cur)) {
+        knownRemoteDirs_.insert(cur);
+        const int slash = cur.lastIndexOf('/');
+        cur = (slash <= 0) ? QString() : cur.left(slash);
+    }
+}
+
+void TransferManager::forgetRemoteDirs(const QString& dir) {
+    std::lock_guard<std::mutex> lk(dirCacheMutex_);
+    if (dir.isEmpty()) { knownRemoteDirs_.clear(); return; }
+    const QString prefix = dir + '/';
+    for (auto it = knownRemoteDirs_.begin(); it != knownRemoteDirs_.end();) {
+        if (*it == dir || it->startsWith(prefix)) it = knownRemoteDirs_.erase(it);
+        else ++it;
+    }
+}
+
+void TransferManager::ensureRemoteParents(const QStringList& remotePaths) {
+    QStringList missing;
+    for (const QString& p : remotePaths) {
+        const QString parent = QFileInfo(p).path();
+        if (parent.isEmpty() || parent == "/" || parent == ".") continue;
+        if (!missing.contains(parent) && !remoteDirKnown(parent)) missing << parent;
+    }
+    if (missing.isEmpty()) return;
+    std::vector<std::string> dirs;
+    dirs.reserve(missing.size());
+    for (const QString& d : missing) dirs.push_back(d.toStdString());
+    std::vector<std::string> errors;
+    std::string err;
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> slk(sftpMutex_);
+        ok = client_->mkdirs(dirs, errors, err, 0755);
+    }
+    if (!ok) {
+        qWarning(ocXfer) << "Remote mkdir -p failed:" << QString::fromStdString(err);
+        return;
+    }
+    for (int i = 0; i < missing.size(); ++i) {
+        if (errors[(std::size_t)i].empty()) noteRemoteDir(missing[i]);
+        else forgetRemoteDirs(missing[i]);
+    }
 }
 
 int TransferManager::indexForId(quint64 id) const {
@@ -438,11 +1341,17 @@ bool TransferManager::ensureConnected(std::string& err) {
         err = "No client";
         return false;
     }
-    if (client_->isConnected()) return true;
+    if (client_->isConnected() && !client_->transportLost()) return true;
     if (!sessionOpt_.has_value()) {
         err = "Sin opciones de sesión";
         return false;
     }
+    {
+        // A stalled batch left unanswered requests behind: start over on a fresh session
+        std::lock_guard<std::mutex> slk(sftpMutex_);
+        if (client_->isConnected() && client_->transportLost()) client_->disconnect();
+        if (client_->isConnected()) return true; // another worker already reconnected
+    }
     // Try reconnecting with exponential backoff
     using namespace std::chrono_literals;
     for (int i = 0; i < 3; ++i) {
@@ -452,6 +1361,43 @@ bool TransferManager::ensureConnected(std::string& err) {
     return false;
 }
 
+bool TransferManager::wantsCompression(TransferTask& t) {
+    if (!sessionOpt_.has_value() || sessionOpt_->compression != openscp::CompressionMode::Auto) return false;
+    if (zclientFailed_.load() || t.tree) return false;
+    if (t.compressible < 0) {
+        // Downloads cannot be sampled before transfer; rely on the file name
+        const bool yes = (t.type == TransferTask::Type::Upload)
+            ? openscp::localFileLooksCompressible(t.src.toStdString())
+            : openscp::remoteNameLooksCompressible(t.src.toStdString());
+        t.compressible = yes ? 1 : 0;
+        std::lock_guard<std::mutex> lk(mtx_);
+        int i = indexForId(t.id);
+        if (i >= 0) tasks_[i].compressible = t.compressible; // retries do not sample again
+    }
+    return t.compressible == 1;
+}
+
+std::shared_ptr<openscp::SftpClient> TransferManager::compressedClient(std::string& err) {
+    std::lock_guard<std::mutex> zlk(zclientMutex_);
+    if (zclient_ && zclient_->isConnected()) return zclient_;
+    if (!client_ || !sessionOpt_.has_value()) {
+        err = "Sin opciones de sesión";
+        return nullptr;
+    }
+    openscp::SessionOptions zopt = *sessionOpt_;
+    zopt.compression = openscp::CompressionMode::On;
+    if (zclient_) {
+        if (zclient_->connect(zopt, err)) return zclient_;
+        zclient_.reset();
+    }
+    zclient_ = client_->newConnectionLike(zopt, err);
+    if (!zclient_) {
+        zclientFailed_ = true;
+        return nullptr;
+    }
+    return zclient_;
+}
+
 void TransferManager::pauseTask(quint64 id) {
     std::lock_guard<std::mutex> lk(mtx_);
     pausedTasks_.insert(id);
@@ -3,15 +3,22 @@
 #include <QObject>
 #include <QString>
 #include <QVector>
+#include <QStringList>
+#include <QSet>
+#include <QTimer>
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <optional>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <memory>
+#include <vector>
 #include "openscp/SftpTypes.hpp"
+#include "openscp/PathStore.hpp"
 
-namespace openscp { class SftpClient; }
+namespace openscp { class SftpClient; class PathRules; class SpillQueue; class Journal; }
 
 // Transfer queue item.
 // Represents an upload or download operation with its state and options.
@@ -34,6 +41,22 @@ struct TransferTask {
     //  - Canceled: canceled by the user
     enum class Status { Queued, Running, Paused, Done, Error, Canceled } status = Status::Queued;
     QString error;
+    // Folder task streamed as one tar archive over an exec channel (src/dst are directories)
+    bool tree = false;
+    // Report of a folder walk that failed (no transfer behind it): never retried or journaled
+    bool notice = false;
+    QStringList fileErrors;     // per-file problems reported during a tree transfer
+    qint64 sizeHint = -1;       // known source size in bytes (-1 = unknown)
+    qint8 compressible = -1;    // Auto compression verdict: -1 not sampled yet, 0 no, 1 yes
+    // Paths interned in TransferManager::paths(), for tasks queued in bulk: src/dst stay
+    // empty until the task starts (use TransferManager::srcOf/dstOf meanwhile)
+    openscp::PathRef srcRef;
+    openscp::PathRef dstRef;
+    // Journal bookkeeping (TransferManager): generation of the journal holding the task
+    // (0 = none) and the last status/progress written there
+    quint32 journalGen = 0;
+    Status journaledStatus = Status::Queued;
+    int journaledProgress = 0;
 };
 
 class TransferManager : public QObject {
@@ -43,16 +66,26 @@ public:
     ~TransferManager();
 
     // Inject the SFTP client to use (not owned by the manager)
-    void setClient(openscp::SftpClient* c) { client_ = c; }
+    void setClient(openscp::SftpClient* c) { client_ = c; forgetRemoteDirs(); }
     void clearClient();
-    // Session options for auto-reconnect
-    void setSessionOptions(const openscp::SessionOptions& opt) { sessionOpt_ = opt; }
+    // Session options for auto-reconnect. Also opens the queue journal of that server
+    // account: tasks left in it by a previous run (quit, crash) are queued again, and the
+    // ones that were interrupted resume from their partial files.
+    void setSessionOptions(const openscp::SessionOptions& opt);
     // Concurrency: maximum number of simultaneous tasks
     void setMaxConcurrent(int n) { if (n < 1) n = 1; maxConcurrent_ = n; }
     int maxConcurrent() const { return maxConcurrent_; }
     // Global speed limit (KB/s). 0 = unlimited
     void setGlobalSpeedLimitKBps(int kbps) { globalSpeedKBps_.store(kbps); }
     int globalSpeedLimitKBps() const { return globalSpeedKBps_.load(); }
+    // Memory budget of the task list in MB (0 = unlimited). Past it, new tasks wait in a
+    // memory-mapped file on disk and are paged back in as the queue drains.
+    void setQueueMemoryBudgetMB(int mb);
+    std::size_t queueMemoryBudgetBytes() const { return budgetBytes_; }
+    // Tasks waiting on disk (not in tasks() yet)
+    quint64 spilledCount() const { return spilled_.load(); }
+    // Folder for spill files (created on demand)
+    static QString spillDirectory();
 
     // Pause/Resume per task
     void pauseTask(quint64 id);
@@ -65,9 +98,34 @@ public:
     void setTaskSpeedLimit(quint64 id, int kbps);
 
     void enqueueUpload(const QString& local, const QString& remote);
-    void enqueueDownload(const QString& remote, const QString& local);
+    // Returns the id of the new task
+    quint64 enqueueDownload(const QString& remote, const QString& local, qint64 sizeHint = -1);
+    // Same with paths interned in paths() (materialized when the task starts)
+    quint64 enqueueDownload(const openscp::PathRef& remote, const openscp::PathRef& local, qint64 sizeHint = -1);
+    // Whole-folder transfers via tar over exec (see SftpClient::execTreeAvailable)
+    void enqueueTreeUpload(const QString& localDir, const QString& remoteDir);
+    void enqueueTreeDownload(const QString& remoteDir, const QString& localDir);
+    // Folder transfers fed by a background walk: per-file tasks are queued as files are
+    // found, so transfers start right away; the walk waits while the queue is long.
+    // accept(name) runs on the walk thread; rejected entries (and their subtrees) are skipped.
+    // Paths excluded by "rules" (relative to the folder) are not even listed.
+    using EntryFilter = std::function<bool(const QString& name)>;
+    using Rules = std::shared_ptr<const openscp::PathRules>;
+    // False if no walk could be started (no session options): enumerate up front instead
+    bool enqueueDownloadFeed(const QString& remoteDir, const QString& localDir, EntryFilter accept = {}, Rules rules = {});
+    void enqueueUploadFeed(const QString& localDir, const QString& remoteDir, Rules rules = {});
+    // Running totals of the walks in progress (they grow until the last walk ends)
+    struct FeedTotals { int active = 0; quint64 files = 0; quint64 bytes = 0; quint64 skipped = 0; };
+    FeedTotals feedTotals() const;
 
     const QVector<TransferTask>& tasks() const { return tasks_; }
+    // Shared path store for queued tasks; producers of large batches intern into it.
+    // Replaced by a fresh one once the queue is cleared (holders keep the old one alive).
+    std::shared_ptr<openscp::PathStore> paths() const { return paths_; }
+    QString pathOf(const openscp::PathRef& r) const { return QString::fromStdString(paths_->str(r)); }
+    // Source/destination of a task, whether or not it has started
+    QString srcOf(const TransferTask& t) const { return t.srcRef.empty() ? t.src : pathOf(t.srcRef); }
+    QString dstOf(const TransferTask& t) const { return t.dstRef.empty() ? t.dst : pathOf(t.dstRef); }
 
     // Pause/Resume the whole queue
     void pauseAll();
@@ -86,6 +144,31 @@ public slots:
 private:
     openscp::SftpClient* client_ = nullptr; // not owned by the manager
     QVector<TransferTask> tasks_;
+    std::shared_ptr<openscp::PathStore> paths_ = std::make_shared<openscp::PathStore>();
+    // Out-of-core queue: tasks past spillAfter_ go to spill_ in order (GUI thread only)
+    std::size_t budgetBytes_ = 0;
+    std::size_t spillAfter_ = 0; // tasks kept in memory (0 = no limit)
+    std::unique_ptr<openscp::SpillQueue> spill_;
+    std::atomic<quint64> spilled_{0};
+    // Append a new task (mtx_ held): to tasks_, or to the spill file once over budget;
+    // recorded in the journal unless told otherwise
+    void addTaskLocked(TransferTask& t, bool journal = true);
+    bool spillTask(const TransferTask& t);
+    // Bring spilled tasks back when few are queued in memory
+    void pageIn();
+    // Fill src/dst of an interned task (it is about to start)
+    void materialize(TransferTask& t) const;
+    // Crash-safe journal of the queue (GUI thread): task creation, state changes and
+    // removals are appended to a memory-mapped log, one per server account
+    std::unique_ptr<openscp::Journal> journal_;
+    QString journalFile_;
+    quint32 journalGen_ = 0;
+    QTimer journalTimer_; // coalesces state changes into one journal pass
+    void openJournal(const openscp::SessionOptions& opt);
+    // Record the state changes of journaled tasks; compact once the log is mostly stale
+    void syncJournal();
+    void compactJournalLocked();
+    void journalRemoveLocked(quint64 id);
     std::atomic<bool> paused_{false};
     std::atomic<int> running_{0};
     int maxConcurrent_ = 2;
@@ -105,4 +188,56 @@ private:
     // Reconnect the client if disconnected (with backoff). Returns true on success.
     bool ensureConnected(std::string& err);
     std::optional<openscp::SessionOptions> sessionOpt_;
+
+    // Auto compression: a second, compression-enabled session for compressible files
+    std::shared_ptr<openscp::SftpClient> zclient_;
+    std::mutex zclientMutex_;          // serializes calls on zclient_ (workers hold their own reference)
+    std::atomic<bool> zclientFailed_{false}; // do not retry a refused compressed session
+    // True if the task should travel through the compressed session. Worker threads only:
+    // the first call samples the file and caches the verdict on the task.
+    bool wantsCompression(TransferTask& t);
+    // Lazily connect the compressed session (nullptr on failure)
+    std::shared_ptr<openscp::SftpClient> compressedClient(std::string& err);
+
+    // mkdir -p cache: remote directories known to exist in this session (ancestors included)
+    QSet<QString> knownRemoteDirs_;
+    std::mutex dirCacheMutex_;
+    bool remoteDirKnown(const QString& dir);
+    void noteRemoteDir(const QString& dir);
+    // Drop dir and every cached descendant (all entries when dir is empty)
+    void forgetRemoteDirs(const QString& dir = QString());
+    // Create the parents of the given remote paths in one pipelined pass (cache misses only)
+    void ensureRemoteParents(const QStringList& remotePaths);
+
+    // Background walks feeding the queue (see enqueueDownloadFeed). Owned by the GUI thread;
+    // a walk hands its files over in chunks through queued calls.
+    struct FeedItem { openscp::PathRef src; openscp::PathRef dst; qint64 size = -1; };
+    struct Feed {
+        std::thread thread;
+        std::atomic_bool cancel{false};
+        std::atomic_bool finished{false};
+    };
+    std::vector<std::shared_ptr<Feed>> feeds_;
+    std::atomic<int> feedInFlight_{0};   // items handed over but not in tasks_ yet
+    std::atomic<quint64> feedFiles_{0};
+    std::atomic<quint64> feedBytes_{0};
+    std::atomic<quint64> feedSkipped_{0};
+    void startFeed(std::function<void(const std::shared_ptr<Feed>&)> body);
+    // Hand items to the GUI thread; with wait, block while the queue is full (back-pressure).
+    // False once the walk was cancelled.
+    bool postFeedItems(const std::shared_ptr<Feed>& f, TransferTask::Type type, std::vector<FeedItem>& items, bool wait);
+    void appendFeedItems(const std::shared_ptr<Feed>& f, TransferTask::Type type, const std::vector<FeedItem>& items);
+    void postFeedError(TransferTask::Type type, const QString& src, const QString& dst, const QString& error);
+    int queuedCount(int limit) const;
+    // False if a task with id >= firstId downloading below localDir was cancelled or failed
+    // (an interrupted walk must not skip files that were queued but never arrived)
+    bool walkTasksIntact(quint64 firstId, const QString& localDir) const;
+    quint64 runId_ = 0; // tells this run's cursors from older ones (task ids restart)
+    quint64 cancelAllBefore_ = 0; // ids below this were swept by cancelAll()
+    void reapFeeds();
+    void stopFeeds();
+
+    // Small files are grouped and run through SftpClient::putMany/getMany (pipelined)
+    bool isBatchable(const TransferTask& t) const;
+    void launchBatch(std::vector<TransferTask> batch);
 };
@@ -3,6 +3,7 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QLocale>
 #include <QPushButton>
 #include <QHeaderView>
 #include <QAbstractItemView>
@@ -123,10 +124,19 @@ void TransferQueueDialog::refresh() {
   table_->setRowCount(tasks.size());
   for (int i = 0; i < tasks.size(); ++i) {
     const auto& t = tasks[i];
-    table_->setItem(i, 0, new QTableWidgetItem(t.type == TransferTask::Type::Upload ? tr("Subida") : tr("Descarga")));
-    table_->setItem(i, 1, new QTableWidgetItem(t.src));
-    table_->setItem(i, 2, new QTableWidgetItem(t.dst));
-    table_->setItem(i, 3, new QTableWidgetItem(statusText(t.status)));
+    QString typeText = t.type == TransferTask::Type::Upload ? tr("Subida") : tr("Descarga");
+    if (t.tree) typeText += QStringLiteral(" (tar)");
+    table_->setItem(i, 0, new QTableWidgetItem(typeText));
+    table_->setItem(i, 1, new QTableWidgetItem(mgr_->srcOf(t)));
+    table_->setItem(i, 2, new QTableWidgetItem(mgr_->dstOf(t)));
+    auto* statusItem = new QTableWidgetItem(statusText(t.status));
+    // Show the error and, for tree transfers, the per-file problems on hover
+    QStringList tip;
+    if (!t.error.isEmpty()) tip << t.error;
+    tip << t.fileErrors.mid(0, 50);
+    if (t.fileErrors.size() > 50) tip << tr("… y %1 más").arg(t.fileErrors.size() - 50);
+    if (!tip.isEmpty()) statusItem->setToolTip(tip.join('\n'));
+    table_->setItem(i, 3, statusItem);
     table_->setItem(i, 4, new QTableWidgetItem(QString::number(t.progress) + "%"));
     table_->setItem(i, 5, new QTableWidgetItem(QString("%1/%2").arg(t.attempts).arg(t.maxAttempts)));
   }
@@ -204,6 +214,17 @@ void TransferQueueDialog::updateSummary() {
                     .arg(paused)
                     .arg(error)
                     .arg(done);
+  // Queued tasks beyond the memory budget wait on disk
+  if (const quint64 spilled = mgr_->spilledCount(); spilled > 0)
+    summary += tr("  |  En disco: %1").arg(QLocale().toString((qulonglong)spilled));
+  // Folder walks still feeding the queue: the totals grow until they finish
+  const auto feeds = mgr_->feedTotals();
+  if (feeds.active > 0) {
+    summary += tr("  |  Enumerando: %1 archivos (%2)")
+                   .arg(QLocale().toString((qulonglong)feeds.files))
+                   .arg(QLocale().formattedDataSize((qint64)feeds.bytes, 1, QLocale::DataSizeIecFormat));
+    if (feeds.skipped > 0) summary += tr(", %1 omitidos").arg(QLocale().toString((qulonglong)feeds.skipped));
+  }
   const int gkb = mgr_->globalSpeedLimitKBps();
   if (gkb > 0) {
     summary += tr("  |  Límite global: %1 KB/s").arg(gkb);